@@ -0,0 +1,98 @@
+#ifndef SOREN_COLLISIONS_SOREN_AABB_TREE_H
+#define SOREN_COLLISIONS_SOREN_AABB_TREE_H
+
+#include "soren_colliders.h"
+#include "soren_spatial_hash.h"
+
+// A dynamic bounding volume tree. Each collider is stored in a leaf with its
+// bounds fattened by a margin, so small movements don't need to touch the tree.
+// Unlike the spatial hash, every collider is stored exactly once regardless of
+// its size, making it a better fit for scenes with mixed collider sizes.
+
+typedef struct AabbTree AabbTree;
+
+// Collection functions
+
+SOREN_EXPORT AabbTree* aabb_tree_create(float margin);
+SOREN_EXPORT void aabb_tree_free(AabbTree* tree);
+
+SOREN_EXPORT void aabb_tree_add(AabbTree* tree, Collider* collider);
+SOREN_EXPORT void aabb_tree_remove(AabbTree* tree, Collider* collider);
+SOREN_EXPORT void aabb_tree_clear(AabbTree* tree);
+
+SOREN_EXPORT int aabb_tree_count(AabbTree* tree);
+SOREN_EXPORT int aabb_tree_height(AabbTree* tree);
+
+// Movement functions
+
+SOREN_EXPORT void aabb_tree_update(AabbTree* tree, Collider* collider);
+
+SOREN_EXPORT void aabb_tree_move(AabbTree* tree, Collider* collider, Vector delta);
+SOREN_EXPORT void aabb_tree_set_position(AabbTree* tree, Collider* collider, Vector position);
+
+SOREN_EXPORT void aabb_tree_rotate(AabbTree* tree, Collider* collider, float delta_rotation);
+SOREN_EXPORT void aabb_tree_set_rotation(AabbTree* tree, Collider* collider, float rotation);
+
+// Collision checking
+
+SOREN_EXPORT ColliderCollection* aabb_tree_all(AabbTree* tree, ColliderCollection* results);
+SOREN_EXPORT ColliderCollection* aabb_tree_all_ext(AabbTree* tree, ColliderCollection* results, void* ctx, ColliderPredicate predicate);
+
+SOREN_EXPORT ColliderCollection* aabb_tree_broadphase_vector(AabbTree* tree, Vector position, ColliderCollection* results);
+SOREN_EXPORT ColliderCollection* aabb_tree_broadphase_rectf(AabbTree* tree, RectF rect, ColliderCollection* results);
+SOREN_EXPORT ColliderCollection* aabb_tree_broadphase_collider(AabbTree* tree, Collider* collider, ColliderCollection* results);
+
+SOREN_EXPORT bool aabb_tree_collides_vector(AabbTree* tree, Vector position);
+SOREN_EXPORT bool aabb_tree_collides_vector_ext(AabbTree* tree, Vector position, void* ctx, ColliderVectorTest test);
+
+SOREN_EXPORT bool aabb_tree_collides_rectf(AabbTree* tree, RectF bounds);
+SOREN_EXPORT bool aabb_tree_collides_rectf_ext(AabbTree* tree, RectF bounds, void* ctx, ColliderRectFTest test);
+
+SOREN_EXPORT bool aabb_tree_collides_collider(AabbTree* tree, Collider* collider);
+SOREN_EXPORT bool aabb_tree_collides_collider_ext(AabbTree* tree, Collider* collider, void* ctx, ColliderColliderTest test);
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_vector(AabbTree* tree, ColliderCollection* results, Vector position);
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_vector_ext(AabbTree* tree, ColliderCollection* results, Vector position, void* ctx, ColliderVectorTest test);
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_rectf(AabbTree* tree, ColliderCollection* results, RectF bounds);
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_rectf_ext(AabbTree* tree, ColliderCollection* results, RectF bounds, void* ctx, ColliderRectFTest test);
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_collider(AabbTree* tree, ColliderCollection* results, Collider* collider);
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_collider_ext(AabbTree* tree, ColliderCollection* results, Collider* collider, void* ctx, ColliderColliderTest test);
+
+SOREN_EXPORT Collider* aabb_tree_first_vector(AabbTree* tree, Vector position);
+SOREN_EXPORT Collider* aabb_tree_first_vector_ext(AabbTree* tree, Vector position, void* ctx, ColliderVectorTest test);
+
+SOREN_EXPORT Collider* aabb_tree_first_rectf(AabbTree* tree, RectF bounds);
+SOREN_EXPORT Collider* aabb_tree_first_rectf_ext(AabbTree* tree, RectF bounds, void* ctx, ColliderRectFTest test);
+
+SOREN_EXPORT Collider* aabb_tree_first_collider(AabbTree* tree, Collider* collider);
+SOREN_EXPORT Collider* aabb_tree_first_collider_ext(AabbTree* tree, Collider* collider, void* ctx, ColliderColliderTest test);
+
+SOREN_EXPORT Collider* aabb_tree_raycast(AabbTree* tree, Vector origin, Vector direction, float distance, RaycastHit* out_hit);
+SOREN_EXPORT Collider* aabb_tree_linecast_first(AabbTree* tree, Vector start, Vector end, RaycastHit* out_hit);
+SOREN_EXPORT ColliderCollection* aabb_tree_linecast_all(AabbTree* tree, ColliderCollection* results, Vector start, Vector end);
+
+SOREN_EXPORT Collider* aabb_tree_cast_collider(AabbTree* tree, Collider* collider, Vector delta, RaycastHit* out_hit);
+
+SOREN_EXPORT Collider* aabb_tree_nearest(AabbTree* tree, Vector point, float max_distance, void* ctx, ColliderPredicate predicate);
+SOREN_EXPORT int aabb_tree_k_nearest(
+    AabbTree* tree,
+    Vector point,
+    float max_distance,
+    int k,
+    Collider** out_colliders,
+    float* out_distances,
+    void* ctx,
+    ColliderPredicate predicate);
+
+SOREN_EXPORT bool aabb_tree_for_each_broadphase_rectf(AabbTree* tree, RectF rect, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool aabb_tree_for_each_vector(AabbTree* tree, Vector position, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool aabb_tree_for_each_rectf(AabbTree* tree, RectF bounds, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool aabb_tree_for_each_collider(AabbTree* tree, Collider* collider, void* ctx, ColliderVisitor visitor);
+
+// Adds every unique pair of colliders whose fat bounds overlap to the pairs list.
+// If narrowphase is true, only pairs that actually overlap are added.
+SOREN_EXPORT void aabb_tree_find_pairs(AabbTree* tree, ColliderPairList* pairs, bool narrowphase);
+
+#endif
@@ -16,13 +16,27 @@ typedef enum ColliderType {
     COLLIDER_CIRCLE,
     COLLIDER_BOX,
     COLLIDER_POLYGON,
-    // COLLIDER_CAPSULE
+    COLLIDER_CAPSULE
 } ColliderType;
 
+#define COLLIDER_CATEGORY_DEFAULT 1u
+#define COLLIDER_MASK_ALL 0xFFFFFFFFu
+
 typedef struct Collider {
     ColliderType collider_type;
     void* tag;
     int id;
+    // The layers the collider belongs to.
+    uint32_t category;
+    // The layers the collider can collide with.
+    uint32_t mask;
+    // The last broadphase query that visited the collider. Used to skip
+    // colliders that cover several cells without a set.
+    uint64_t query_epoch;
+    // The world-space bounds of the collider. Only valid while bounds_dirty is false.
+    // Every setter that moves or reshapes the collider marks them as dirty.
+    RectF bounds;
+    bool bounds_dirty;
 } Collider;
 
 typedef struct CircleCollider {
@@ -35,15 +49,24 @@ typedef struct CircleCollider {
 typedef struct PolygonCollider {
     Collider base;
     RectF bounding_box;
+    // The distance from the origin of the points to the furthest point, updated with the points.
+    float bounding_radius;
     Vector* edge_normals;
     Vector* points;
     Vector* original_points;
+    // The unique separating axes of the polygon. Parallel edges share a single axis.
+    // The original axes are in local space, and are only rotated when the rotation changes.
+    Vector* axes;
+    Vector* original_axes;
     Vector position;
     Vector original_center;
     float scale;
     float rotation;
+    float axes_rotation;
     int points_count;
+    int axes_count;
     bool dirty;
+    bool axes_dirty;
 } PolygonCollider;
 
 typedef struct BoxCollider {
@@ -74,10 +97,30 @@ typedef struct LineCollider {
     bool dirty;
 } LineCollider;
 
+// A segment with a radius around it. The segment is vertical when the rotation is 0.
+typedef struct CapsuleCollider {
+    Collider base;
+    Vector position;
+    // The direction from the start of the segment to the end of it.
+    // Updated with the rotation so the collision tests don't need to call sinf and cosf.
+    Vector axis;
+    float radius;
+    // The height of the capsule including the caps.
+    float height;
+    float rotation;
+    float scale;
+} CapsuleCollider;
+
 typedef struct CollisionResult CollisionResult;
 typedef struct RaycastHit RaycastHit;
 
 SOREN_EXPORT void collider_init(Collider* collider, ColliderType type);
+
+// Two colliders can only collide if each one's category is in the other's mask.
+// Used by the broadphases to skip pairs before running any collision tests.
+static inline bool collider_should_collide(Collider* collider, Collider* other) {
+    return (collider->category & other->mask) != 0 && (other->category & collider->mask) != 0;
+}
 SOREN_EXPORT void collider_free_resources(Collider* collider);
 SOREN_EXPORT void collider_free(Collider* collider);
 
@@ -102,6 +145,19 @@ SOREN_EXPORT bool collider_collides_collider_impl(Collider* collider, Collider*
 SOREN_EXPORT bool collider_collides_line_impl(Collider* collider, Vector start, Vector end, RaycastHit* out_result);
 SOREN_EXPORT bool collider_collides_point_impl(Collider* collider, Vector point, CollisionResult* out_result);
 
+// Gets the distance between the closest points of the colliders, or 0 if they overlap.
+SOREN_EXPORT float collider_distance_impl(Collider* collider, Collider* other);
+
+// Updates everything a collider computes lazily, such as the points and axes of polygons and
+// the bounds of every collider. The lazy updates aren't safe to run from several threads at
+// once and put sinf and cosf in the middle of the collision tests, so call this at a fixed
+// point in the frame, such as right before the narrowphase.
+SOREN_EXPORT void collider_clean_impl(Collider* collider);
+
+// Cleans every collider in the array. A collider is only touched by the call it's passed to,
+// so separate ranges of an array of unique colliders can be cleaned on different threads.
+SOREN_EXPORT void collider_clean_batch(Collider** colliders, int count);
+
 SOREN_EXPORT CircleCollider* circle_collider_create(float radius);
 SOREN_EXPORT void circle_collider_init(CircleCollider* circle, float radius);
 
@@ -131,6 +187,44 @@ SOREN_EXPORT bool circle_collider_collides_collider(CircleCollider* collider, Co
 SOREN_EXPORT bool circle_collider_collides_line(CircleCollider* collider, Vector start, Vector end, RaycastHit* out_result);
 SOREN_EXPORT bool circle_collider_collides_point(CircleCollider* collider, Vector point, CollisionResult* out_result);
 
+SOREN_EXPORT CapsuleCollider* capsule_collider_create(float radius, float height);
+SOREN_EXPORT void capsule_collider_init(CapsuleCollider* capsule, float radius, float height);
+
+SOREN_EXPORT float capsule_collider_rotation(CapsuleCollider* capsule);
+SOREN_EXPORT void capsule_collider_set_rotation(CapsuleCollider* capsule, float rotation);
+
+SOREN_EXPORT float capsule_collider_scale(CapsuleCollider* capsule);
+SOREN_EXPORT void capsule_collider_set_scale(CapsuleCollider* capsule, float scale);
+
+SOREN_EXPORT Vector capsule_collider_position(CapsuleCollider* capsule);
+SOREN_EXPORT void capsule_collider_set_position(CapsuleCollider* capsule, Vector position);
+
+SOREN_EXPORT RectF capsule_collider_bounds(CapsuleCollider* capsule);
+SOREN_EXPORT void capsule_collider_debug_draw(CapsuleCollider* collider, SDL_Renderer* renderer, SDL_FColor color);
+
+SOREN_EXPORT float capsule_collider_radius(CapsuleCollider* capsule);
+
+SOREN_EXPORT float capsule_collider_original_radius(CapsuleCollider* capsule);
+SOREN_EXPORT void capsule_collider_set_original_radius(CapsuleCollider* capsule, float value);
+
+SOREN_EXPORT float capsule_collider_height(CapsuleCollider* capsule);
+
+SOREN_EXPORT float capsule_collider_original_height(CapsuleCollider* capsule);
+SOREN_EXPORT void capsule_collider_set_original_height(CapsuleCollider* capsule, float value);
+
+// Gets the centers of the caps in world space, which are the ends of the segment the capsule is built around.
+SOREN_EXPORT Vector capsule_collider_start(CapsuleCollider* capsule);
+SOREN_EXPORT Vector capsule_collider_end(CapsuleCollider* capsule);
+
+SOREN_EXPORT bool capsule_collider_overlaps_rect(CapsuleCollider* collider, RectF rect);
+SOREN_EXPORT bool capsule_collider_overlaps_collider(CapsuleCollider* collider, Collider* other);
+SOREN_EXPORT bool capsule_collider_overlaps_line(CapsuleCollider* collider, Vector start, Vector end);
+SOREN_EXPORT bool capsule_collider_contains_point(CapsuleCollider* collider, Vector point);
+SOREN_EXPORT bool capsule_collider_collides_rect(CapsuleCollider* collider, RectF rect, CollisionResult* out_result);
+SOREN_EXPORT bool capsule_collider_collides_collider(CapsuleCollider* collider, Collider* other, CollisionResult* out_result, RaycastHit* out_hit);
+SOREN_EXPORT bool capsule_collider_collides_line(CapsuleCollider* collider, Vector start, Vector end, RaycastHit* out_result);
+SOREN_EXPORT bool capsule_collider_collides_point(CapsuleCollider* collider, Vector point, CollisionResult* out_result);
+
 SOREN_EXPORT PolygonCollider* polygon_collider_create(Vector* points, int count);
 SOREN_EXPORT void polygon_collider_init(PolygonCollider* polygon, Vector* points, int count);
 
@@ -155,6 +249,17 @@ SOREN_EXPORT void polygon_collider_debug_draw(PolygonCollider* collider, SDL_Ren
 
 SOREN_EXPORT Vector* polygon_collider_edge_normals(PolygonCollider* polygon, int* out_count);
 
+// Gets the edge normals of the polygon without any parallel duplicates.
+// These are the only axes that need to be tested by the separating axis test.
+// The axes are rotated lazily, which writes to the polygon, so call polygon_collider_clean
+// before reading them from several threads at once.
+SOREN_EXPORT Vector* polygon_collider_axes(PolygonCollider* polygon, int* out_count);
+
+// Updates the points, edge normals, axes, and bounds of the polygon if it has changed. The sine
+// and cosine of the rotation are only computed once for all of them.
+SOREN_EXPORT void polygon_collider_clean(PolygonCollider* polygon);
+SOREN_EXPORT void polygon_collider_clean_batch(PolygonCollider** polygons, int count);
+
 SOREN_EXPORT bool polygon_collider_overlaps_rect(PolygonCollider* collider, RectF rect);
 SOREN_EXPORT bool polygon_collider_overlaps_collider(PolygonCollider* collider, Collider* other);
 SOREN_EXPORT bool polygon_collider_overlaps_line(PolygonCollider* collider, Vector start, Vector end);
@@ -284,6 +389,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         LineCollider*: line_collider_rotation, \
         PolygonCollider*: polygon_collider_rotation, \
         CircleCollider*: circle_collider_rotation, \
+        CapsuleCollider*: capsule_collider_rotation, \
         BoxCollider*: box_collider_rotation \
     )(collider)
 
@@ -293,6 +399,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: point_collider_set_rotation, \
         LineCollider*: line_collider_set_rotation, \
         CircleCollider*: circle_collider_set_rotation, \
+        CapsuleCollider*: capsule_collider_set_rotation, \
         PolygonCollider*: polygon_collider_set_rotation, \
         BoxCollider*: box_collider_set_rotation \
     )((collider), (rotation))
@@ -303,6 +410,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: point_collider_scale, \
         LineCollider*: line_collider_scale, \
         CircleCollider*: circle_collider_scale, \
+        CapsuleCollider*: capsule_collider_scale, \
         PolygonCollider*: polygon_collider_scale, \
         BoxCollider*: box_collider_scale \
     )(collider)
@@ -313,6 +421,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: point_collider_set_scale, \
         LineCollider*: line_collider_set_scale, \
         CircleCollider*: circle_collider_set_scale, \
+        CapsuleCollider*: capsule_collider_set_scale, \
         PolygonCollider*: polygon_collider_set_scale, \
         BoxCollider*: box_collider_set_scale \
     )((collider), (scale))
@@ -323,6 +432,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: point_collider_position, \
         LineCollider*: line_collider_position, \
         CircleCollider*: circle_collider_position, \
+        CapsuleCollider*: capsule_collider_position, \
         PolygonCollider*: polygon_collider_position, \
         BoxCollider*: box_collider_position \
     )(collider)
@@ -333,6 +443,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: point_collider_set_position, \
         LineCollider*: line_collider_set_position, \
         CircleCollider*: circle_collider_set_position, \
+        CapsuleCollider*: capsule_collider_set_position, \
         PolygonCollider*: polygon_collider_set_position, \
         BoxCollider*: box_collider_set_position \
     )((collider), (position))
@@ -343,6 +454,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: point_collider_bounds, \
         LineCollider*: line_collider_bounds, \
         CircleCollider*: circle_collider_bounds, \
+        CapsuleCollider*: capsule_collider_bounds, \
         PolygonCollider*: polygon_collider_bounds, \
         BoxCollider*: box_collider_bounds \
     )(collider)
@@ -375,6 +487,29 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
 #define circle_collider_collides(collider, arg1, arg2, ...) \
     soren_circle_collider_collides_impl_selector(arg1, arg2)((collider), (arg1), (arg2) __VA_OPT__(,) __VA_ARGS__)
 
+#define SOREN_CAPSULE_COLLIDER_OVERLAPS_CHOOSER(...) \
+    SOREN_COLLIDER_OVERLAPS_GET_FIRST_ARG(__VA_OPT__(capsule_collider_overlaps_line,) capsule_collider_contains_point)
+
+#define soren_capsule_collider_overlaps_impl_selector(arg1, ...) \
+    _Generic((arg1), \
+        Collider*: capsule_collider_overlaps_collider, \
+        RectF: capsule_collider_overlaps_rect, \
+        Vector: SOREN_CAPSULE_COLLIDER_OVERLAPS_CHOOSER(__VA_ARGS__))
+
+#define capsule_collider_overlaps(collider, arg1, ...) \
+    soren_capsule_collider_overlaps_impl_selector((arg1) __VA_OPT__(,) __VA_ARGS__)((collider), (arg1) __VA_OPT__(,) __VA_ARGS__)
+
+#define soren_capsule_collider_collides_impl_selector(arg1, arg2) \
+    _Generic((arg1), \
+        Collider*: capsule_collider_collides_collider, \
+        RectF: capsule_collider_collides_rect, \
+        Vector: _Generic((arg2), \
+            Vector: capsule_collider_collides_line, \
+            default: capsule_collider_collides_point))
+
+#define capsule_collider_collides(collider, arg1, arg2, ...) \
+    soren_capsule_collider_collides_impl_selector(arg1, arg2)((collider), (arg1), (arg2) __VA_OPT__(,) __VA_ARGS__)
+
 #define SOREN_BOX_COLLIDER_OVERLAPS_CHOOSER(...) \
     SOREN_COLLIDER_OVERLAPS_GET_FIRST_ARG(__VA_OPT__(box_collider_overlaps_line,) box_collider_contains_point)
 
@@ -496,6 +631,7 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: soren_point_collider_overlaps_impl_selector(arg1 __VA_OPT__(,) __VA_ARGS__), \
         LineCollider*: soren_line_collider_overlaps_impl_selector(arg1 __VA_OPT__(,) __VA_ARGS__), \
         CircleCollider*: soren_circle_collider_overlaps_impl_selector(arg1 __VA_OPT__(,) __VA_ARGS__), \
+        CapsuleCollider*: soren_capsule_collider_overlaps_impl_selector(arg1 __VA_OPT__(,) __VA_ARGS__), \
         PolygonCollider*: soren_polygon_collider_overlaps_impl_selector(arg1 __VA_OPT__(,) __VA_ARGS__), \
         BoxCollider*: soren_box_collider_overlaps_impl_selector(arg1 __VA_OPT__(,) __VA_ARGS__) \
     )((collider), (arg1) __VA_OPT__(,) __VA_ARGS__)
@@ -506,16 +642,24 @@ static inline bool point_collider_using_internal_collider(PointCollider* point)
         PointCollider*: soren_point_collider_collides_impl_selector(arg1, arg2), \
         LineCollider*: soren_line_collider_collides_impl_selector(arg1, arg2), \
         CircleCollider*: soren_circle_collider_collides_impl_selector(arg1, arg2), \
+        CapsuleCollider*: soren_capsule_collider_collides_impl_selector(arg1, arg2), \
         PolygonCollider*: soren_polygon_collider_collides_impl_selector(arg1, arg2), \
         BoxCollider*: soren_box_collider_collides_impl_selector(arg1, arg2) \
     )((collider), (arg1), (arg2) __VA_OPT__(,) __VA_ARGS__)
 
+#define collider_distance(collider, other) \
+    collider_distance_impl((Collider*)(collider), (Collider*)(other))
+
+#define collider_clean(collider) \
+    collider_clean_impl((Collider*)(collider))
+
 #define collider_debug_draw(collider, renderer, color) \
     _Generic((collider), \
         Collider*: collider_debug_draw_impl, \
         PointCollider*: point_collider_debug_draw, \
         LineCollider*: line_collider_debug_draw, \
         CircleCollider*: circle_collider_debug_draw, \
+        CapsuleCollider*: capsule_collider_debug_draw, \
         PolygonCollider*: polygon_collider_debug_draw, \
         BoxCollider*: box_collider_debug_draw \
     )((collider), (renderer), (color))
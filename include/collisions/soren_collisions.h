@@ -52,6 +52,21 @@ SOREN_EXPORT bool collision_radius_to_polygon_ext(Vector position, float radius,
 SOREN_EXPORT bool collision_radius_to_shape(Vector position, float radius, Vector* points, int points_count, Vector shape_position);
 SOREN_EXPORT bool collision_radius_to_shape_ext(Vector position, float radius, Vector* points, int points_count, Vector shape_position, CollisionResult* out_result);
 
+SOREN_EXPORT bool collision_capsule_to_circle(CapsuleCollider* first, CircleCollider* second);
+SOREN_EXPORT bool collision_capsule_to_circle_ext(CapsuleCollider* first, CircleCollider* second, CollisionResult* out_result);
+
+SOREN_EXPORT bool collision_circle_to_capsule(CircleCollider* first, CapsuleCollider* second);
+SOREN_EXPORT bool collision_circle_to_capsule_ext(CircleCollider* first, CapsuleCollider* second, CollisionResult* out_result);
+
+SOREN_EXPORT bool collision_capsule_to_capsule(CapsuleCollider* first, CapsuleCollider* second);
+SOREN_EXPORT bool collision_capsule_to_capsule_ext(CapsuleCollider* first, CapsuleCollider* second, CollisionResult* out_result);
+
+SOREN_EXPORT bool collision_capsule_to_polygon(CapsuleCollider* first, PolygonCollider* second);
+SOREN_EXPORT bool collision_capsule_to_polygon_ext(CapsuleCollider* first, PolygonCollider* second, CollisionResult* out_result);
+
+SOREN_EXPORT bool collision_capsule_to_rect(CapsuleCollider* first, RectF second);
+SOREN_EXPORT bool collision_capsule_to_rect_ext(CapsuleCollider* first, RectF second, CollisionResult* out_result);
+
 SOREN_EXPORT bool collision_polygon_to_polygon(PolygonCollider* first, PolygonCollider* second);
 SOREN_EXPORT bool collision_polygon_to_polygon_ext(PolygonCollider* first, PolygonCollider* second, CollisionResult* out_result);
 
@@ -79,6 +94,14 @@ SOREN_EXPORT bool collision_shape_to_shape_ext(
     Vector second_position,
     CollisionResult* out_result);
 
+// Polygon pairs remember the axis that separated them, or the normal of their collision,
+// and test it first the next time they're checked. Call collision_axis_cache_advance once
+// per frame, while no collisions are being checked, so unused pairs age out.
+SOREN_EXPORT void collision_axis_cache_advance(void);
+
+// Clears the cached axes of the calling thread.
+SOREN_EXPORT void collision_axis_cache_clear(void);
+
 SOREN_EXPORT bool collision_box_to_box(BoxCollider* first, BoxCollider* second);
 SOREN_EXPORT bool collision_box_to_box_ext(BoxCollider* first, BoxCollider* second, CollisionResult* out_result);
 
@@ -106,6 +129,9 @@ SOREN_EXPORT bool collision_point_to_poly_ext(Vector point, PolygonCollider* pol
 SOREN_EXPORT bool collision_point_to_shape(Vector point, Vector* points, int points_count, Vector shape_position);
 SOREN_EXPORT bool collision_point_to_shape_ext(Vector point, Vector* points, int points_count, Vector shape_position, CollisionResult* out_result);
 
+SOREN_EXPORT bool collision_point_to_capsule(Vector point, CapsuleCollider* capsule);
+SOREN_EXPORT bool collision_point_to_capsule_ext(Vector point, CapsuleCollider* capsule, CollisionResult* out_result);
+
 SOREN_EXPORT bool collision_point_to_line(Vector point, LineCollider* line);
 SOREN_EXPORT bool collision_point_to_line_ext(Vector point, LineCollider* line, CollisionResult* out_result);
 
@@ -136,6 +162,12 @@ SOREN_EXPORT bool collision_line_to_radius_ext(LineCollider* line, Vector positi
 SOREN_EXPORT bool collision_segment_to_radius(Vector start, Vector end, Vector position, float radius);
 SOREN_EXPORT bool collision_segment_to_radius_ext(Vector start, Vector end, Vector position, float radius, RaycastHit* out_result);
 
+SOREN_EXPORT bool collision_line_to_capsule(LineCollider* line, CapsuleCollider* capsule);
+SOREN_EXPORT bool collision_line_to_capsule_ext(LineCollider* line, CapsuleCollider* capsule, RaycastHit* out_result);
+
+SOREN_EXPORT bool collision_segment_to_capsule(Vector start, Vector end, CapsuleCollider* capsule);
+SOREN_EXPORT bool collision_segment_to_capsule_ext(Vector start, Vector end, CapsuleCollider* capsule, RaycastHit* out_result);
+
 SOREN_EXPORT bool collision_line_to_line(LineCollider* first, LineCollider* second);
 SOREN_EXPORT bool collision_line_to_line_ext(LineCollider* first, LineCollider* second, CollisionResult* out_result);
 
@@ -145,4 +177,10 @@ SOREN_EXPORT bool collision_line_to_segment_ext(LineCollider* line, Vector start
 SOREN_EXPORT bool collision_segment_to_segment(Vector first_start, Vector first_end, Vector second_start, Vector second_end);
 SOREN_EXPORT bool collision_segment_to_segment_ext(Vector first_start, Vector first_end, Vector second_start, Vector second_end, CollisionResult* out_result);
 
+// Moves the collider along delta and checks if it hits other, which is treated as stationary.
+// On a hit, fraction is how far along delta the collider first touches other (0 if they
+// already overlap), point is the collider's position at that time and normal is the surface
+// normal of other at the point of contact.
+SOREN_EXPORT bool collision_cast_collider(Collider* collider, Vector delta, Collider* other, RaycastHit* out_hit);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef SOREN_COLLISIONS_SOREN_GJK_H
+#define SOREN_COLLISIONS_SOREN_GJK_H
+
+#include "soren_colliders.h"
+#include "soren_collisions.h"
+
+// GJK based tests for convex colliders. Each collider is reduced to a convex set of
+// points and a radius, so circles are a single point with a radius and capsules are
+// a segment with a radius. GJK finds the closest points between the point sets, which
+// answers distance queries between separated colliders as well as overlap tests. When
+// the colliders overlap, EPA is used to find the penetration depth.
+//
+// The final simplex of each pair is cached and used as the starting simplex the next
+// time the pair is tested. Colliders don't move very far between frames, so the cached
+// simplex is usually within one or two iterations of the answer. The cache is thread
+// local, so the tests are safe to run from the narrowphase pool.
+
+typedef enum CollisionBackend {
+    COLLISION_BACKEND_SAT,
+    COLLISION_BACKEND_GJK
+} CollisionBackend;
+
+// Gets the backend used by collider_overlaps_collider_impl and collider_collides_collider_impl
+// for pairs that the GJK tests support. Defaults to COLLISION_BACKEND_SAT.
+// The backend is read atomically, but changing it while the narrowphase pool is running
+// lets a batch mix results from both backends, so set it before starting any threads.
+SOREN_EXPORT CollisionBackend collision_backend(void);
+SOREN_EXPORT void collision_set_backend(CollisionBackend backend);
+
+// Lines report a RaycastHit instead of a CollisionResult, so they always use the regular tests.
+static inline bool collision_gjk_supports(Collider* collider) {
+    return collider->collider_type == COLLIDER_CIRCLE
+        || collider->collider_type == COLLIDER_CAPSULE
+        || collider->collider_type == COLLIDER_BOX
+        || collider->collider_type == COLLIDER_POLYGON;
+}
+
+SOREN_EXPORT bool collision_gjk(Collider* first, Collider* second);
+
+// Fills out the result the same way as collision_shape_to_shape_ext, with the point
+// set to the deepest point of the second collider.
+SOREN_EXPORT bool collision_gjk_ext(Collider* first, Collider* second, CollisionResult* out_result);
+
+// Gets the distance between the closest points of the colliders, or 0 if they overlap.
+// The closest points are optional, and are set to the same point when the colliders overlap.
+SOREN_EXPORT float collision_gjk_distance(Collider* first, Collider* second, Vector* out_first_point, Vector* out_second_point);
+
+// Clears the cached simplexes of the calling thread.
+SOREN_EXPORT void collision_gjk_clear_cache(void);
+
+#endif
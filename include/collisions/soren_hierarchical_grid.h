@@ -0,0 +1,72 @@
+#ifndef SOREN_COLLISIONS_SOREN_HIERARCHICAL_GRID_H
+#define SOREN_COLLISIONS_SOREN_HIERARCHICAL_GRID_H
+
+#include "soren_colliders.h"
+#include "soren_spatial_hash.h"
+
+// A stack of loose grids where each level's cells are twice the size of the
+// level below it. Each collider is stored in a single cell, on the lowest level
+// whose cells are at least as large as its bounds, using the cell that holds the
+// center of its bounds. Adding, removing, and moving a collider only ever touches
+// one cell no matter how large it is, which makes it a good fit for scenes that
+// mix tiny colliders with huge ones.
+//
+// Colliders that are larger than the cells of the top level are kept in a
+// separate list that's checked by every query.
+
+typedef struct HierarchicalGrid HierarchicalGrid;
+
+// Collection functions
+
+// Creates a grid whose lowest level uses cells of cell_size. Each of the levels_count
+// levels doubles the cell size, so the top level uses cell_size * 2^(levels_count - 1).
+SOREN_EXPORT HierarchicalGrid* hierarchical_grid_create(float cell_size, int levels_count);
+SOREN_EXPORT void hierarchical_grid_free(HierarchicalGrid* grid);
+
+SOREN_EXPORT void hierarchical_grid_add(HierarchicalGrid* grid, Collider* collider);
+SOREN_EXPORT void hierarchical_grid_remove(HierarchicalGrid* grid, Collider* collider);
+SOREN_EXPORT void hierarchical_grid_clear(HierarchicalGrid* grid);
+
+SOREN_EXPORT int hierarchical_grid_count(HierarchicalGrid* grid);
+SOREN_EXPORT int hierarchical_grid_levels_count(HierarchicalGrid* grid);
+
+// Returns the level the collider is stored in, or -1 if it's larger than the top level.
+SOREN_EXPORT int hierarchical_grid_collider_level(HierarchicalGrid* grid, Collider* collider);
+
+// Movement functions
+
+// Moves the collider to the cell that matches its current bounds.
+// Call this after changing the collider directly.
+SOREN_EXPORT void hierarchical_grid_update(HierarchicalGrid* grid, Collider* collider);
+
+SOREN_EXPORT void hierarchical_grid_move(HierarchicalGrid* grid, Collider* collider, Vector delta);
+SOREN_EXPORT void hierarchical_grid_set_position(HierarchicalGrid* grid, Collider* collider, Vector position);
+
+// Collision checking
+
+// If results is NULL, a collection owned by the grid is cleared and returned.
+SOREN_EXPORT ColliderCollection* hierarchical_grid_broadphase_rectf(HierarchicalGrid* grid, RectF rect, ColliderCollection* results);
+SOREN_EXPORT ColliderCollection* hierarchical_grid_broadphase_collider(HierarchicalGrid* grid, Collider* collider, ColliderCollection* results);
+
+SOREN_EXPORT ColliderCollection* hierarchical_grid_collisions_vector(HierarchicalGrid* grid, ColliderCollection* results, Vector position);
+SOREN_EXPORT ColliderCollection* hierarchical_grid_collisions_rectf(HierarchicalGrid* grid, ColliderCollection* results, RectF bounds);
+SOREN_EXPORT ColliderCollection* hierarchical_grid_collisions_collider(HierarchicalGrid* grid, ColliderCollection* results, Collider* collider);
+
+// Visitor queries. These work the same way as the spatial hash visitor queries.
+// Every collider is stored once, so no colliders need to be deduplicated.
+
+// Visits every collider whose bounds overlap the rect.
+SOREN_EXPORT bool hierarchical_grid_for_each_broadphase_rectf(HierarchicalGrid* grid, RectF rect, void* ctx, ColliderVisitor visitor);
+
+SOREN_EXPORT bool hierarchical_grid_for_each_vector(HierarchicalGrid* grid, Vector position, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool hierarchical_grid_for_each_rectf(HierarchicalGrid* grid, RectF bounds, void* ctx, ColliderVisitor visitor);
+
+// Visits every collider that overlaps the collider and shares a layer with it. The collider itself is skipped.
+SOREN_EXPORT bool hierarchical_grid_for_each_collider(HierarchicalGrid* grid, Collider* collider, void* ctx, ColliderVisitor visitor);
+
+// Adds every unique pair of colliders with overlapping bounds to the pairs list.
+// If narrowphase is true, only pairs that actually overlap are added.
+// The list is not cleared first.
+SOREN_EXPORT void hierarchical_grid_find_pairs(HierarchicalGrid* grid, ColliderPairList* pairs, bool narrowphase);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SOREN_COLLISIONS_SOREN_NARROWPHASE_H
+#define SOREN_COLLISIONS_SOREN_NARROWPHASE_H
+
+#include "soren_colliders.h"
+#include "soren_collisions.h"
+#include "soren_spatial_hash.h"
+
+#include <generic_list.h>
+
+// Runs the narrowphase for a list of broadphase pairs across a pool of worker
+// threads. The pairs are split into one contiguous chunk per thread, and the
+// contacts from each chunk are appended in order, so the results are the same
+// regardless of how many threads are used.
+//
+// The colliders must not be modified while narrowphase_pool_run is executing.
+// Every collider in the pairs is cleaned on the calling thread before the workers
+// start, so the workers never update polygon points or axes lazily.
+// Exceptions can't be caught on the worker threads, so every collider needs a
+// valid collider type.
+
+typedef struct Contact {
+    Collider* first;
+    Collider* second;
+    CollisionResult result;
+    RaycastHit hit;
+} Contact;
+
+LIST_DEFINE_H(ContactList, contact_list, Contact)
+
+typedef struct NarrowphasePool NarrowphasePool;
+
+// Creates a pool that uses thread_count threads, including the calling thread.
+// If thread_count is 0 or less, one thread is used per logical CPU core.
+SOREN_EXPORT NarrowphasePool* narrowphase_pool_create(int thread_count);
+SOREN_EXPORT void narrowphase_pool_free(NarrowphasePool* pool);
+
+SOREN_EXPORT int narrowphase_pool_thread_count(NarrowphasePool* pool);
+
+// Tests every pair and appends a contact to the contacts list for each pair that collides.
+// The list is not cleared first.
+SOREN_EXPORT void narrowphase_pool_run(NarrowphasePool* pool, ColliderPairList* pairs, ContactList* contacts);
+
+// Cleans the colliders across the threads of the pool, the same as collider_clean_batch.
+// Every collider in the array must be unique. narrowphase_pool_run cleans the colliders of
+// each pair on the calling thread, so cleaning them here first keeps that step cheap.
+SOREN_EXPORT void narrowphase_pool_clean(NarrowphasePool* pool, Collider** colliders, int count);
+
+#endif
@@ -3,18 +3,62 @@
 
 #include "soren_colliders.h"
 #include <generic_hybrid_set.h>
+#include <generic_list.h>
 
 HYBRID_SET_DEFINE_H(ColliderCollection, collider_collection, Collider*)
 
+typedef struct ColliderPair {
+    Collider* first;
+    Collider* second;
+} ColliderPair;
+
+LIST_DEFINE_H(ColliderPairList, collider_pair_list, ColliderPair)
+
 typedef struct SpatialHash SpatialHash;
+typedef struct SpatialQueryContext SpatialQueryContext;
+typedef struct SpatialHashDoubleBuffer SpatialHashDoubleBuffer;
+
+#define SPATIAL_HASH_STATS_HISTOGRAM_SIZE 16
+
+// A snapshot of how the colliders are spread across the cells of a spatial hash.
+// Only the dynamic colliders are counted in the cell statistics.
+typedef struct SpatialHashStats {
+    float cell_size;
+    int colliders_count;
+    int static_colliders_count;
+    int static_cells_count;
+    int occupied_cells;
+    int max_colliders_per_cell;
+    // histogram[i] is the number of cells that hold i + 1 colliders.
+    // The last bucket also counts every cell that holds more.
+    int histogram[SPATIAL_HASH_STATS_HISTOGRAM_SIZE];
+    float average_colliders_per_cell;
+    float average_cells_per_collider;
+    // The fraction of pairs of colliders sharing a cell whose bounds don't overlap.
+    // A high rate usually means the cells are too large.
+    float false_positive_rate;
+} SpatialHashStats;
 typedef bool (*ColliderPredicate)(Collider* collider, void* ctx);
 typedef bool (*ColliderVectorTest)(Collider* collider, Vector vector, void* ctx);
 typedef bool (*ColliderColliderTest)(Collider* collider, Collider* text, void* ctx);
 typedef bool (*ColliderRectFTest)(Collider* collider, RectF rect, void* ctx);
 
+// Called for each collider found by the for_each functions. Return false to stop the query.
+typedef bool (*ColliderVisitor)(Collider* collider, void* ctx);
+
 // Collection functions
 
 SOREN_EXPORT SpatialHash* spatial_hash_create(float cell_size);
+
+// Creates a spatial hash that stores the cells covering `world` in a flat array
+// instead of a hash map. Colliders outside of the world bounds are still supported,
+// but their cells are slower to access.
+SOREN_EXPORT SpatialHash* spatial_hash_create_bounded(float cell_size, RectF world);
+
+// Creates a spatial hash backed by a dynamic AABB tree instead of cells.
+// Better suited to scenes that mix very large and very small colliders.
+// The margin is how far each collider's bounds are fattened in the tree.
+SOREN_EXPORT SpatialHash* spatial_hash_create_dynamic_tree(float margin);
 SOREN_EXPORT void spatial_hash_free(SpatialHash* hash);
 
 SOREN_EXPORT void spatial_hash_add(SpatialHash* hash, Collider* collider);
@@ -24,8 +68,57 @@ SOREN_EXPORT void spatial_hash_remove_with_brute_force(SpatialHash* hash, Collid
 
 SOREN_EXPORT void spatial_hash_clear(SpatialHash* hash);
 
+// Static colliders
+
+// Static colliders are kept in a separate tier that is stored as a sorted, flat
+// array of cells instead of a map of sets. They are included in every query,
+// aren't removed by spatial_hash_clear, and pairs of static colliders are never
+// reported by spatial_hash_find_pairs. Static colliders must not move.
+//
+// Adding or removing a static collider invalidates the tier, which is rebuilt by
+// spatial_hash_bake_static or by the next regular query that needs it. The spatial_query_*
+// functions never rebuild it, so call spatial_hash_bake_static or spatial_hash_prepare_queries
+// after changing the static colliders and before querying from several threads.
+// spatial_hash_remove also removes static colliders.
+//
+// Hashes created with spatial_hash_create_dynamic_tree treat static colliders
+// the same as dynamic ones.
+
+SOREN_EXPORT void spatial_hash_add_static(SpatialHash* hash, Collider* collider);
+SOREN_EXPORT void spatial_hash_remove_static(SpatialHash* hash, Collider* collider);
+SOREN_EXPORT void spatial_hash_clear_static(SpatialHash* hash);
+SOREN_EXPORT void spatial_hash_bake_static(SpatialHash* hash);
+
+SOREN_EXPORT int spatial_hash_static_count(SpatialHash* hash);
+SOREN_EXPORT Collider* spatial_hash_static_get(SpatialHash* hash, int index);
+
+// Baked static colliders
+
+// The static tier can be written to a binary blob that holds copies of the static colliders
+// along with their cell layout, so a level can be loaded without creating or adding each
+// collider. Loading reads the blob into a single allocation and fixes up its pointers in place,
+// so the hash is ready to query without any allocations per collider.
+//
+// Collider tags aren't stored and are NULL after loading. Use the collider ids with
+// spatial_hash_static_get to restore them. The loaded colliders are owned by the hash and
+// must not be freed. Blobs are only compatible with builds that use the same pointer size
+// and struct layout.
+
+// Returns the baked static tier. The result must be freed with soren_free.
+SOREN_EXPORT void* spatial_hash_write_static(SpatialHash* hash, size_t* out_size);
+SOREN_EXPORT void spatial_hash_save_static(SpatialHash* hash, const char* file);
+
+// Creates a spatial hash with the cell size and static colliders from a baked blob.
+SOREN_EXPORT SpatialHash* spatial_hash_load_static(const char* file);
+SOREN_EXPORT SpatialHash* spatial_hash_load_static_from_memory(const void* data, size_t size);
+
 // Movement functions
 
+// Moves a collider to the cells that match its current bounds. Only the cells
+// entering or leaving its coverage are touched. Call this after changing a
+// collider that is in the hash without going through the functions below.
+SOREN_EXPORT void spatial_hash_update(SpatialHash* hash, Collider* collider);
+
 SOREN_EXPORT void spatial_hash_move(SpatialHash* hash, Collider* collider, Vector delta);
 SOREN_EXPORT void spatial_hash_set_position(SpatialHash* hash, Collider* collider, Vector position);
 
@@ -68,4 +161,167 @@ SOREN_EXPORT Collider* spatial_hash_first_rectf_ext(SpatialHash* hash, RectF bou
 SOREN_EXPORT Collider* spatial_hash_first_collider(SpatialHash* hash, Collider* collider);
 SOREN_EXPORT Collider* spatial_hash_first_collider_ext(SpatialHash* hash, Collider* collider, void* ctx, ColliderColliderTest test);
 
+// Visitor queries
+
+// These call the visitor once for each matching collider instead of gathering them into a
+// collection, and stop as soon as the visitor returns false. They return false if the query
+// was stopped early. The visitor must not query or modify the hash.
+
+// Visits every collider in the cells overlapping the rect without testing it against the rect.
+SOREN_EXPORT bool spatial_hash_for_each_broadphase_rectf(SpatialHash* hash, RectF rect, void* ctx, ColliderVisitor visitor);
+
+SOREN_EXPORT bool spatial_hash_for_each_vector(SpatialHash* hash, Vector position, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool spatial_hash_for_each_rectf(SpatialHash* hash, RectF bounds, void* ctx, ColliderVisitor visitor);
+
+// Visits every collider that overlaps the collider and shares a layer with it. The collider itself is skipped.
+SOREN_EXPORT bool spatial_hash_for_each_collider(SpatialHash* hash, Collider* collider, void* ctx, ColliderVisitor visitor);
+
+// Casts a ray of the given length and returns the nearest collider it hits, or NULL.
+SOREN_EXPORT Collider* spatial_hash_raycast(SpatialHash* hash, Vector origin, Vector direction, float distance, RaycastHit* out_hit);
+
+// Returns the nearest collider that the segment hits, or NULL. Only the cells
+// along the segment are visited, and the search stops at the first hit.
+SOREN_EXPORT Collider* spatial_hash_linecast_first(SpatialHash* hash, Vector start, Vector end, RaycastHit* out_hit);
+SOREN_EXPORT ColliderCollection* spatial_hash_linecast_all(SpatialHash* hash, ColliderCollection* results, Vector start, Vector end);
+
+// Moves the collider along delta without changing it and returns the first collider it would hit, or NULL.
+// Only the cells covered by the swept bounds of the collider are searched. See collision_cast_collider
+// for the contents of out_hit.
+SOREN_EXPORT Collider* spatial_hash_cast_collider(SpatialHash* hash, Collider* collider, Vector delta, RaycastHit* out_hit);
+
+// Returns the closest collider to the point within max_distance that passes the predicate, or NULL.
+// The distance is measured to the closest point on the collider, and is 0 if the point is inside of it.
+// The predicate is optional. The search never looks past the cells that hold colliders, so max_distance
+// can be as large as FLT_MAX.
+SOREN_EXPORT Collider* spatial_hash_nearest(SpatialHash* hash, Vector point, float max_distance, void* ctx, ColliderPredicate predicate);
+
+// Finds up to k of the closest colliders to the point, sorted from nearest to furthest.
+// out_colliders needs room for k colliders. out_distances is optional, but needs room for
+// k distances if given. Returns the number of colliders that were found.
+SOREN_EXPORT int spatial_hash_k_nearest(
+    SpatialHash* hash,
+    Vector point,
+    float max_distance,
+    int k,
+    Collider** out_colliders,
+    float* out_distances,
+    void* ctx,
+    ColliderPredicate predicate);
+
+// Adds every unique pair of colliders that share a cell to the pairs list.
+// Each pair is only reported once, no matter how many cells they share.
+// If narrowphase is true, only pairs that actually overlap are added.
+// The list is not cleared first.
+SOREN_EXPORT void spatial_hash_find_pairs(SpatialHash* hash, ColliderPairList* pairs, bool narrowphase);
+
+// Statistics
+
+// Fills out_stats with the current occupancy of the hash. This visits every cell and tests
+// every pair of colliders in each one, so it's meant for tuning rather than every frame.
+// Hashes created with spatial_hash_create_dynamic_tree only report the collider count.
+SOREN_EXPORT void spatial_hash_stats(SpatialHash* hash, SpatialHashStats* out_stats);
+
+// Estimates the best cell size for the colliders currently in the hash from the
+// distribution of their sizes and how densely they're packed.
+SOREN_EXPORT float spatial_hash_suggest_cell_size(SpatialHash* hash);
+
+// Changes the cell size and reinserts every collider. If cell_size is 0 or less,
+// the size from spatial_hash_suggest_cell_size is used.
+SOREN_EXPORT void spatial_hash_rebuild(SpatialHash* hash, float cell_size);
+
+// Concurrent queries
+
+// The regular query functions share scratch space on the hash and mark the colliders they visit,
+// so only one of them can run on a hash at a time, and starting one from inside a visitor of
+// another on the same hash asserts. Colliders that are in several hashes also can't be queried
+// through the regular functions from several threads at once. The spatial_query functions keep their scratch
+// space in a SpatialQueryContext and never write to the hash or the colliders, so any number of
+// them can run on the same hash at once as long as each thread uses its own context. They're also
+// safe to call from inside a visitor.
+//
+// Before querying from several threads, call spatial_hash_prepare_queries after the last change
+// to the hash or its colliders. Nothing can modify the hash or its colliders while the queries run.
+
+SOREN_EXPORT SpatialQueryContext* spatial_query_context_create(void);
+SOREN_EXPORT void spatial_query_context_free(SpatialQueryContext* query);
+
+// Bakes the static tier and updates the lazily computed state of every collider in the hash.
+SOREN_EXPORT void spatial_hash_prepare_queries(SpatialHash* hash);
+
+SOREN_EXPORT bool spatial_query_for_each_broadphase_rectf(SpatialQueryContext* query, SpatialHash* hash, RectF rect, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool spatial_query_for_each_vector(SpatialQueryContext* query, SpatialHash* hash, Vector position, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool spatial_query_for_each_rectf(SpatialQueryContext* query, SpatialHash* hash, RectF bounds, void* ctx, ColliderVisitor visitor);
+SOREN_EXPORT bool spatial_query_for_each_collider(SpatialQueryContext* query, SpatialHash* hash, Collider* collider, void* ctx, ColliderVisitor visitor);
+
+// The test is optional. If results is NULL, a collection owned by the context is cleared and returned.
+SOREN_EXPORT ColliderCollection* spatial_query_collisions_vector(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    ColliderCollection* results,
+    Vector position,
+    void* ctx,
+    ColliderVectorTest test);
+
+SOREN_EXPORT ColliderCollection* spatial_query_collisions_rectf(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    ColliderCollection* results,
+    RectF bounds,
+    void* ctx,
+    ColliderRectFTest test);
+
+SOREN_EXPORT ColliderCollection* spatial_query_collisions_collider(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    ColliderCollection* results,
+    Collider* collider,
+    void* ctx,
+    ColliderColliderTest test);
+
+SOREN_EXPORT Collider* spatial_query_linecast_first(SpatialQueryContext* query, SpatialHash* hash, Vector start, Vector end, RaycastHit* out_hit);
+SOREN_EXPORT ColliderCollection* spatial_query_linecast_all(SpatialQueryContext* query, SpatialHash* hash, ColliderCollection* results, Vector start, Vector end);
+
+SOREN_EXPORT int spatial_query_k_nearest(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    Vector point,
+    float max_distance,
+    int k,
+    Collider** out_colliders,
+    float* out_distances,
+    void* ctx,
+    ColliderPredicate predicate);
+
+// Double buffering
+
+// Keeps two copies of the cell layout of a spatial hash so the physics can update one while
+// other threads run broadphase queries on the other. Changes are made to the back hash through
+// the functions below and recorded. Swapping makes the back hash the new front, then replays
+// the recorded changes on the old front so both copies match again.
+//
+// Only the cell layout is copied. Both hashes hold the same colliders, so while the physics is
+// moving them, spatial_query_for_each_broadphase_rectf is the only query that's safe to run on
+// the front hash, since it never reads the colliders. Its visitor must not read them either.
+// Every other query tests the shapes of the colliders, and can only run on the front hash while
+// nothing is modifying the colliders, the same as any other concurrent query. The front hash
+// must not be queried while swapping.
+
+// Takes ownership of two empty hashes, which should be created with the same settings.
+SOREN_EXPORT SpatialHashDoubleBuffer* spatial_hash_double_buffer_create(SpatialHash* first, SpatialHash* second);
+SOREN_EXPORT void spatial_hash_double_buffer_free(SpatialHashDoubleBuffer* buffer);
+
+SOREN_EXPORT SpatialHash* spatial_hash_double_buffer_front(SpatialHashDoubleBuffer* buffer);
+SOREN_EXPORT SpatialHash* spatial_hash_double_buffer_back(SpatialHashDoubleBuffer* buffer);
+
+SOREN_EXPORT void spatial_hash_double_buffer_add(SpatialHashDoubleBuffer* buffer, Collider* collider);
+SOREN_EXPORT void spatial_hash_double_buffer_remove(SpatialHashDoubleBuffer* buffer, Collider* collider);
+SOREN_EXPORT void spatial_hash_double_buffer_update(SpatialHashDoubleBuffer* buffer, Collider* collider);
+SOREN_EXPORT void spatial_hash_double_buffer_add_static(SpatialHashDoubleBuffer* buffer, Collider* collider);
+SOREN_EXPORT void spatial_hash_double_buffer_remove_static(SpatialHashDoubleBuffer* buffer, Collider* collider);
+SOREN_EXPORT void spatial_hash_double_buffer_clear(SpatialHashDoubleBuffer* buffer);
+
+// Publishes the back hash as the new front hash and prepares it for concurrent queries.
+// The static tier of the new back hash is baked as well.
+SOREN_EXPORT void spatial_hash_double_buffer_swap(SpatialHashDoubleBuffer* buffer);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef SOREN_COLLISIONS_SOREN_SWEEP_AND_PRUNE_H
+#define SOREN_COLLISIONS_SOREN_SWEEP_AND_PRUNE_H
+
+#include "soren_colliders.h"
+#include "soren_spatial_hash.h"
+
+// A sweep and prune broadphase. The left and right edges of every collider are
+// kept in a single array sorted along the x axis. Since colliders usually only
+// move a little between frames, the array is nearly sorted each time it's
+// updated and can be repaired with an insertion sort in close to linear time.
+// Added colliders are appended and the whole array is sorted once by the next
+// update, so adding many colliders at once stays cheap.
+// Works best for many slow moving colliders that are spread out horizontally.
+
+typedef struct SweepAndPrune SweepAndPrune;
+
+SOREN_EXPORT SweepAndPrune* sweep_and_prune_create(void);
+SOREN_EXPORT void sweep_and_prune_free(SweepAndPrune* sap);
+
+SOREN_EXPORT void sweep_and_prune_add(SweepAndPrune* sap, Collider* collider);
+SOREN_EXPORT void sweep_and_prune_remove(SweepAndPrune* sap, Collider* collider);
+SOREN_EXPORT void sweep_and_prune_clear(SweepAndPrune* sap);
+
+SOREN_EXPORT int sweep_and_prune_count(SweepAndPrune* sap);
+
+// Reads the current bounds of every collider and re-sorts the endpoints.
+// Call this once per frame after the colliders have moved.
+SOREN_EXPORT void sweep_and_prune_update(SweepAndPrune* sap);
+
+// Adds every pair of colliders with overlapping bounds to the pairs list.
+// Uses the bounds from the last call to sweep_and_prune_update.
+// The list is not cleared first.
+SOREN_EXPORT void sweep_and_prune_find_pairs(SweepAndPrune* sap, ColliderPairList* pairs);
+
+#endif
@@ -0,0 +1,883 @@
+#include <soren_std.h>
+#include <soren_math.h>
+#include <collisions/soren_colliders.h>
+#include <collisions/soren_spatial_hash.h>
+#include <collisions/soren_sweep_and_prune.h>
+#include <collisions/soren_hierarchical_grid.h>
+#include <collisions/soren_narrowphase.h>
+#include <collisions/soren_gjk.h>
+
+#include <SDL3/SDL.h>
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WORLD_SIZE 8192
+#define CELL_SIZE 64
+#define COLLIDER_COUNT 20000
+#define FRAME_COUNT 60
+#define CAMERA_WIDTH 1280
+#define CAMERA_HEIGHT 720
+#define TREE_MARGIN 4
+#define GRID_LEVELS 8
+#define RAY_COUNT 2000
+#define RAY_LENGTH 1024
+#define VERIFY_WORLD_SIZE 2048
+#define VERIFY_COUNT 1500
+#define VERIFY_QUERY_COUNT 500
+#define VERIFY_NEAREST_DISTANCE 256
+#define VERIFY_TOLERANCE 0.001f
+#define VERIFY_DEPTH_TOLERANCE 0.05f
+
+typedef struct BenchmarkScene {
+    Collider* colliders[COLLIDER_COUNT];
+    Vector velocities[COLLIDER_COUNT];
+} BenchmarkScene;
+
+static BenchmarkScene scene;
+
+// A smaller scene with every convex collider type, so the broadphases and the
+// narrowphase can be checked against brute force before they're timed.
+static Collider* verify_colliders[VERIFY_COUNT];
+static int verify_failures = 0;
+
+static double ticks_to_ms(uint64_t ticks) {
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static void benchmark_scene_init(uint32_t seed) {
+    Random random;
+    random_init(&random, seed);
+
+    for (int i = 0; i < COLLIDER_COUNT; i++) {
+        Collider* collider;
+
+        // Mostly small movers with the occasional large static wall.
+        if (i % 200 == 0) {
+            collider = (Collider*)box_collider_create(
+                64 + random_float(&random) * 1024,
+                16 + random_float(&random) * 64);
+            scene.velocities[i] = VECTOR_ZERO;
+        } else if (i % 2 == 0) {
+            collider = (Collider*)circle_collider_create(4 + random_float(&random) * 12);
+            scene.velocities[i] = vector_create(random_float(&random) * 8 - 4, random_float(&random) * 8 - 4);
+        } else {
+            collider = (Collider*)box_collider_create(8 + random_float(&random) * 24, 8 + random_float(&random) * 24);
+            scene.velocities[i] = vector_create(random_float(&random) * 8 - 4, random_float(&random) * 8 - 4);
+        }
+
+        collider_set_position(collider, vector_create(random_float(&random) * WORLD_SIZE, random_float(&random) * WORLD_SIZE));
+        scene.colliders[i] = collider;
+    }
+}
+
+static void benchmark_scene_reset_positions(uint32_t seed) {
+    Random random;
+    random_init(&random, seed);
+
+    for (int i = 0; i < COLLIDER_COUNT; i++) {
+        collider_set_position(scene.colliders[i], vector_create(random_float(&random) * WORLD_SIZE, random_float(&random) * WORLD_SIZE));
+    }
+}
+
+static void benchmark_spatial_hash(const char* name, SpatialHash* hash) {
+    ColliderPairList* pairs = collider_pair_list_create();
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < COLLIDER_COUNT; i++) {
+        spatial_hash_add(hash, scene.colliders[i]);
+    }
+
+    uint64_t insert_ticks = SDL_GetPerformanceCounter() - start;
+    uint64_t move_ticks = 0;
+    uint64_t query_ticks = 0;
+    uint64_t camera_ticks = 0;
+    uint64_t pair_ticks = 0;
+    uint64_t ray_ticks = 0;
+    size_t candidates = 0;
+    size_t pair_count = 0;
+    size_t ray_hits = 0;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        start = SDL_GetPerformanceCounter();
+
+        for (int i = 0; i < COLLIDER_COUNT; i++) {
+            if (scene.velocities[i].x != 0 || scene.velocities[i].y != 0) {
+                spatial_hash_move(hash, scene.colliders[i], scene.velocities[i]);
+            }
+        }
+
+        move_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        for (int i = 0; i < COLLIDER_COUNT; i++) {
+            ColliderCollection* results = spatial_hash_broadphase_collider(hash, scene.colliders[i], NULL);
+            candidates += collider_collection_count(results);
+        }
+
+        query_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        for (int y = 0; y < WORLD_SIZE; y += CAMERA_HEIGHT) {
+            for (int x = 0; x < WORLD_SIZE; x += CAMERA_WIDTH) {
+                ColliderCollection* results = spatial_hash_broadphase_rectf(hash, (RectF){ x, y, CAMERA_WIDTH, CAMERA_HEIGHT }, NULL);
+                candidates += collider_collection_count(results);
+            }
+        }
+
+        camera_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        collider_pair_list_clear(pairs);
+        spatial_hash_find_pairs(hash, pairs, false);
+        pair_count += collider_pair_list_count(pairs);
+
+        pair_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        Random random;
+        random_init(&random, frame);
+
+        for (int i = 0; i < RAY_COUNT; i++) {
+            float angle = random_float(&random) * 2 * SDL_PI_F;
+            Vector from = vector_create(random_float(&random) * WORLD_SIZE, random_float(&random) * WORLD_SIZE);
+            Vector to = vector_add(from, vector_create(SDL_cosf(angle) * RAY_LENGTH, SDL_sinf(angle) * RAY_LENGTH));
+
+            if (spatial_hash_linecast_first(hash, from, to, NULL)) {
+                ray_hits++;
+            }
+        }
+
+        ray_ticks += SDL_GetPerformanceCounter() - start;
+    }
+
+    printf(
+        "%-24s insert: %8.3fms | move: %8.3fms/frame | collider queries: %8.3fms/frame | camera queries: %8.3fms/frame | pairs: %8.3fms/frame | linecasts: %8.3fms/frame | candidates: %zu | pair candidates: %zu | ray hits: %zu\n",
+        name,
+        ticks_to_ms(insert_ticks),
+        ticks_to_ms(move_ticks) / FRAME_COUNT,
+        ticks_to_ms(query_ticks) / FRAME_COUNT,
+        ticks_to_ms(camera_ticks) / FRAME_COUNT,
+        ticks_to_ms(pair_ticks) / FRAME_COUNT,
+        ticks_to_ms(ray_ticks) / FRAME_COUNT,
+        candidates,
+        pair_count,
+        ray_hits);
+
+    collider_pair_list_free(pairs);
+}
+
+static void benchmark_sweep_and_prune(const char* name) {
+    SweepAndPrune* sap = sweep_and_prune_create();
+    ColliderPairList* pairs = collider_pair_list_create();
+
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < COLLIDER_COUNT; i++) {
+        sweep_and_prune_add(sap, scene.colliders[i]);
+    }
+
+    uint64_t insert_ticks = SDL_GetPerformanceCounter() - start;
+    uint64_t move_ticks = 0;
+    uint64_t pair_ticks = 0;
+    size_t candidates = 0;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        start = SDL_GetPerformanceCounter();
+
+        for (int i = 0; i < COLLIDER_COUNT; i++) {
+            if (scene.velocities[i].x != 0 || scene.velocities[i].y != 0) {
+                collider_set_position(scene.colliders[i], vector_add(scene.velocities[i], collider_position(scene.colliders[i])));
+            }
+        }
+
+        sweep_and_prune_update(sap);
+
+        move_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        collider_pair_list_clear(pairs);
+        sweep_and_prune_find_pairs(sap, pairs);
+        candidates += collider_pair_list_count(pairs);
+
+        pair_ticks += SDL_GetPerformanceCounter() - start;
+    }
+
+    // Each pair would be found twice by per-collider queries, once from each side.
+    printf(
+        "%-24s insert: %8.3fms | move: %8.3fms/frame | pairs: %8.3fms/frame | candidates: %zu\n",
+        name,
+        ticks_to_ms(insert_ticks),
+        ticks_to_ms(move_ticks) / FRAME_COUNT,
+        ticks_to_ms(pair_ticks) / FRAME_COUNT,
+        candidates * 2);
+
+    collider_pair_list_free(pairs);
+    sweep_and_prune_free(sap);
+}
+
+static void benchmark_hierarchical_grid(const char* name) {
+    HierarchicalGrid* grid = hierarchical_grid_create(CELL_SIZE / 4, GRID_LEVELS);
+    ColliderPairList* pairs = collider_pair_list_create();
+
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < COLLIDER_COUNT; i++) {
+        hierarchical_grid_add(grid, scene.colliders[i]);
+    }
+
+    uint64_t insert_ticks = SDL_GetPerformanceCounter() - start;
+    uint64_t move_ticks = 0;
+    uint64_t query_ticks = 0;
+    uint64_t camera_ticks = 0;
+    uint64_t pair_ticks = 0;
+    size_t candidates = 0;
+    size_t pair_count = 0;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        start = SDL_GetPerformanceCounter();
+
+        for (int i = 0; i < COLLIDER_COUNT; i++) {
+            if (scene.velocities[i].x != 0 || scene.velocities[i].y != 0) {
+                hierarchical_grid_move(grid, scene.colliders[i], scene.velocities[i]);
+            }
+        }
+
+        move_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        for (int i = 0; i < COLLIDER_COUNT; i++) {
+            ColliderCollection* results = hierarchical_grid_broadphase_collider(grid, scene.colliders[i], NULL);
+            candidates += collider_collection_count(results);
+        }
+
+        query_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        for (int y = 0; y < WORLD_SIZE; y += CAMERA_HEIGHT) {
+            for (int x = 0; x < WORLD_SIZE; x += CAMERA_WIDTH) {
+                ColliderCollection* results = hierarchical_grid_broadphase_rectf(grid, (RectF){ x, y, CAMERA_WIDTH, CAMERA_HEIGHT }, NULL);
+                candidates += collider_collection_count(results);
+            }
+        }
+
+        camera_ticks += SDL_GetPerformanceCounter() - start;
+        start = SDL_GetPerformanceCounter();
+
+        collider_pair_list_clear(pairs);
+        hierarchical_grid_find_pairs(grid, pairs, false);
+        pair_count += collider_pair_list_count(pairs);
+
+        pair_ticks += SDL_GetPerformanceCounter() - start;
+    }
+
+    printf(
+        "%-24s insert: %8.3fms | move: %8.3fms/frame | collider queries: %8.3fms/frame | camera queries: %8.3fms/frame | pairs: %8.3fms/frame | candidates: %zu | pair candidates: %zu\n",
+        name,
+        ticks_to_ms(insert_ticks),
+        ticks_to_ms(move_ticks) / FRAME_COUNT,
+        ticks_to_ms(query_ticks) / FRAME_COUNT,
+        ticks_to_ms(camera_ticks) / FRAME_COUNT,
+        ticks_to_ms(pair_ticks) / FRAME_COUNT,
+        candidates,
+        pair_count);
+
+    collider_pair_list_free(pairs);
+    hierarchical_grid_free(grid);
+}
+
+static void benchmark_narrowphase(const char* name, SpatialHash* hash, int thread_count) {
+    NarrowphasePool* pool = narrowphase_pool_create(thread_count);
+    ColliderPairList* pairs = collider_pair_list_create();
+    ContactList* contacts = contact_list_create();
+    uint64_t ticks = 0;
+
+    for (int i = 0; i < COLLIDER_COUNT; i++) {
+        spatial_hash_add(hash, scene.colliders[i]);
+    }
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        for (int i = 0; i < COLLIDER_COUNT; i++) {
+            if (scene.velocities[i].x != 0 || scene.velocities[i].y != 0) {
+                spatial_hash_move(hash, scene.colliders[i], scene.velocities[i]);
+            }
+        }
+
+        collider_pair_list_clear(pairs);
+        contact_list_clear(contacts);
+        spatial_hash_find_pairs(hash, pairs, false);
+
+        uint64_t start = SDL_GetPerformanceCounter();
+        narrowphase_pool_run(pool, pairs, contacts);
+        ticks += SDL_GetPerformanceCounter() - start;
+    }
+
+    printf(
+        "%-24s threads: %2d | narrowphase: %8.3fms/frame | contacts: %d\n",
+        name,
+        narrowphase_pool_thread_count(pool),
+        ticks_to_ms(ticks) / FRAME_COUNT,
+        contact_list_count(contacts));
+
+    contact_list_free(contacts);
+    collider_pair_list_free(pairs);
+    narrowphase_pool_free(pool);
+}
+
+static void verify(bool condition, const char* name, const char* message) {
+    if (!condition) {
+        verify_failures++;
+        printf("FAILED %-22s %s\n", name, message);
+    }
+}
+
+static void verify_scene_init(uint32_t seed) {
+    Random random;
+    random_init(&random, seed);
+
+    for (int i = 0; i < VERIFY_COUNT; i++) {
+        Collider* collider;
+
+        switch (i % 3) {
+            case 0:
+                collider = (Collider*)circle_collider_create(4 + random_float(&random) * 28);
+                break;
+            case 1:
+                collider = (Collider*)box_collider_create(8 + random_float(&random) * 56, 8 + random_float(&random) * 56);
+                collider_set_rotation(collider, random_float(&random) * 2 * SDL_PI_F);
+                break;
+            default:
+                collider = (Collider*)capsule_collider_create(4 + random_float(&random) * 12, 8 + random_float(&random) * 64);
+                collider_set_rotation(collider, random_float(&random) * 2 * SDL_PI_F);
+                break;
+        }
+
+        collider_set_position(collider, vector_create(random_float(&random) * VERIFY_WORLD_SIZE, random_float(&random) * VERIFY_WORLD_SIZE));
+        verify_colliders[i] = collider;
+    }
+}
+
+static inline bool verify_bounds_overlap(RectF first, RectF second) {
+    return rectf_left(first) <= rectf_right(second)
+        && rectf_right(first) >= rectf_left(second)
+        && rectf_top(first) <= rectf_bottom(second)
+        && rectf_bottom(first) >= rectf_top(second);
+}
+
+static int verify_pair_compare(const void* left, const void* right) {
+    const ColliderPair* a = left;
+    const ColliderPair* b = right;
+
+    if (a->first != b->first) {
+        return (uintptr_t)a->first < (uintptr_t)b->first ? -1 : 1;
+    }
+
+    if (a->second != b->second) {
+        return (uintptr_t)a->second < (uintptr_t)b->second ? -1 : 1;
+    }
+
+    return 0;
+}
+
+// Orders each pair and then the list, so lists from different broadphases can be compared directly.
+static ColliderPair* verify_sorted_pairs(ColliderPairList* pairs, int* out_count) {
+    int count = collider_pair_list_count(pairs);
+    ColliderPair* sorted = soren_malloc(SDL_max(1, count) * sizeof(*sorted));
+
+    for (int i = 0; i < count; i++) {
+        ColliderPair pair = collider_pair_list_get(pairs, i);
+        if ((uintptr_t)pair.second < (uintptr_t)pair.first) {
+            sorted[i] = (ColliderPair){ pair.second, pair.first };
+        } else {
+            sorted[i] = pair;
+        }
+    }
+
+    SDL_qsort(sorted, count, sizeof(*sorted), verify_pair_compare);
+    *out_count = count;
+    return sorted;
+}
+
+// The pairs must match exactly, so duplicates are reported as well as missing pairs.
+static void verify_pairs(const char* name, ColliderPairList* expected, ColliderPairList* actual) {
+    int expected_count;
+    int actual_count;
+    ColliderPair* expected_pairs = verify_sorted_pairs(expected, &expected_count);
+    ColliderPair* actual_pairs = verify_sorted_pairs(actual, &actual_count);
+
+    verify(expected_count == actual_count, name, "found a different number of pairs than brute force");
+
+    int mismatches = 0;
+    for (int i = 0; i < SDL_min(expected_count, actual_count); i++) {
+        if (verify_pair_compare(expected_pairs + i, actual_pairs + i) != 0) {
+            mismatches++;
+        }
+    }
+
+    verify(mismatches == 0, name, "found different pairs than brute force");
+
+    soren_free(expected_pairs);
+    soren_free(actual_pairs);
+}
+
+// Removes the pairs that don't actually overlap, for broadphases that can only report bounds.
+static void verify_filter_pairs(ColliderPairList* pairs) {
+    ColliderPairList* filtered = collider_pair_list_create();
+
+    for (int i = 0; i < collider_pair_list_count(pairs); i++) {
+        ColliderPair pair = collider_pair_list_get(pairs, i);
+        if (collider_overlaps_collider_impl(pair.first, pair.second)) {
+            collider_pair_list_add(filtered, pair);
+        }
+    }
+
+    collider_pair_list_clear(pairs);
+    for (int i = 0; i < collider_pair_list_count(filtered); i++) {
+        collider_pair_list_add(pairs, collider_pair_list_get(filtered, i));
+    }
+
+    collider_pair_list_free(filtered);
+}
+
+static void verify_broadphase_pairs(ColliderPairList* bounds_pairs, ColliderPairList* overlapping_pairs) {
+    ColliderPairList* pairs = collider_pair_list_create();
+
+    SpatialHash* hash = spatial_hash_create(CELL_SIZE);
+    SpatialHash* bounded = spatial_hash_create_bounded(CELL_SIZE, (RectF){ 0, 0, VERIFY_WORLD_SIZE, VERIFY_WORLD_SIZE });
+    SpatialHash* tree = spatial_hash_create_dynamic_tree(TREE_MARGIN);
+    SweepAndPrune* sap = sweep_and_prune_create();
+    HierarchicalGrid* grid = hierarchical_grid_create(CELL_SIZE / 4, GRID_LEVELS);
+
+    for (int i = 0; i < VERIFY_COUNT; i++) {
+        spatial_hash_add(hash, verify_colliders[i]);
+        spatial_hash_add(bounded, verify_colliders[i]);
+        spatial_hash_add(tree, verify_colliders[i]);
+        sweep_and_prune_add(sap, verify_colliders[i]);
+        hierarchical_grid_add(grid, verify_colliders[i]);
+    }
+
+    spatial_hash_find_pairs(hash, pairs, true);
+    verify_pairs("SpatialHash (map)", overlapping_pairs, pairs);
+
+    collider_pair_list_clear(pairs);
+    spatial_hash_find_pairs(bounded, pairs, true);
+    verify_pairs("SpatialHash (bounded)", overlapping_pairs, pairs);
+
+    collider_pair_list_clear(pairs);
+    spatial_hash_find_pairs(tree, pairs, true);
+    verify_pairs("AabbTree", overlapping_pairs, pairs);
+
+    collider_pair_list_clear(pairs);
+    hierarchical_grid_find_pairs(grid, pairs, true);
+    verify_pairs("HierarchicalGrid", overlapping_pairs, pairs);
+
+    // Sweep and prune reports pairs with touching bounds, the same as the brute force bounds test.
+    collider_pair_list_clear(pairs);
+    sweep_and_prune_update(sap);
+    sweep_and_prune_find_pairs(sap, pairs);
+    verify_pairs("SweepAndPrune (bounds)", bounds_pairs, pairs);
+    verify_filter_pairs(pairs);
+    verify_pairs("SweepAndPrune", overlapping_pairs, pairs);
+
+    Random random;
+    random_init(&random, VERIFY_COUNT);
+
+    SpatialHash* hashes[] = { hash, bounded, tree };
+    const char* names[] = { "SpatialHash (map)", "SpatialHash (bounded)", "AabbTree" };
+    CircleCollider* probe = circle_collider_create(0);
+
+    for (int i = 0; i < VERIFY_QUERY_COUNT; i++) {
+        float angle = random_float(&random) * 2 * SDL_PI_F;
+        Vector from = vector_create(random_float(&random) * VERIFY_WORLD_SIZE, random_float(&random) * VERIFY_WORLD_SIZE);
+        Vector to = vector_add(from, vector_create(SDL_cosf(angle) * RAY_LENGTH / 4, SDL_sinf(angle) * RAY_LENGTH / 4));
+
+        float expected_fraction = FLT_MAX;
+        float expected_distance = FLT_MAX;
+        collider_set_position(probe, from);
+
+        for (int j = 0; j < VERIFY_COUNT; j++) {
+            RaycastHit hit;
+            if (collider_collides_line_impl(verify_colliders[j], from, to, &hit)) {
+                expected_fraction = SDL_min(expected_fraction, hit.fraction);
+            }
+
+            expected_distance = SDL_min(expected_distance, collider_distance(verify_colliders[j], probe));
+        }
+
+        for (int j = 0; j < (int)SDL_arraysize(hashes); j++) {
+            RaycastHit hit;
+            Collider* first = spatial_hash_linecast_first(hashes[j], from, to, &hit);
+            if (expected_fraction == FLT_MAX) {
+                verify(first == NULL, names[j], "linecast hit a collider that brute force missed");
+            } else {
+                verify(first != NULL, names[j], "linecast missed a collider that brute force hit");
+                verify(!first || SDL_fabsf(hit.fraction - expected_fraction) <= VERIFY_TOLERANCE, names[j], "linecast didn't return the first hit");
+            }
+
+            Collider* nearest = spatial_hash_nearest(hashes[j], from, VERIFY_NEAREST_DISTANCE, NULL, NULL);
+            if (expected_distance > VERIFY_NEAREST_DISTANCE) {
+                verify(nearest == NULL, names[j], "nearest found a collider further than the max distance");
+            } else {
+                verify(nearest != NULL, names[j], "nearest missed a collider within the max distance");
+                verify(
+                    !nearest || SDL_fabsf(collider_distance(nearest, probe) - expected_distance) <= VERIFY_TOLERANCE,
+                    names[j],
+                    "nearest didn't return the closest collider");
+            }
+
+            nearest = spatial_hash_nearest(hashes[j], from, FLT_MAX, NULL, NULL);
+            verify(
+                nearest && SDL_fabsf(collider_distance(nearest, probe) - expected_distance) <= VERIFY_TOLERANCE,
+                names[j],
+                "unbounded nearest didn't return the closest collider");
+        }
+    }
+
+    spatial_hash_free(hash);
+    spatial_hash_free(bounded);
+    spatial_hash_free(tree);
+    sweep_and_prune_free(sap);
+    hierarchical_grid_free(grid);
+    collider_pair_list_free(pairs);
+}
+
+// The pool has to report the same contacts in the same order as testing the pairs one at a time.
+static void verify_narrowphase(ColliderPairList* bounds_pairs) {
+    NarrowphasePool* pool = narrowphase_pool_create(0);
+    ContactList* contacts = contact_list_create();
+    ContactList* expected = contact_list_create();
+
+    narrowphase_pool_run(pool, bounds_pairs, contacts);
+
+    for (int i = 0; i < collider_pair_list_count(bounds_pairs); i++) {
+        ColliderPair pair = collider_pair_list_get(bounds_pairs, i);
+        Contact contact = (Contact){ pair.first, pair.second };
+        if (collider_collides_collider_impl(pair.first, pair.second, &contact.result, &contact.hit)) {
+            contact_list_add(expected, contact);
+        }
+    }
+
+    verify(contact_list_count(contacts) == contact_list_count(expected), "Narrowphase (pool)", "found a different number of contacts");
+
+    int mismatches = 0;
+    for (int i = 0; i < SDL_min(contact_list_count(contacts), contact_list_count(expected)); i++) {
+        Contact actual = contact_list_get(contacts, i);
+        Contact wanted = contact_list_get(expected, i);
+
+        if (actual.first != wanted.first
+            || actual.second != wanted.second
+            || vector_distance(actual.result.minimum_translation_vector, wanted.result.minimum_translation_vector) > VERIFY_TOLERANCE)
+        {
+            mismatches++;
+        }
+    }
+
+    verify(mismatches == 0, "Narrowphase (pool)", "found different contacts than testing each pair");
+
+    contact_list_free(expected);
+    contact_list_free(contacts);
+    narrowphase_pool_free(pool);
+}
+
+// Both backends have to agree on which pairs overlap and by how much. Pairs that only just
+// touch are allowed to disagree, since the backends round differently.
+static void verify_gjk(ColliderPairList* bounds_pairs) {
+    int mismatches = 0;
+    int depth_mismatches = 0;
+
+    for (int i = 0; i < collider_pair_list_count(bounds_pairs); i++) {
+        ColliderPair pair = collider_pair_list_get(bounds_pairs, i);
+        CollisionResult sat;
+        CollisionResult gjk;
+        RaycastHit hit;
+
+        bool sat_collides = collider_collides_collider_impl(pair.first, pair.second, &sat, &hit);
+        bool gjk_collides = collision_gjk_ext(pair.first, pair.second, &gjk);
+        float sat_depth = vector_length(sat.minimum_translation_vector);
+        float gjk_depth = vector_length(gjk.minimum_translation_vector);
+
+        if (sat_collides != gjk_collides) {
+            if (SDL_max(sat_depth, gjk_depth) > VERIFY_DEPTH_TOLERANCE) {
+                mismatches++;
+            }
+        } else if (sat_collides && SDL_fabsf(sat_depth - gjk_depth) > VERIFY_DEPTH_TOLERANCE) {
+            depth_mismatches++;
+        }
+    }
+
+    verify(mismatches == 0, "GJK", "disagreed with SAT about which pairs overlap");
+    verify(depth_mismatches == 0, "GJK", "disagreed with SAT about the penetration depth");
+}
+
+// Checks a collision with a known depth. Moving the first collider back along the
+// translation vector has to leave the colliders at most touching.
+static void verify_contact(const char* name, Collider* first, Collider* second, bool expected, float expected_depth) {
+    CollisionResult result;
+    RaycastHit hit;
+    bool collides = collider_collides_collider_impl(first, second, &result, &hit);
+
+    verify(collides == expected, name, expected ? "missed a known contact" : "reported a contact between separated colliders");
+    if (!collides || !expected) {
+        return;
+    }
+
+    verify(SDL_fabsf(vector_length(result.minimum_translation_vector) - expected_depth) <= VERIFY_TOLERANCE, name, "returned the wrong depth");
+    verify(SDL_fabsf(vector_length(result.normal) - 1) <= VERIFY_TOLERANCE, name, "returned a normal that isn't unit length");
+
+    CollisionResult gjk;
+    verify(
+        collision_gjk_ext(first, second, &gjk) && SDL_fabsf(vector_length(gjk.minimum_translation_vector) - expected_depth) <= VERIFY_TOLERANCE,
+        name,
+        "GJK returned the wrong depth");
+    verify(SDL_fabsf(vector_length(gjk.normal) - 1) <= VERIFY_TOLERANCE, name, "GJK returned a normal that isn't unit length");
+
+    Vector position = collider_position(first);
+    collider_set_position(first, vector_subtract(position, result.minimum_translation_vector));
+
+    CollisionResult separated;
+    if (collider_collides_collider_impl(first, second, &separated, &hit)) {
+        verify(vector_length(separated.minimum_translation_vector) <= VERIFY_TOLERANCE, name, "translation vector doesn't separate the colliders");
+    }
+
+    collider_set_position(first, position);
+}
+
+// Rotated polygons turn around their center, while unrotated ones keep their original points. The points have to match transforming the
+// original points with matrix_create_trso, and shouldn't jump when the rotation leaves 0.
+static void verify_polygon_transform(void) {
+    BoxCollider* box = box_collider_create(40, 20);
+    PolygonCollider* polygon = (PolygonCollider*)box;
+
+    box_collider_set_original_center(box, vector_create(20, 10));
+
+    int count;
+    Vector* points = polygon_collider_points(polygon, &count);
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        if (vector_distance(points[i], polygon->original_points[i]) > VERIFY_TOLERANCE) {
+            mismatches++;
+        }
+    }
+
+    verify(mismatches == 0, "Polygon transform", "moved the points of an unrotated polygon");
+
+    float rotations[] = { 0.7f, 0.0001f };
+    for (int i = 0; i < (int)SDL_arraysize(rotations); i++) {
+        collider_set_rotation(box, rotations[i]);
+
+        Matrix transform = matrix_create_trso(VECTOR_ZERO, rotations[i], VECTOR_ONE, polygon_collider_center(polygon));
+        points = polygon_collider_points(polygon, &count);
+        mismatches = 0;
+
+        int jumps = 0;
+
+        for (int j = 0; j < count; j++) {
+            if (vector_distance(points[j], vector_transform(polygon->original_points[j], &transform)) > VERIFY_TOLERANCE) {
+                mismatches++;
+            }
+
+            // A tiny rotation only moves the points by about the angle times their distance to the center.
+            if (rotations[i] < 0.001f && vector_distance(points[j], polygon->original_points[j]) > VERIFY_DEPTH_TOLERANCE) {
+                jumps++;
+            }
+        }
+
+        verify(mismatches == 0, "Polygon transform", "moved the points of a rotated polygon away from its center");
+        verify(jumps == 0, "Polygon transform", "moved the points when the rotation left 0");
+    }
+}
+
+// Checks a cast with a known time of impact.
+static void verify_cast(const char* name, Collider* collider, Vector delta, Collider* other, bool expected, float expected_fraction) {
+    RaycastHit hit;
+    bool collides = collision_cast_collider(collider, delta, other, &hit);
+
+    verify(collides == expected, name, expected ? "missed a known hit" : "reported a hit between shapes that never touch");
+    if (collides && expected) {
+        verify(SDL_fabsf(hit.fraction - expected_fraction) <= VERIFY_TOLERANCE, name, "returned the wrong fraction");
+        verify(SDL_fabsf(vector_length(hit.normal) - 1) <= VERIFY_TOLERANCE, name, "returned a normal that isn't unit length");
+    }
+}
+
+static void verify_capsules(void) {
+    // A vertical capsule whose segment runs from (0, -20) to (0, 20).
+    CapsuleCollider* capsule = capsule_collider_create(10, 60);
+    CapsuleCollider* other = capsule_collider_create(10, 60);
+    CapsuleCollider* round = capsule_collider_create(10, 10);
+    CircleCollider* circle = circle_collider_create(5);
+    BoxCollider* box = box_collider_create(20, 20);
+
+    collider_set_position(circle, vector_create(12, 0));
+    verify_contact("Capsule to circle side", (Collider*)capsule, (Collider*)circle, true, 3);
+
+    collider_set_position(circle, vector_create(0, 33));
+    verify_contact("Capsule to circle cap", (Collider*)capsule, (Collider*)circle, true, 2);
+
+    collider_set_position(circle, vector_create(0, 40));
+    verify_contact("Capsule to circle apart", (Collider*)capsule, (Collider*)circle, false, 0);
+
+    collider_set_position(other, vector_create(15, 0));
+    verify_contact("Capsule to capsule side", (Collider*)capsule, (Collider*)other, true, 5);
+
+    collider_set_rotation(other, SDL_PI_F / 2);
+    collider_set_position(other, vector_create(0, 35));
+    verify_contact("Capsule to capsule cap", (Collider*)capsule, (Collider*)other, true, 5);
+
+    // Place the left side of the box 2 units inside of the right side of the capsule.
+    RectF bounds = collider_bounds(box);
+    collider_set_position(box, vector_add(collider_position(box), vector_create(8 - rectf_left(bounds), -rectf_top(bounds) - 10)));
+    verify_contact("Capsule to box", (Collider*)capsule, (Collider*)box, true, 2);
+
+    // A capsule that's no taller than it's wide is a circle, and circles with the same
+    // center still need a normal to push them apart.
+    collider_set_position(circle, VECTOR_ZERO);
+    verify_contact("Round capsule to circle", (Collider*)round, (Collider*)circle, true, 15);
+
+    // Round capsules and points don't have any axes, so casts against them
+    // can't rely on the separating axis test to rule out an overlap.
+    CapsuleCollider* other_round = capsule_collider_create(10, 10);
+    PointCollider point = (PointCollider){ 0 };
+    collider_init((Collider*)&point, COLLIDER_POINT);
+    point.scale = 1;
+
+    collider_set_position(round, VECTOR_ZERO);
+    collider_set_position(other_round, vector_create(100, 0));
+    verify_cast("Round capsule cast apart", (Collider*)round, vector_create(0, 100), (Collider*)other_round, false, 0);
+    verify_cast("Round capsule cast", (Collider*)round, vector_create(100, 0), (Collider*)other_round, true, 0.8f);
+
+    point.position = vector_create(0, 100);
+    verify_cast("Round capsule to point cast", (Collider*)round, vector_create(0, 200), (Collider*)&point, true, 0.45f);
+    verify_cast("Point to round capsule cast", (Collider*)&point, vector_create(0, -200), (Collider*)round, true, 0.45f);
+
+    // The point is on the same line as the segment, but 80 units past its end.
+    collider_set_rotation(capsule, 0);
+    collider_set_position(capsule, VECTOR_ZERO);
+    verify_cast("Capsule falling onto point", (Collider*)capsule, vector_create(0, 200), (Collider*)&point, true, 0.35f);
+    verify_cast("Capsule moving off point", (Collider*)capsule, vector_create(0, -200), (Collider*)&point, false, 0);
+
+    SpatialHash* hash = spatial_hash_create(CELL_SIZE);
+    spatial_hash_add(hash, (Collider*)&point);
+
+    RaycastHit hit;
+    Collider* first = spatial_hash_cast_collider(hash, (Collider*)capsule, vector_create(0, 200), &hit);
+    verify(first == (Collider*)&point && SDL_fabsf(hit.fraction - 0.35f) <= VERIFY_TOLERANCE, "Capsule falling onto point", "spatial hash cast returned the wrong hit");
+
+    spatial_hash_free(hash);
+
+    // Shapes that overlap before they move hit at the start of the cast, and still need
+    // a normal when there's no motion or the shapes share a center.
+    BoxCollider* other_box = box_collider_create(20, 20);
+    collider_set_position(other_box, collider_position(box));
+    collider_set_position(circle, VECTOR_ZERO);
+    collider_set_position(round, VECTOR_ZERO);
+    point.position = VECTOR_ZERO;
+
+    verify_cast("Circle cast in place", (Collider*)circle, VECTOR_ZERO, (Collider*)round, true, 0);
+    verify_cast("Capsule cast in place", (Collider*)capsule, VECTOR_ZERO, (Collider*)&point, true, 0);
+    verify_cast("Point cast in place", (Collider*)&point, VECTOR_ZERO, (Collider*)capsule, true, 0);
+    verify_cast("Box cast in place", (Collider*)box, VECTOR_ZERO, (Collider*)other_box, true, 0);
+}
+
+static void verify_all(uint32_t seed) {
+    verify_scene_init(seed);
+
+    ColliderPairList* bounds_pairs = collider_pair_list_create();
+    ColliderPairList* overlapping_pairs = collider_pair_list_create();
+
+    for (int i = 0; i < VERIFY_COUNT; i++) {
+        RectF bounds = collider_bounds(verify_colliders[i]);
+
+        for (int j = i + 1; j < VERIFY_COUNT; j++) {
+            if (!verify_bounds_overlap(bounds, collider_bounds(verify_colliders[j]))
+                || !collider_should_collide(verify_colliders[i], verify_colliders[j]))
+            {
+                continue;
+            }
+
+            ColliderPair pair = (ColliderPair){ verify_colliders[i], verify_colliders[j] };
+            collider_pair_list_add(bounds_pairs, pair);
+
+            if (collider_overlaps_collider_impl(pair.first, pair.second)) {
+                collider_pair_list_add(overlapping_pairs, pair);
+            }
+        }
+    }
+
+    verify_broadphase_pairs(bounds_pairs, overlapping_pairs);
+    verify_narrowphase(bounds_pairs);
+    verify_gjk(bounds_pairs);
+    verify_polygon_transform();
+    verify_capsules();
+
+    printf(
+        "Verification: %d bounds pairs | %d overlapping pairs | %d failures\n",
+        collider_pair_list_count(bounds_pairs),
+        collider_pair_list_count(overlapping_pairs),
+        verify_failures);
+
+    collider_pair_list_free(bounds_pairs);
+    collider_pair_list_free(overlapping_pairs);
+}
+
+int main(int argc, char** argv) {
+    e4c_context_begin(false);
+
+    if (SDL_Init(0) < 0) {
+        printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+        e4c_context_end();
+        return EXIT_FAILURE;
+    }
+
+    soren_init(false);
+
+    uint32_t seed = 1234;
+
+    try {
+        verify_all(seed);
+
+        benchmark_scene_init(seed);
+
+        SpatialHash* hash = spatial_hash_create(CELL_SIZE);
+        benchmark_spatial_hash("SpatialHash (map)", hash);
+        spatial_hash_free(hash);
+
+        benchmark_scene_reset_positions(seed);
+
+        hash = spatial_hash_create_bounded(CELL_SIZE, (RectF){ 0, 0, WORLD_SIZE, WORLD_SIZE });
+        benchmark_spatial_hash("SpatialHash (bounded)", hash);
+        spatial_hash_free(hash);
+
+        benchmark_scene_reset_positions(seed);
+
+        hash = spatial_hash_create_dynamic_tree(TREE_MARGIN);
+        benchmark_spatial_hash("AabbTree", hash);
+        spatial_hash_free(hash);
+
+        benchmark_scene_reset_positions(seed);
+        benchmark_sweep_and_prune("SweepAndPrune");
+
+        benchmark_scene_reset_positions(seed);
+        benchmark_hierarchical_grid("HierarchicalGrid");
+
+        benchmark_scene_reset_positions(seed);
+
+        hash = spatial_hash_create_bounded(CELL_SIZE, (RectF){ 0, 0, WORLD_SIZE, WORLD_SIZE });
+        benchmark_narrowphase("Narrowphase (serial)", hash, 1);
+        spatial_hash_free(hash);
+
+        benchmark_scene_reset_positions(seed);
+
+        hash = spatial_hash_create_bounded(CELL_SIZE, (RectF){ 0, 0, WORLD_SIZE, WORLD_SIZE });
+        benchmark_narrowphase("Narrowphase (pool)", hash, 0);
+        spatial_hash_free(hash);
+    } catch(RuntimeException) {
+        const e4c_exception* exception = e4c_get_exception();
+        printf("Encountered a runtime exception :(\n%s:\n%s", exception->name, exception->message);
+    }
+
+    SDL_Quit();
+    e4c_context_end();
+
+    return verify_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1061 @@
+#include <collisions/soren_aabb_tree.h>
+#include <collisions/soren_collisions.h>
+
+#include "soren_collisions_shared.h"
+
+#include <generic_map.h>
+#include <generic_iterators/map_iterator.h>
+
+#include <float.h>
+
+// The implementation follows the dynamic tree from Box2D
+// (https://github.com/erincatto/box2d/blob/v2.4.1/src/collision/b2_dynamic_tree.cpp)
+
+#define AABB_TREE_NULL_NODE -1
+#define AABB_TREE_STACK_CAPACITY 256
+
+// How far ahead of a moving collider its fat bounds are extended,
+// as a multiple of the distance it moved.
+#define AABB_TREE_DISPLACEMENT_MULTIPLIER 4.f
+
+MAP_DEFINE_H(ColliderLeafMap, collider_leaf_map, Collider*, int)
+MAP_DEFINE_C(ColliderLeafMap, collider_leaf_map, Collider*, int, gds_pointer_hash, gds_pointer_compare)
+
+typedef struct AabbTreeNode {
+    RectF bounds;
+    Collider* collider;
+    union {
+        int parent;
+        int next;
+    };
+    int left;
+    int right;
+    // Leaves have a height of 0. Free nodes have a height of -1.
+    int height;
+} AabbTreeNode;
+
+struct AabbTree {
+    AabbTreeNode* nodes;
+    int nodes_count;
+    int nodes_capacity;
+    int root;
+    int free_list;
+    float margin;
+    ColliderLeafMap* leaves;
+    ColliderCollection* cache;
+    float* nearest_scratch;
+    int nearest_scratch_capacity;
+};
+
+typedef bool (*AabbTreeVisitor)(Collider* collider, void* ctx);
+
+typedef struct AabbTreeQuery {
+    ColliderCollection* results;
+    Collider* collider;
+    Collider* found;
+    Vector position;
+    RectF bounds;
+    void* ctx;
+    ColliderVisitor visitor;
+    ColliderVectorTest vector_test;
+    ColliderRectFTest rectf_test;
+    ColliderColliderTest collider_test;
+} AabbTreeQuery;
+
+static inline RectF aabb_union(RectF left, RectF right) {
+    float x = SDL_min(left.x, right.x);
+    float y = SDL_min(left.y, right.y);
+
+    return (RectF){
+        x,
+        y,
+        SDL_max(rectf_right(left), rectf_right(right)) - x,
+        SDL_max(rectf_bottom(left), rectf_bottom(right)) - y
+    };
+}
+
+static inline float aabb_perimeter(RectF rect) {
+    return 2 * (rect.w + rect.h);
+}
+
+static inline RectF aabb_fatten(RectF rect, float margin) {
+    return (RectF){
+        rect.x - margin,
+        rect.y - margin,
+        rect.w + margin * 2,
+        rect.h + margin * 2
+    };
+}
+
+static inline bool aabb_node_is_leaf(AabbTreeNode* node) {
+    return node->left == AABB_TREE_NULL_NODE;
+}
+
+static void aabb_tree_grow(AabbTree* tree, int capacity) {
+    tree->nodes = soren_realloc(tree->nodes, capacity * sizeof(*tree->nodes));
+
+    for (int i = tree->nodes_capacity; i < capacity - 1; i++) {
+        tree->nodes[i].next = i + 1;
+        tree->nodes[i].height = -1;
+    }
+
+    tree->nodes[capacity - 1].next = AABB_TREE_NULL_NODE;
+    tree->nodes[capacity - 1].height = -1;
+    tree->free_list = tree->nodes_capacity;
+    tree->nodes_capacity = capacity;
+}
+
+static int aabb_tree_allocate_node(AabbTree* tree) {
+    if (tree->free_list == AABB_TREE_NULL_NODE) {
+        aabb_tree_grow(tree, tree->nodes_capacity * 2);
+    }
+
+    int index = tree->free_list;
+    AabbTreeNode* node = tree->nodes + index;
+    tree->free_list = node->next;
+
+    node->parent = AABB_TREE_NULL_NODE;
+    node->left = AABB_TREE_NULL_NODE;
+    node->right = AABB_TREE_NULL_NODE;
+    node->height = 0;
+    node->collider = NULL;
+    tree->nodes_count++;
+
+    return index;
+}
+
+static void aabb_tree_free_node(AabbTree* tree, int index) {
+    tree->nodes[index].next = tree->free_list;
+    tree->nodes[index].height = -1;
+    tree->nodes[index].collider = NULL;
+    tree->free_list = index;
+    tree->nodes_count--;
+}
+
+// Performs a left or right rotation if the node at a_index is imbalanced.
+// Returns the new root of the subtree.
+static int aabb_tree_balance(AabbTree* tree, int a_index) {
+    AabbTreeNode* a = tree->nodes + a_index;
+    if (aabb_node_is_leaf(a) || a->height < 2) {
+        return a_index;
+    }
+
+    int b_index = a->left;
+    int c_index = a->right;
+    AabbTreeNode* b = tree->nodes + b_index;
+    AabbTreeNode* c = tree->nodes + c_index;
+
+    int balance = c->height - b->height;
+
+    // Rotate c up
+    if (balance > 1) {
+        int f_index = c->left;
+        int g_index = c->right;
+        AabbTreeNode* f = tree->nodes + f_index;
+        AabbTreeNode* g = tree->nodes + g_index;
+
+        c->left = a_index;
+        c->parent = a->parent;
+        a->parent = c_index;
+
+        if (c->parent != AABB_TREE_NULL_NODE) {
+            if (tree->nodes[c->parent].left == a_index) {
+                tree->nodes[c->parent].left = c_index;
+            } else {
+                tree->nodes[c->parent].right = c_index;
+            }
+        } else {
+            tree->root = c_index;
+        }
+
+        if (f->height > g->height) {
+            c->right = f_index;
+            a->right = g_index;
+            g->parent = a_index;
+            a->bounds = aabb_union(b->bounds, g->bounds);
+            c->bounds = aabb_union(a->bounds, f->bounds);
+            a->height = 1 + SDL_max(b->height, g->height);
+            c->height = 1 + SDL_max(a->height, f->height);
+        } else {
+            c->right = g_index;
+            a->right = f_index;
+            f->parent = a_index;
+            a->bounds = aabb_union(b->bounds, f->bounds);
+            c->bounds = aabb_union(a->bounds, g->bounds);
+            a->height = 1 + SDL_max(b->height, f->height);
+            c->height = 1 + SDL_max(a->height, g->height);
+        }
+
+        return c_index;
+    }
+
+    // Rotate b up
+    if (balance < -1) {
+        int d_index = b->left;
+        int e_index = b->right;
+        AabbTreeNode* d = tree->nodes + d_index;
+        AabbTreeNode* e = tree->nodes + e_index;
+
+        b->left = a_index;
+        b->parent = a->parent;
+        a->parent = b_index;
+
+        if (b->parent != AABB_TREE_NULL_NODE) {
+            if (tree->nodes[b->parent].left == a_index) {
+                tree->nodes[b->parent].left = b_index;
+            } else {
+                tree->nodes[b->parent].right = b_index;
+            }
+        } else {
+            tree->root = b_index;
+        }
+
+        if (d->height > e->height) {
+            b->right = d_index;
+            a->left = e_index;
+            e->parent = a_index;
+            a->bounds = aabb_union(c->bounds, e->bounds);
+            b->bounds = aabb_union(a->bounds, d->bounds);
+            a->height = 1 + SDL_max(c->height, e->height);
+            b->height = 1 + SDL_max(a->height, d->height);
+        } else {
+            b->right = e_index;
+            a->left = d_index;
+            d->parent = a_index;
+            a->bounds = aabb_union(c->bounds, d->bounds);
+            b->bounds = aabb_union(a->bounds, e->bounds);
+            a->height = 1 + SDL_max(c->height, d->height);
+            b->height = 1 + SDL_max(a->height, e->height);
+        }
+
+        return b_index;
+    }
+
+    return a_index;
+}
+
+// Walks from the node up to the root, refitting the bounds and
+// rebalancing every ancestor.
+static void aabb_tree_refit(AabbTree* tree, int index) {
+    while (index != AABB_TREE_NULL_NODE) {
+        index = aabb_tree_balance(tree, index);
+
+        AabbTreeNode* node = tree->nodes + index;
+        AabbTreeNode* left = tree->nodes + node->left;
+        AabbTreeNode* right = tree->nodes + node->right;
+
+        node->height = 1 + SDL_max(left->height, right->height);
+        node->bounds = aabb_union(left->bounds, right->bounds);
+
+        index = node->parent;
+    }
+}
+
+static void aabb_tree_insert_leaf(AabbTree* tree, int leaf) {
+    if (tree->root == AABB_TREE_NULL_NODE) {
+        tree->root = leaf;
+        tree->nodes[leaf].parent = AABB_TREE_NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling for the leaf using the surface area heuristic.
+    RectF leaf_bounds = tree->nodes[leaf].bounds;
+    int index = tree->root;
+
+    while (!aabb_node_is_leaf(tree->nodes + index)) {
+        AabbTreeNode* node = tree->nodes + index;
+        AabbTreeNode* left = tree->nodes + node->left;
+        AabbTreeNode* right = tree->nodes + node->right;
+
+        float area = aabb_perimeter(node->bounds);
+        float combined_area = aabb_perimeter(aabb_union(node->bounds, leaf_bounds));
+
+        // Cost of creating a new parent for this node and the new leaf.
+        float cost = 2 * combined_area;
+
+        // Minimum cost of pushing the leaf further down the tree.
+        float inheritance_cost = 2 * (combined_area - area);
+
+        float left_cost = aabb_perimeter(aabb_union(leaf_bounds, left->bounds)) + inheritance_cost;
+        if (!aabb_node_is_leaf(left)) {
+            left_cost -= aabb_perimeter(left->bounds);
+        }
+
+        float right_cost = aabb_perimeter(aabb_union(leaf_bounds, right->bounds)) + inheritance_cost;
+        if (!aabb_node_is_leaf(right)) {
+            right_cost -= aabb_perimeter(right->bounds);
+        }
+
+        if (cost < left_cost && cost < right_cost) {
+            break;
+        }
+
+        index = left_cost < right_cost ? node->left : node->right;
+    }
+
+    int sibling = index;
+
+    // Allocating can move the nodes, so don't hold onto any pointers across it.
+    int new_parent = aabb_tree_allocate_node(tree);
+    int old_parent = tree->nodes[sibling].parent;
+
+    tree->nodes[new_parent].parent = old_parent;
+    tree->nodes[new_parent].bounds = aabb_union(leaf_bounds, tree->nodes[sibling].bounds);
+    tree->nodes[new_parent].height = tree->nodes[sibling].height + 1;
+    tree->nodes[new_parent].left = sibling;
+    tree->nodes[new_parent].right = leaf;
+
+    if (old_parent != AABB_TREE_NULL_NODE) {
+        if (tree->nodes[old_parent].left == sibling) {
+            tree->nodes[old_parent].left = new_parent;
+        } else {
+            tree->nodes[old_parent].right = new_parent;
+        }
+    } else {
+        tree->root = new_parent;
+    }
+
+    tree->nodes[sibling].parent = new_parent;
+    tree->nodes[leaf].parent = new_parent;
+
+    aabb_tree_refit(tree, new_parent);
+}
+
+static void aabb_tree_remove_leaf(AabbTree* tree, int leaf) {
+    if (leaf == tree->root) {
+        tree->root = AABB_TREE_NULL_NODE;
+        return;
+    }
+
+    int parent = tree->nodes[leaf].parent;
+    int grand_parent = tree->nodes[parent].parent;
+    int sibling = tree->nodes[parent].left == leaf
+        ? tree->nodes[parent].right
+        : tree->nodes[parent].left;
+
+    if (grand_parent != AABB_TREE_NULL_NODE) {
+        if (tree->nodes[grand_parent].left == parent) {
+            tree->nodes[grand_parent].left = sibling;
+        } else {
+            tree->nodes[grand_parent].right = sibling;
+        }
+
+        tree->nodes[sibling].parent = grand_parent;
+        aabb_tree_free_node(tree, parent);
+        aabb_tree_refit(tree, grand_parent);
+    } else {
+        tree->root = sibling;
+        tree->nodes[sibling].parent = AABB_TREE_NULL_NODE;
+        aabb_tree_free_node(tree, parent);
+    }
+}
+
+// Visits every collider whose fat bounds overlap the rect.
+// Returns false if the visitor stopped the query early.
+static bool aabb_tree_query(AabbTree* tree, RectF rect, AabbTreeVisitor visitor, void* ctx) {
+    if (tree->root == AABB_TREE_NULL_NODE) {
+        return true;
+    }
+
+    int stack[AABB_TREE_STACK_CAPACITY];
+    int count = 0;
+    stack[count++] = tree->root;
+
+    while (count > 0) {
+        AabbTreeNode* node = tree->nodes + stack[--count];
+
+        if (!rectf_intersects(node->bounds, rect)) {
+            continue;
+        }
+
+        if (aabb_node_is_leaf(node)) {
+            if (!visitor(node->collider, ctx)) {
+                return false;
+            }
+        } else {
+            soren_assert(count + 2 <= AABB_TREE_STACK_CAPACITY);
+            stack[count++] = node->left;
+            stack[count++] = node->right;
+        }
+    }
+
+    return true;
+}
+
+static bool aabb_tree_visit_broadphase(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+    collider_collection_add(query->results, collider);
+    return true;
+}
+
+static bool aabb_tree_visit_broadphase_collider(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+    if (collider == query->collider || collider_should_collide(query->collider, collider)) {
+        collider_collection_add(query->results, collider);
+    }
+
+    return true;
+}
+
+// When a query has no results collection, it stops at the first match.
+static inline bool aabb_tree_query_found(AabbTreeQuery* query, Collider* collider) {
+    if (!query->results) {
+        query->found = collider;
+        return false;
+    }
+
+    collider_collection_add(query->results, collider);
+    return true;
+}
+
+static bool aabb_tree_visit_vector(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+
+    if (collider_contains_point_impl(collider, query->position)
+        && (!query->vector_test || query->vector_test(collider, query->position, query->ctx)))
+    {
+        return aabb_tree_query_found(query, collider);
+    }
+
+    return true;
+}
+
+static bool aabb_tree_visit_rectf(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+
+    if (collider_overlaps(collider, query->bounds)
+        && (!query->rectf_test || query->rectf_test(collider, query->bounds, query->ctx)))
+    {
+        return aabb_tree_query_found(query, collider);
+    }
+
+    return true;
+}
+
+static bool aabb_tree_visit_collider(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+
+    if (collider != query->collider
+        && collider_should_collide(query->collider, collider)
+        && collider_overlaps(query->collider, collider)
+        && (!query->collider_test || query->collider_test(query->collider, collider, query->ctx)))
+    {
+        return aabb_tree_query_found(query, collider);
+    }
+
+    return true;
+}
+
+static bool aabb_tree_visit_for_each_vector(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+    return !collider_overlaps(collider, query->position) || query->visitor(collider, query->ctx);
+}
+
+static bool aabb_tree_visit_for_each_rectf(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+    return !collider_overlaps(collider, query->bounds) || query->visitor(collider, query->ctx);
+}
+
+static bool aabb_tree_visit_for_each_collider(Collider* collider, void* ctx) {
+    AabbTreeQuery* query = ctx;
+
+    if (collider != query->collider
+        && collider_should_collide(query->collider, collider)
+        && collider_overlaps(query->collider, collider))
+    {
+        return query->visitor(collider, query->ctx);
+    }
+
+    return true;
+}
+
+static inline ColliderCollection* aabb_tree_results(AabbTree* tree, ColliderCollection* results) {
+    if (!results) {
+        collider_collection_clear(tree->cache);
+        results = tree->cache;
+    }
+
+    return results;
+}
+
+SOREN_EXPORT AabbTree* aabb_tree_create(float margin) {
+    AabbTree* tree = soren_malloc(sizeof(*tree));
+    tree->nodes = NULL;
+    tree->nodes_count = 0;
+    tree->nodes_capacity = 0;
+    tree->root = AABB_TREE_NULL_NODE;
+    tree->free_list = AABB_TREE_NULL_NODE;
+    tree->margin = margin;
+    tree->leaves = collider_leaf_map_create();
+    tree->cache = collider_collection_create();
+    tree->nearest_scratch = NULL;
+    tree->nearest_scratch_capacity = 0;
+
+    aabb_tree_grow(tree, 16);
+
+    return tree;
+}
+
+SOREN_EXPORT void aabb_tree_free(AabbTree* tree) {
+    soren_free(tree->nodes);
+    collider_leaf_map_free(tree->leaves);
+    collider_collection_free(tree->cache);
+    soren_free(tree->nearest_scratch);
+    soren_free(tree);
+}
+
+SOREN_EXPORT void aabb_tree_add(AabbTree* tree, Collider* collider) {
+    int leaf;
+    if (collider_leaf_map_try_get(tree->leaves, collider, &leaf)) {
+        aabb_tree_update(tree, collider);
+        return;
+    }
+
+    leaf = aabb_tree_allocate_node(tree);
+    tree->nodes[leaf].bounds = aabb_fatten(collider_bounds(collider), tree->margin);
+    tree->nodes[leaf].collider = collider;
+
+    aabb_tree_insert_leaf(tree, leaf);
+    collider_leaf_map_set(tree->leaves, collider, leaf);
+}
+
+SOREN_EXPORT void aabb_tree_remove(AabbTree* tree, Collider* collider) {
+    int leaf;
+    if (!collider_leaf_map_try_get(tree->leaves, collider, &leaf)) {
+        return;
+    }
+
+    collider_leaf_map_remove(tree->leaves, collider);
+    aabb_tree_remove_leaf(tree, leaf);
+    aabb_tree_free_node(tree, leaf);
+}
+
+SOREN_EXPORT void aabb_tree_clear(AabbTree* tree) {
+    for (int i = 0; i < tree->nodes_capacity - 1; i++) {
+        tree->nodes[i].next = i + 1;
+        tree->nodes[i].height = -1;
+        tree->nodes[i].collider = NULL;
+    }
+
+    tree->nodes[tree->nodes_capacity - 1].next = AABB_TREE_NULL_NODE;
+    tree->nodes[tree->nodes_capacity - 1].height = -1;
+    tree->nodes[tree->nodes_capacity - 1].collider = NULL;
+
+    tree->free_list = 0;
+    tree->nodes_count = 0;
+    tree->root = AABB_TREE_NULL_NODE;
+    collider_leaf_map_clear(tree->leaves, true);
+}
+
+SOREN_EXPORT int aabb_tree_count(AabbTree* tree) {
+    return collider_leaf_map_count(tree->leaves);
+}
+
+SOREN_EXPORT int aabb_tree_height(AabbTree* tree) {
+    if (tree->root == AABB_TREE_NULL_NODE) {
+        return 0;
+    }
+
+    return tree->nodes[tree->root].height;
+}
+
+// Refits the collider's leaf if its bounds have left its fat bounds.
+// The displacement is used to extend the fat bounds in the direction of
+// movement so colliders moving in a straight line are refit less often.
+static void aabb_tree_update_impl(AabbTree* tree, Collider* collider, Vector displacement) {
+    int leaf;
+    if (!collider_leaf_map_try_get(tree->leaves, collider, &leaf)) {
+        aabb_tree_add(tree, collider);
+        return;
+    }
+
+    RectF bounds = collider_bounds(collider);
+
+    if (rectf_contains_rectf(tree->nodes[leaf].bounds, bounds)) {
+        return;
+    }
+
+    RectF fat_bounds = aabb_fatten(bounds, tree->margin);
+    displacement = vector_multiply_scalar(displacement, AABB_TREE_DISPLACEMENT_MULTIPLIER);
+
+    if (displacement.x < 0) {
+        fat_bounds.x += displacement.x;
+        fat_bounds.w -= displacement.x;
+    } else {
+        fat_bounds.w += displacement.x;
+    }
+
+    if (displacement.y < 0) {
+        fat_bounds.y += displacement.y;
+        fat_bounds.h -= displacement.y;
+    } else {
+        fat_bounds.h += displacement.y;
+    }
+
+    aabb_tree_remove_leaf(tree, leaf);
+    tree->nodes[leaf].bounds = fat_bounds;
+    aabb_tree_insert_leaf(tree, leaf);
+}
+
+SOREN_EXPORT void aabb_tree_update(AabbTree* tree, Collider* collider) {
+    aabb_tree_update_impl(tree, collider, VECTOR_ZERO);
+}
+
+SOREN_EXPORT void aabb_tree_move(AabbTree* tree, Collider* collider, Vector delta) {
+    collider_set_position(collider, vector_add(delta, collider_position(collider)));
+    aabb_tree_update_impl(tree, collider, delta);
+}
+
+SOREN_EXPORT void aabb_tree_set_position(AabbTree* tree, Collider* collider, Vector position) {
+    Vector delta = vector_subtract(position, collider_position(collider));
+    collider_set_position(collider, position);
+    aabb_tree_update_impl(tree, collider, delta);
+}
+
+SOREN_EXPORT void aabb_tree_rotate(AabbTree* tree, Collider* collider, float delta_rotation) {
+    collider_set_rotation(collider, delta_rotation + collider_rotation(collider));
+    aabb_tree_update(tree, collider);
+}
+
+SOREN_EXPORT void aabb_tree_set_rotation(AabbTree* tree, Collider* collider, float rotation) {
+    collider_set_rotation(collider, rotation);
+    aabb_tree_update(tree, collider);
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_all(AabbTree* tree, ColliderCollection* results) {
+    results = aabb_tree_results(tree, results);
+    Collider* collider;
+
+    map_iter_key_start(tree->leaves, collider) {
+        collider_collection_add(results, collider);
+    }
+    map_iter_end
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_all_ext(AabbTree* tree, ColliderCollection* results, void* ctx, ColliderPredicate predicate) {
+    results = aabb_tree_results(tree, results);
+    Collider* collider;
+
+    map_iter_key_start(tree->leaves, collider) {
+        if (predicate(collider, ctx)) {
+            collider_collection_add(results, collider);
+        }
+    }
+    map_iter_end
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_broadphase_vector(AabbTree* tree, Vector position, ColliderCollection* results) {
+    return aabb_tree_broadphase_rectf(tree, (RectF){ position.x, position.y, 0, 0 }, results);
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_broadphase_rectf(AabbTree* tree, RectF rect, ColliderCollection* results) {
+    AabbTreeQuery query = { .results = aabb_tree_results(tree, results) };
+    aabb_tree_query(tree, rect, aabb_tree_visit_broadphase, &query);
+    return query.results;
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_broadphase_collider(AabbTree* tree, Collider* collider, ColliderCollection* results) {
+    AabbTreeQuery query = {
+        .results = aabb_tree_results(tree, results),
+        .collider = collider
+    };
+
+    aabb_tree_query(tree, collider_bounds(collider), aabb_tree_visit_broadphase_collider, &query);
+    return query.results;
+}
+
+SOREN_EXPORT bool aabb_tree_collides_vector(AabbTree* tree, Vector position) {
+    return aabb_tree_first_vector(tree, position) != NULL;
+}
+
+SOREN_EXPORT bool aabb_tree_collides_vector_ext(AabbTree* tree, Vector position, void* ctx, ColliderVectorTest test) {
+    return aabb_tree_first_vector_ext(tree, position, ctx, test) != NULL;
+}
+
+SOREN_EXPORT bool aabb_tree_collides_rectf(AabbTree* tree, RectF bounds) {
+    return aabb_tree_first_rectf(tree, bounds) != NULL;
+}
+
+SOREN_EXPORT bool aabb_tree_collides_rectf_ext(AabbTree* tree, RectF bounds, void* ctx, ColliderRectFTest test) {
+    return aabb_tree_first_rectf_ext(tree, bounds, ctx, test) != NULL;
+}
+
+SOREN_EXPORT bool aabb_tree_collides_collider(AabbTree* tree, Collider* collider) {
+    return aabb_tree_first_collider(tree, collider) != NULL;
+}
+
+SOREN_EXPORT bool aabb_tree_collides_collider_ext(AabbTree* tree, Collider* collider, void* ctx, ColliderColliderTest test) {
+    return aabb_tree_first_collider_ext(tree, collider, ctx, test) != NULL;
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_vector(AabbTree* tree, ColliderCollection* results, Vector position) {
+    return aabb_tree_collisions_vector_ext(tree, results, position, NULL, NULL);
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_vector_ext(AabbTree* tree, ColliderCollection* results, Vector position, void* ctx, ColliderVectorTest test) {
+    AabbTreeQuery query = {
+        .results = aabb_tree_results(tree, results),
+        .position = position,
+        .ctx = ctx,
+        .vector_test = test
+    };
+
+    aabb_tree_query(tree, (RectF){ position.x, position.y, 0, 0 }, aabb_tree_visit_vector, &query);
+    return query.results;
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_rectf(AabbTree* tree, ColliderCollection* results, RectF bounds) {
+    return aabb_tree_collisions_rectf_ext(tree, results, bounds, NULL, NULL);
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_rectf_ext(AabbTree* tree, ColliderCollection* results, RectF bounds, void* ctx, ColliderRectFTest test) {
+    AabbTreeQuery query = {
+        .results = aabb_tree_results(tree, results),
+        .bounds = bounds,
+        .ctx = ctx,
+        .rectf_test = test
+    };
+
+    aabb_tree_query(tree, bounds, aabb_tree_visit_rectf, &query);
+    return query.results;
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_collider(AabbTree* tree, ColliderCollection* results, Collider* collider) {
+    return aabb_tree_collisions_collider_ext(tree, results, collider, NULL, NULL);
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_collisions_collider_ext(AabbTree* tree, ColliderCollection* results, Collider* collider, void* ctx, ColliderColliderTest test) {
+    AabbTreeQuery query = {
+        .results = aabb_tree_results(tree, results),
+        .collider = collider,
+        .ctx = ctx,
+        .collider_test = test
+    };
+
+    aabb_tree_query(tree, collider_bounds(collider), aabb_tree_visit_collider, &query);
+    return query.results;
+}
+
+SOREN_EXPORT Collider* aabb_tree_first_vector(AabbTree* tree, Vector position) {
+    return aabb_tree_first_vector_ext(tree, position, NULL, NULL);
+}
+
+SOREN_EXPORT Collider* aabb_tree_first_vector_ext(AabbTree* tree, Vector position, void* ctx, ColliderVectorTest test) {
+    AabbTreeQuery query = {
+        .position = position,
+        .ctx = ctx,
+        .vector_test = test
+    };
+
+    aabb_tree_query(tree, (RectF){ position.x, position.y, 0, 0 }, aabb_tree_visit_vector, &query);
+    return query.found;
+}
+
+SOREN_EXPORT Collider* aabb_tree_first_rectf(AabbTree* tree, RectF bounds) {
+    return aabb_tree_first_rectf_ext(tree, bounds, NULL, NULL);
+}
+
+SOREN_EXPORT Collider* aabb_tree_first_rectf_ext(AabbTree* tree, RectF bounds, void* ctx, ColliderRectFTest test) {
+    AabbTreeQuery query = {
+        .bounds = bounds,
+        .ctx = ctx,
+        .rectf_test = test
+    };
+
+    aabb_tree_query(tree, bounds, aabb_tree_visit_rectf, &query);
+    return query.found;
+}
+
+SOREN_EXPORT Collider* aabb_tree_first_collider(AabbTree* tree, Collider* collider) {
+    return aabb_tree_first_collider_ext(tree, collider, NULL, NULL);
+}
+
+SOREN_EXPORT Collider* aabb_tree_first_collider_ext(AabbTree* tree, Collider* collider, void* ctx, ColliderColliderTest test) {
+    AabbTreeQuery query = {
+        .collider = collider,
+        .ctx = ctx,
+        .collider_test = test
+    };
+
+    aabb_tree_query(tree, collider_bounds(collider), aabb_tree_visit_collider, &query);
+    return query.found;
+}
+
+// Each collider is stored in a single leaf, so the for_each queries
+// never need to deduplicate anything.
+
+SOREN_EXPORT bool aabb_tree_for_each_broadphase_rectf(AabbTree* tree, RectF rect, void* ctx, ColliderVisitor visitor) {
+    return aabb_tree_query(tree, rect, visitor, ctx);
+}
+
+SOREN_EXPORT bool aabb_tree_for_each_vector(AabbTree* tree, Vector position, void* ctx, ColliderVisitor visitor) {
+    AabbTreeQuery query = { .position = position, .ctx = ctx, .visitor = visitor };
+    return aabb_tree_query(tree, (RectF){ position.x, position.y, 0, 0 }, aabb_tree_visit_for_each_vector, &query);
+}
+
+SOREN_EXPORT bool aabb_tree_for_each_rectf(AabbTree* tree, RectF bounds, void* ctx, ColliderVisitor visitor) {
+    AabbTreeQuery query = { .bounds = bounds, .ctx = ctx, .visitor = visitor };
+    return aabb_tree_query(tree, bounds, aabb_tree_visit_for_each_rectf, &query);
+}
+
+SOREN_EXPORT bool aabb_tree_for_each_collider(AabbTree* tree, Collider* collider, void* ctx, ColliderVisitor visitor) {
+    AabbTreeQuery query = { .collider = collider, .ctx = ctx, .visitor = visitor };
+    return aabb_tree_query(tree, collider_bounds(collider), aabb_tree_visit_for_each_collider, &query);
+}
+
+SOREN_EXPORT void aabb_tree_find_pairs(AabbTree* tree, ColliderPairList* pairs, bool narrowphase) {
+    if (tree->root == AABB_TREE_NULL_NODE) {
+        return;
+    }
+
+    int stack[AABB_TREE_STACK_CAPACITY];
+
+    for (int leaf = 0; leaf < tree->nodes_capacity; leaf++) {
+        AabbTreeNode* node = tree->nodes + leaf;
+        if (node->height != 0) {
+            continue;
+        }
+
+        int count = 0;
+        stack[count++] = tree->root;
+
+        while (count > 0) {
+            int index = stack[--count];
+            AabbTreeNode* other = tree->nodes + index;
+
+            if (!rectf_intersects(node->bounds, other->bounds)) {
+                continue;
+            }
+
+            if (aabb_node_is_leaf(other)) {
+                // Every pair is visited from both leaves, so only report it from the lower one.
+                if (index > leaf
+                    && collider_should_collide(node->collider, other->collider)
+                    && (!narrowphase || collider_overlaps_collider_impl(node->collider, other->collider)))
+                {
+                    collider_pair_list_add(pairs, (ColliderPair){ node->collider, other->collider });
+                }
+            } else {
+                soren_assert(count + 2 <= AABB_TREE_STACK_CAPACITY);
+                stack[count++] = other->left;
+                stack[count++] = other->right;
+            }
+        }
+    }
+}
+
+// Returns how far along the segment (from 0 to 1) it enters the rect,
+// or FLT_MAX if it misses the rect entirely.
+static float aabb_segment_entry(RectF rect, Vector start, Vector delta) {
+    float t_min = 0;
+    float t_max = 1;
+
+    if (delta.x == 0) {
+        if (start.x < rectf_left(rect) || start.x > rectf_right(rect)) {
+            return FLT_MAX;
+        }
+    } else {
+        float t1 = (rectf_left(rect) - start.x) / delta.x;
+        float t2 = (rectf_right(rect) - start.x) / delta.x;
+        t_min = SDL_max(t_min, SDL_min(t1, t2));
+        t_max = SDL_min(t_max, SDL_max(t1, t2));
+    }
+
+    if (delta.y == 0) {
+        if (start.y < rectf_top(rect) || start.y > rectf_bottom(rect)) {
+            return FLT_MAX;
+        }
+    } else {
+        float t1 = (rectf_top(rect) - start.y) / delta.y;
+        float t2 = (rectf_bottom(rect) - start.y) / delta.y;
+        t_min = SDL_max(t_min, SDL_min(t1, t2));
+        t_max = SDL_min(t_max, SDL_max(t1, t2));
+    }
+
+    return t_min <= t_max ? t_min : FLT_MAX;
+}
+
+// If results is set, every collider that's hit is added to it.
+// Otherwise only the nearest hit is kept, and any node that the segment
+// enters after the nearest hit is skipped.
+static Collider* aabb_tree_linecast_impl(AabbTree* tree, Vector start, Vector end, ColliderCollection* results, RaycastHit* out_hit) {
+    Collider* nearest = NULL;
+    RaycastHit nearest_hit = (RaycastHit){ .fraction = FLT_MAX };
+
+    if (tree->root == AABB_TREE_NULL_NODE || vector_equals(start, end)) {
+        return NULL;
+    }
+
+    Vector delta = vector_subtract(end, start);
+    int stack[AABB_TREE_STACK_CAPACITY];
+    int count = 0;
+    stack[count++] = tree->root;
+
+    while (count > 0) {
+        AabbTreeNode* node = tree->nodes + stack[--count];
+
+        float entry = aabb_segment_entry(node->bounds, start, delta);
+        if (entry > 1 || (!results && entry > nearest_hit.fraction)) {
+            continue;
+        }
+
+        if (aabb_node_is_leaf(node)) {
+            RaycastHit hit = (RaycastHit){0};
+            if (collider_collides_line_impl(node->collider, start, end, &hit)) {
+                if (results) {
+                    collider_collection_add(results, node->collider);
+                } else if (hit.fraction < nearest_hit.fraction) {
+                    nearest = node->collider;
+                    nearest_hit = hit;
+                }
+            }
+        } else {
+            soren_assert(count + 2 <= AABB_TREE_STACK_CAPACITY);
+            stack[count++] = node->left;
+            stack[count++] = node->right;
+        }
+    }
+
+    if (nearest && out_hit) {
+        *out_hit = nearest_hit;
+    }
+
+    return nearest;
+}
+
+SOREN_EXPORT Collider* aabb_tree_raycast(AabbTree* tree, Vector origin, Vector direction, float distance, RaycastHit* out_hit) {
+    Vector end = vector_add(origin, vector_multiply_scalar(vector_normalize(direction), distance));
+    return aabb_tree_linecast_first(tree, origin, end, out_hit);
+}
+
+SOREN_EXPORT Collider* aabb_tree_linecast_first(AabbTree* tree, Vector start, Vector end, RaycastHit* out_hit) {
+    return aabb_tree_linecast_impl(tree, start, end, NULL, out_hit);
+}
+
+SOREN_EXPORT ColliderCollection* aabb_tree_linecast_all(AabbTree* tree, ColliderCollection* results, Vector start, Vector end) {
+    results = aabb_tree_results(tree, results);
+    aabb_tree_linecast_impl(tree, start, end, results, NULL);
+    return results;
+}
+
+SOREN_EXPORT Collider* aabb_tree_cast_collider(AabbTree* tree, Collider* collider, Vector delta, RaycastHit* out_hit) {
+    Collider* nearest = NULL;
+    RaycastHit nearest_hit = (RaycastHit){ .fraction = FLT_MAX };
+
+    if (tree->root == AABB_TREE_NULL_NODE) {
+        return NULL;
+    }
+
+    RectF bounds = collider_bounds(collider);
+    RectF swept = aabb_union(bounds, (RectF){ bounds.x + delta.x, bounds.y + delta.y, bounds.w, bounds.h });
+
+    int stack[AABB_TREE_STACK_CAPACITY];
+    int count = 0;
+    stack[count++] = tree->root;
+
+    while (count > 0) {
+        AabbTreeNode* node = tree->nodes + stack[--count];
+
+        if (!rectf_intersects(node->bounds, swept)) {
+            continue;
+        }
+
+        if (aabb_node_is_leaf(node)) {
+            RaycastHit hit;
+            if (node->collider != collider
+                && collider_should_collide(collider, node->collider)
+                && collision_cast_collider(collider, delta, node->collider, &hit)
+                && hit.fraction < nearest_hit.fraction)
+            {
+                nearest = node->collider;
+                nearest_hit = hit;
+            }
+        } else {
+            soren_assert(count + 2 <= AABB_TREE_STACK_CAPACITY);
+            stack[count++] = node->left;
+            stack[count++] = node->right;
+        }
+    }
+
+    if (nearest && out_hit) {
+        *out_hit = nearest_hit;
+    }
+
+    return nearest;
+}
+
+SOREN_EXPORT Collider* aabb_tree_nearest(AabbTree* tree, Vector point, float max_distance, void* ctx, ColliderPredicate predicate) {
+    Collider* result = NULL;
+    aabb_tree_k_nearest(tree, point, max_distance, 1, &result, NULL, ctx, predicate);
+    return result;
+}
+
+SOREN_EXPORT int aabb_tree_k_nearest(
+    AabbTree* tree,
+    Vector point,
+    float max_distance,
+    int k,
+    Collider** out_colliders,
+    float* out_distances,
+    void* ctx,
+    ColliderPredicate predicate)
+{
+    if (tree->root == AABB_TREE_NULL_NODE || k <= 0) {
+        return 0;
+    }
+
+    if (!out_distances) {
+        if (k > tree->nearest_scratch_capacity) {
+            tree->nearest_scratch_capacity = k;
+            tree->nearest_scratch = soren_realloc(tree->nearest_scratch, k * sizeof(*tree->nearest_scratch));
+        }
+
+        out_distances = tree->nearest_scratch;
+    }
+
+    NearestColliders nearest = {
+        .colliders = out_colliders,
+        .distances = out_distances,
+        .capacity = k,
+        .count = 0,
+        .max_distance = max_distance
+    };
+
+    int stack[AABB_TREE_STACK_CAPACITY];
+    int count = 0;
+    stack[count++] = tree->root;
+
+    while (count > 0) {
+        AabbTreeNode* node = tree->nodes + stack[--count];
+
+        // A node can't contain anything closer than its bounds.
+        if (rectf_point_distance(node->bounds, point) > nearest_colliders_threshold(&nearest)) {
+            continue;
+        }
+
+        if (aabb_node_is_leaf(node)) {
+            if (!predicate || predicate(node->collider, ctx)) {
+                nearest_colliders_add(&nearest, node->collider, collider_point_distance(node->collider, point));
+            }
+        } else {
+            soren_assert(count + 2 <= AABB_TREE_STACK_CAPACITY);
+
+            // Visit the closer child first so the threshold shrinks sooner.
+            int left = node->left;
+            int right = node->right;
+            if (rectf_point_distance(tree->nodes[left].bounds, point) < rectf_point_distance(tree->nodes[right].bounds, point)) {
+                stack[count++] = right;
+                stack[count++] = left;
+            } else {
+                stack[count++] = left;
+                stack[count++] = right;
+            }
+        }
+    }
+
+    return nearest.count;
+}
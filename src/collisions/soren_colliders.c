@@ -1,5 +1,7 @@
 #include <collisions/soren_colliders.h>
 #include <collisions/soren_collisions.h>
+#include <collisions/soren_collision_utils.h>
+#include <collisions/soren_gjk.h>
 
 #include "soren_collisions_shared.h"
 
@@ -11,10 +13,21 @@ void collider_assert_scale(float scale) {
     }
 }
 
+static SDL_AtomicInt collider_query_epoch_blocks = { 0 };
+
+uint64_t collider_reserve_query_epochs(void) {
+    return (uint64_t)(SDL_AddAtomicInt(&collider_query_epoch_blocks, 1) + 1) << 32;
+}
+
 SOREN_EXPORT void collider_init(Collider* collider, ColliderType type) {
     collider->collider_type = type;
     collider->tag = NULL;
     collider->id = 0;
+    collider->category = COLLIDER_CATEGORY_DEFAULT;
+    collider->mask = COLLIDER_MASK_ALL;
+    collider->query_epoch = 0;
+    collider->bounds = RECTF_EMPTY;
+    collider->bounds_dirty = true;
 }
 
 SOREN_EXPORT void collider_free(Collider* collider) {
@@ -47,6 +60,8 @@ SOREN_EXPORT float collider_rotation_impl(Collider* collider) {
             return line_collider_rotation((LineCollider*)collider);
         case COLLIDER_CIRCLE:
             return circle_collider_rotation((CircleCollider*)collider);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_rotation((CapsuleCollider*)collider);
         case COLLIDER_BOX:
             return box_collider_rotation((BoxCollider*)collider);
         case COLLIDER_POLYGON:
@@ -67,6 +82,9 @@ SOREN_EXPORT void collider_set_rotation_impl(Collider* collider, float rotation)
         case COLLIDER_CIRCLE:
             circle_collider_set_rotation((CircleCollider*)collider, rotation);
             break;
+        case COLLIDER_CAPSULE:
+            capsule_collider_set_rotation((CapsuleCollider*)collider, rotation);
+            break;
         case COLLIDER_BOX:
             box_collider_set_rotation((BoxCollider*)collider, rotation);
             break;
@@ -86,6 +104,8 @@ SOREN_EXPORT float collider_scale_impl(Collider* collider) {
             return line_collider_scale((LineCollider*)collider);
         case COLLIDER_CIRCLE:
             return circle_collider_scale((CircleCollider*)collider);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_scale((CapsuleCollider*)collider);
         case COLLIDER_BOX:
             return box_collider_scale((BoxCollider*)collider);
         case COLLIDER_POLYGON:
@@ -106,6 +126,9 @@ SOREN_EXPORT void collider_set_scale_impl(Collider* collider, float scale) {
         case COLLIDER_CIRCLE:
             circle_collider_set_scale((CircleCollider*)collider, scale);
             break;
+        case COLLIDER_CAPSULE:
+            capsule_collider_set_scale((CapsuleCollider*)collider, scale);
+            break;
         case COLLIDER_BOX:
             box_collider_set_scale((BoxCollider*)collider, scale);
             break;
@@ -125,6 +148,8 @@ SOREN_EXPORT Vector collider_position_impl(Collider* collider) {
             return line_collider_position((LineCollider*)collider);
         case COLLIDER_CIRCLE:
             return circle_collider_position((CircleCollider*)collider);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_position((CapsuleCollider*)collider);
         case COLLIDER_BOX:
             return box_collider_position((BoxCollider*)collider);
         case COLLIDER_POLYGON:
@@ -145,6 +170,9 @@ SOREN_EXPORT void collider_set_position_impl(Collider* collider, Vector position
         case COLLIDER_CIRCLE:
             circle_collider_set_position((CircleCollider*)collider, position);
             break;
+        case COLLIDER_CAPSULE:
+            capsule_collider_set_position((CapsuleCollider*)collider, position);
+            break;
         case COLLIDER_BOX:
             box_collider_set_position((BoxCollider*)collider, position);
             break;
@@ -157,6 +185,10 @@ SOREN_EXPORT void collider_set_position_impl(Collider* collider, Vector position
 }
 
 SOREN_EXPORT RectF collider_bounds_impl(Collider* collider) {
+    if (!collider->bounds_dirty) {
+        return collider->bounds;
+    }
+
     switch(collider->collider_type) {
         case COLLIDER_POINT:
             return point_collider_bounds((PointCollider*)collider);
@@ -164,6 +196,8 @@ SOREN_EXPORT RectF collider_bounds_impl(Collider* collider) {
             return line_collider_bounds((LineCollider*)collider);
         case COLLIDER_CIRCLE:
             return circle_collider_bounds((CircleCollider*)collider);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_bounds((CapsuleCollider*)collider);
         case COLLIDER_BOX:
             return box_collider_bounds((BoxCollider*)collider);
         case COLLIDER_POLYGON:
@@ -184,6 +218,9 @@ SOREN_EXPORT void collider_debug_draw_impl(Collider* collider, SDL_Renderer* ren
         case COLLIDER_CIRCLE:
             circle_collider_debug_draw((CircleCollider*)collider, renderer, color);
             break;
+        case COLLIDER_CAPSULE:
+            capsule_collider_debug_draw((CapsuleCollider*)collider, renderer, color);
+            break;
         case COLLIDER_BOX:
             box_collider_debug_draw((BoxCollider*)collider, renderer, color);
             break;
@@ -204,6 +241,8 @@ SOREN_EXPORT bool collider_overlaps_rect_impl(Collider* collider, RectF rect) {
             return line_collider_overlaps_rect((LineCollider*)collider, rect);
         case COLLIDER_CIRCLE:
             return circle_collider_overlaps_rect((CircleCollider*)collider, rect);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_overlaps_rect((CapsuleCollider*)collider, rect);
         case COLLIDER_BOX:
             return box_collider_overlaps_rect((BoxCollider*)collider, rect);
         case COLLIDER_POLYGON:
@@ -217,6 +256,10 @@ SOREN_EXPORT bool collider_overlaps_rect_impl(Collider* collider, RectF rect) {
 }
 
 SOREN_EXPORT bool collider_overlaps_collider_impl(Collider* collider, Collider* other) {
+    if (collision_backend() == COLLISION_BACKEND_GJK && collision_gjk_supports(collider) && collision_gjk_supports(other)) {
+        return collision_gjk(collider, other);
+    }
+
     switch (collider->collider_type) {
         case COLLIDER_POINT:
             return point_collider_overlaps_collider((PointCollider*)collider, other);
@@ -224,6 +267,8 @@ SOREN_EXPORT bool collider_overlaps_collider_impl(Collider* collider, Collider*
             return line_collider_overlaps_collider((LineCollider*)collider, other);
         case COLLIDER_CIRCLE:
             return circle_collider_overlaps_collider((CircleCollider*)collider, other);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_overlaps_collider((CapsuleCollider*)collider, other);
         case COLLIDER_BOX:
             return box_collider_overlaps_collider((BoxCollider*)collider, other);
         case COLLIDER_POLYGON:
@@ -244,6 +289,8 @@ SOREN_EXPORT bool collider_overlaps_line_impl(Collider* collider, Vector start,
             return line_collider_overlaps_line((LineCollider*)collider, start, end);
         case COLLIDER_CIRCLE:
             return circle_collider_overlaps_line((CircleCollider*)collider, start, end);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_overlaps_line((CapsuleCollider*)collider, start, end);
         case COLLIDER_BOX:
             return box_collider_overlaps_line((BoxCollider*)collider, start, end);
         case COLLIDER_POLYGON:
@@ -264,6 +311,8 @@ SOREN_EXPORT bool collider_contains_point_impl(Collider* collider, Vector point)
             return line_collider_contains_point((LineCollider*)collider, point);
         case COLLIDER_CIRCLE:
             return circle_collider_contains_point((CircleCollider*)collider, point);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_contains_point((CapsuleCollider*)collider, point);
         case COLLIDER_BOX:
             return box_collider_contains_point((BoxCollider*)collider, point);
         case COLLIDER_POLYGON:
@@ -284,6 +333,8 @@ SOREN_EXPORT bool collider_collides_rect_impl(Collider* collider, RectF rect, Co
             return line_collider_collides_rect((LineCollider*)collider, rect, out_result);
         case COLLIDER_CIRCLE:
             return circle_collider_collides_rect((CircleCollider*)collider, rect, out_result);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_collides_rect((CapsuleCollider*)collider, rect, out_result);
         case COLLIDER_BOX:
             return box_collider_collides_rect((BoxCollider*)collider, rect, out_result);
         case COLLIDER_POLYGON:
@@ -297,6 +348,10 @@ SOREN_EXPORT bool collider_collides_rect_impl(Collider* collider, RectF rect, Co
 }
 
 SOREN_EXPORT bool collider_collides_collider_impl(Collider* collider, Collider* other, CollisionResult* out_result, RaycastHit* out_hit) {
+    if (collision_backend() == COLLISION_BACKEND_GJK && collision_gjk_supports(collider) && collision_gjk_supports(other)) {
+        return collision_gjk_ext(collider, other, out_result);
+    }
+
     switch (collider->collider_type) {
         case COLLIDER_POINT:
             return point_collider_collides_collider((PointCollider*)collider, other, out_result, out_hit);
@@ -304,6 +359,8 @@ SOREN_EXPORT bool collider_collides_collider_impl(Collider* collider, Collider*
             return line_collider_collides_collider((LineCollider*)collider, other, out_result, out_hit);
         case COLLIDER_CIRCLE:
             return circle_collider_collides_collider((CircleCollider*)collider, other, out_result, out_hit);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_collides_collider((CapsuleCollider*)collider, other, out_result, out_hit);
         case COLLIDER_BOX:
             return box_collider_collides_collider((BoxCollider*)collider, other, out_result, out_hit);
         case COLLIDER_POLYGON:
@@ -324,6 +381,8 @@ SOREN_EXPORT bool collider_collides_line_impl(Collider* collider, Vector start,
             return line_collider_collides_line((LineCollider*)collider, start, end, out_result);
         case COLLIDER_CIRCLE:
             return circle_collider_collides_line((CircleCollider*)collider, start, end, out_result);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_collides_line((CapsuleCollider*)collider, start, end, out_result);
         case COLLIDER_BOX:
             return box_collider_collides_line((BoxCollider*)collider, start, end, out_result);
         case COLLIDER_POLYGON:
@@ -344,6 +403,8 @@ SOREN_EXPORT bool collider_collides_point_impl(Collider* collider, Vector point,
             return line_collider_collides_point((LineCollider*)collider, point, out_result);
         case COLLIDER_CIRCLE:
             return circle_collider_collides_point((CircleCollider*)collider, point, out_result);
+        case COLLIDER_CAPSULE:
+            return capsule_collider_collides_point((CapsuleCollider*)collider, point, out_result);
         case COLLIDER_BOX:
             return box_collider_collides_point((BoxCollider*)collider, point, out_result);
         case COLLIDER_POLYGON:
@@ -355,3 +416,77 @@ SOREN_EXPORT bool collider_collides_point_impl(Collider* collider, Vector point,
 
     return false;
 }
+
+static float polygon_collider_point_distance(PolygonCollider* polygon, Vector point) {
+    if (polygon_collider_contains_point(polygon, point)) {
+        return 0;
+    }
+
+    int count;
+    Vector* points = polygon_collider_points(polygon, &count);
+    Vector offset = vector_subtract(polygon_collider_position(polygon), polygon_collider_center(polygon));
+
+    float distance_squared;
+    collisions_get_closest_point_on_polygon_to_point(points, count, vector_subtract(point, offset), &distance_squared);
+
+    return SDL_sqrtf(distance_squared);
+}
+
+// The distance from the point to the closest point on the collider, or 0 if the point is inside of it.
+float collider_point_distance(Collider* collider, Vector point) {
+    switch (collider->collider_type) {
+        case COLLIDER_POINT:
+            PointCollider* point_collider = (PointCollider*)collider;
+            if (point_collider_using_internal_collider(point_collider)) {
+                return polygon_collider_point_distance((PolygonCollider*)point_collider->box, point);
+            }
+
+            return vector_distance(point, point_collider_position(point_collider));
+        case COLLIDER_LINE:
+            LineCollider* line = (LineCollider*)collider;
+            Vector closest = collisions_closest_point_on_line(line_collider_adjusted_start(line), line_collider_adjusted_end(line), point);
+            return vector_distance(point, closest);
+        case COLLIDER_CIRCLE:
+            CircleCollider* circle = (CircleCollider*)collider;
+            return SDL_max(0, vector_distance(point, circle_collider_position(circle)) - circle_collider_radius(circle));
+        case COLLIDER_CAPSULE:
+            CapsuleCollider* capsule = (CapsuleCollider*)collider;
+            Vector capsule_closest = collision_closest_point_on_segment(capsule_collider_start(capsule), capsule_collider_end(capsule), point);
+            return SDL_max(0, vector_distance(point, capsule_closest) - capsule_collider_radius(capsule));
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            return polygon_collider_point_distance((PolygonCollider*)collider, point);
+        default:
+            throw(InvalidColliderType, "Invalid collider type");
+            break;
+    }
+
+    return 0;
+}
+
+SOREN_EXPORT float collider_distance_impl(Collider* collider, Collider* other) {
+    return collision_gjk_distance(collider, other, NULL, NULL);
+}
+
+SOREN_EXPORT void collider_clean_impl(Collider* collider) {
+    switch (collider->collider_type) {
+        case COLLIDER_POINT:
+            PointCollider* point = (PointCollider*)collider;
+            if (point_collider_using_internal_collider(point)) {
+                polygon_collider_clean((PolygonCollider*)point->box);
+            }
+            break;
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            polygon_collider_clean((PolygonCollider*)collider);
+            return;
+    }
+
+    collider_bounds_impl(collider);
+}
+
+SOREN_EXPORT void collider_clean_batch(Collider** colliders, int count) {
+    for (int i = 0; i < count; i++) {
+        collider_clean_impl(colliders[i]);
+    }
+}
@@ -10,6 +10,8 @@ static void box_collider_set_size_impl(
 {
     box->size = vector_create(width, height);
     box->base.dirty = true;
+    box->base.base.bounds_dirty = true;
+    box->base.axes_dirty = true;
     box->base.original_points[1].x = width;
     box->base.original_points[2] = vector_create(width, height);
     box->base.original_points[3].y = height;
@@ -141,6 +143,13 @@ SOREN_EXPORT bool box_collider_overlaps_rect(BoxCollider* collider, RectF rect)
 
 SOREN_EXPORT bool box_collider_overlaps_collider(BoxCollider* collider, Collider* other) {
     if (collider_rotation(collider) != 0) {
+        switch (other->collider_type) {
+            case COLLIDER_CIRCLE:
+                return collision_circle_to_box((CircleCollider*)other, collider);
+            case COLLIDER_BOX:
+                return collision_box_to_box(collider, (BoxCollider*)other);
+        }
+
         return polygon_collider_overlaps_collider((PolygonCollider*)collider, other);
     }
 
@@ -155,12 +164,7 @@ SOREN_EXPORT bool box_collider_overlaps_collider(BoxCollider* collider, Collider
         case COLLIDER_CIRCLE:
             return collision_circle_to_box((CircleCollider*)other, collider);
         case COLLIDER_BOX:
-            BoxCollider* box = (BoxCollider*)other;
-            if (collider_rotation(box) == 0) {
-                return collision_box_to_box(collider, box);
-            } else {
-                return collision_polygon_to_polygon((PolygonCollider*)collider, (PolygonCollider*)box);
-            }
+            return collision_box_to_box(collider, (BoxCollider*)other);
     }
 
     return polygon_collider_overlaps_collider((PolygonCollider*)collider, other);
@@ -188,6 +192,19 @@ SOREN_EXPORT bool box_collider_collides_rect(BoxCollider* collider, RectF rect,
 
 SOREN_EXPORT bool box_collider_collides_collider(BoxCollider* collider, Collider* other, CollisionResult* out_result, RaycastHit* out_hit) {
     if (collider_rotation(collider) != 0) {
+        switch (other->collider_type) {
+            case COLLIDER_CIRCLE:
+                // Matches the direction of the results from polygon_collider_collides_collider.
+                bool result = collision_circle_to_box_ext((CircleCollider*)other, collider, out_result);
+                if (result && out_result) {
+                    collision_result_invert(out_result);
+                }
+
+                return result;
+            case COLLIDER_BOX:
+                return collision_box_to_box_ext(collider, (BoxCollider*)other, out_result);
+        }
+
         return polygon_collider_collides_collider((PolygonCollider*)collider, other, out_result, out_hit);
     }
 
@@ -202,12 +219,7 @@ SOREN_EXPORT bool box_collider_collides_collider(BoxCollider* collider, Collider
         case COLLIDER_CIRCLE:
             return collision_circle_to_box_ext((CircleCollider*)other, collider, out_result);
         case COLLIDER_BOX:
-            BoxCollider* box = (BoxCollider*)other;
-            if (collider_rotation(box) == 0) {
-                return collision_box_to_box_ext(collider, box, out_result);
-            } else {
-                return collision_polygon_to_polygon_ext((PolygonCollider*)collider, (PolygonCollider*)box, out_result);
-            }
+            return collision_box_to_box_ext(collider, (BoxCollider*)other, out_result);
     }
 
     return polygon_collider_collides_collider((PolygonCollider*)collider, other, out_result, out_hit);
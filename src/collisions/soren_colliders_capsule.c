@@ -0,0 +1,201 @@
+#include <collisions/soren_colliders.h>
+#include <collisions/soren_collisions.h>
+#include <graphics/soren_primitives.h>
+
+SOREN_EXPORT CapsuleCollider* capsule_collider_create(float radius, float height) {
+    CapsuleCollider* collider = soren_malloc(sizeof(*collider));
+    if (!collider)
+        return NULL;
+
+    capsule_collider_init(collider, radius, height);
+    return collider;
+}
+
+SOREN_EXPORT void capsule_collider_init(CapsuleCollider* capsule, float radius, float height) {
+    E4C_ASSERT(capsule);
+    collider_init((Collider*)capsule, COLLIDER_CAPSULE);
+    capsule->radius = radius;
+    capsule->height = height;
+    capsule->position = (Vector){0};
+    capsule->axis = (Vector){ 0, 1 };
+    capsule->rotation = 0;
+    capsule->scale = 1;
+}
+
+SOREN_EXPORT float capsule_collider_rotation(CapsuleCollider* capsule) {
+    return capsule->rotation;
+}
+
+SOREN_EXPORT void capsule_collider_set_rotation(CapsuleCollider* capsule, float rotation) {
+    capsule->rotation = rotation;
+    capsule->axis = (Vector){ -SDL_sinf(rotation), SDL_cosf(rotation) };
+    capsule->base.bounds_dirty = true;
+}
+
+SOREN_EXPORT float capsule_collider_scale(CapsuleCollider* capsule) {
+    return capsule->scale;
+}
+
+SOREN_EXPORT void capsule_collider_set_scale(CapsuleCollider* capsule, float scale) {
+    capsule->scale = scale;
+    capsule->base.bounds_dirty = true;
+}
+
+SOREN_EXPORT Vector capsule_collider_position(CapsuleCollider* capsule) {
+    return capsule->position;
+}
+
+SOREN_EXPORT void capsule_collider_set_position(CapsuleCollider* capsule, Vector position) {
+    capsule->position = position;
+    capsule->base.bounds_dirty = true;
+}
+
+SOREN_EXPORT RectF capsule_collider_bounds(CapsuleCollider* capsule) {
+    if (capsule->base.bounds_dirty) {
+        float radius = capsule_collider_radius(capsule);
+        Vector start = capsule_collider_start(capsule);
+        Vector end = capsule_collider_end(capsule);
+        float left = SDL_min(start.x, end.x) - radius;
+        float top = SDL_min(start.y, end.y) - radius;
+
+        capsule->base.bounds = (RectF){
+            left,
+            top,
+            SDL_max(start.x, end.x) + radius - left,
+            SDL_max(start.y, end.y) + radius - top
+        };
+        capsule->base.bounds_dirty = false;
+    }
+
+    return capsule->base.bounds;
+}
+
+SOREN_EXPORT void capsule_collider_debug_draw(CapsuleCollider* capsule, SDL_Renderer* renderer, SDL_FColor color) {
+    float radius = capsule_collider_radius(capsule);
+    Vector start = capsule_collider_start(capsule);
+    Vector end = capsule_collider_end(capsule);
+    Vector side = vector_multiply_scalar((Vector){ -capsule->axis.y, capsule->axis.x }, radius);
+    float angle = SDL_atan2f(capsule->axis.y, capsule->axis.x);
+
+    draw_arc_color(renderer, end, radius, angle - SDL_PI_F / 2, angle + SDL_PI_F / 2, 1, CIRCLE_SEGMENT_AUTO, color);
+    draw_arc_color(renderer, start, radius, angle + SDL_PI_F / 2, angle + SDL_PI_F * 3 / 2, 1, CIRCLE_SEGMENT_AUTO, color);
+    draw_line_color(renderer, vector_add(start, side), vector_add(end, side), 1, color);
+    draw_line_color(renderer, vector_subtract(start, side), vector_subtract(end, side), 1, color);
+}
+
+SOREN_EXPORT float capsule_collider_radius(CapsuleCollider* capsule) {
+    return capsule->radius * capsule->scale;
+}
+
+SOREN_EXPORT float capsule_collider_original_radius(CapsuleCollider* capsule) {
+    return capsule->radius;
+}
+
+SOREN_EXPORT void capsule_collider_set_original_radius(CapsuleCollider* capsule, float value) {
+    capsule->radius = value;
+    capsule->base.bounds_dirty = true;
+}
+
+SOREN_EXPORT float capsule_collider_height(CapsuleCollider* capsule) {
+    return capsule->height * capsule->scale;
+}
+
+SOREN_EXPORT float capsule_collider_original_height(CapsuleCollider* capsule) {
+    return capsule->height;
+}
+
+SOREN_EXPORT void capsule_collider_set_original_height(CapsuleCollider* capsule, float value) {
+    capsule->height = value;
+    capsule->base.bounds_dirty = true;
+}
+
+// The caps take up the radius at each end, so a capsule that's no taller
+// than it is wide is a circle and its segment is a single point.
+static inline Vector capsule_collider_half_segment(CapsuleCollider* capsule) {
+    float half = SDL_max(0, capsule_collider_height(capsule) / 2 - capsule_collider_radius(capsule));
+    return vector_multiply_scalar(capsule->axis, half);
+}
+
+SOREN_EXPORT Vector capsule_collider_start(CapsuleCollider* capsule) {
+    return vector_subtract(capsule->position, capsule_collider_half_segment(capsule));
+}
+
+SOREN_EXPORT Vector capsule_collider_end(CapsuleCollider* capsule) {
+    return vector_add(capsule->position, capsule_collider_half_segment(capsule));
+}
+
+SOREN_EXPORT bool capsule_collider_overlaps_rect(CapsuleCollider* collider, RectF rect) {
+    return collision_capsule_to_rect(collider, rect);
+}
+
+SOREN_EXPORT bool capsule_collider_overlaps_collider(CapsuleCollider* collider, Collider* other) {
+    switch (other->collider_type) {
+        case COLLIDER_POINT:
+            PointCollider* point = (PointCollider*)other;
+            if (point_collider_using_internal_collider(point)) {
+                return capsule_collider_overlaps_collider(collider, (Collider*)point->box);
+            } else {
+                return capsule_collider_contains_point(collider, point_collider_position(point));
+            }
+        case COLLIDER_LINE:
+            return collision_line_to_capsule((LineCollider*)other, collider);
+        case COLLIDER_CIRCLE:
+            return collision_capsule_to_circle(collider, (CircleCollider*)other);
+        case COLLIDER_CAPSULE:
+            return collision_capsule_to_capsule(collider, (CapsuleCollider*)other);
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            return collision_capsule_to_polygon(collider, (PolygonCollider*)other);
+        default:
+            throw(InvalidColliderType, "Invalid collider for capsule overlap check.");
+            break;
+    }
+
+    return false;
+}
+
+SOREN_EXPORT bool capsule_collider_overlaps_line(CapsuleCollider* collider, Vector start, Vector end) {
+    return collision_segment_to_capsule(start, end, collider);
+}
+
+SOREN_EXPORT bool capsule_collider_contains_point(CapsuleCollider* collider, Vector point) {
+    return collision_point_to_capsule(point, collider);
+}
+
+SOREN_EXPORT bool capsule_collider_collides_rect(CapsuleCollider* collider, RectF rect, CollisionResult* out_result) {
+    return collision_capsule_to_rect_ext(collider, rect, out_result);
+}
+
+SOREN_EXPORT bool capsule_collider_collides_collider(CapsuleCollider* collider, Collider* other, CollisionResult* out_result, RaycastHit* out_hit) {
+    switch (other->collider_type) {
+        case COLLIDER_POINT:
+            PointCollider* point = (PointCollider*)other;
+            if (point_collider_using_internal_collider(point)) {
+                return capsule_collider_collides_collider(collider, (Collider*)point->box, out_result, out_hit);
+            } else {
+                return capsule_collider_collides_point(collider, point_collider_position(point), out_result);
+            }
+        case COLLIDER_LINE:
+            return collision_line_to_capsule_ext((LineCollider*)other, collider, out_hit);
+        case COLLIDER_CIRCLE:
+            return collision_capsule_to_circle_ext(collider, (CircleCollider*)other, out_result);
+        case COLLIDER_CAPSULE:
+            return collision_capsule_to_capsule_ext(collider, (CapsuleCollider*)other, out_result);
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            return collision_capsule_to_polygon_ext(collider, (PolygonCollider*)other, out_result);
+        default:
+            throw(InvalidColliderType, "Invalid collider for capsule collides check.");
+            break;
+    }
+
+    return false;
+}
+
+SOREN_EXPORT bool capsule_collider_collides_line(CapsuleCollider* collider, Vector start, Vector end, RaycastHit* out_result) {
+    return collision_segment_to_capsule_ext(start, end, collider, out_result);
+}
+
+SOREN_EXPORT bool capsule_collider_collides_point(CapsuleCollider* collider, Vector point, CollisionResult* out_result) {
+    return collision_point_to_capsule_ext(point, collider, out_result);
+}
@@ -32,6 +32,7 @@ SOREN_EXPORT float circle_collider_scale(CircleCollider* circle) {
 
 SOREN_EXPORT void circle_collider_set_scale(CircleCollider* circle, float scale) {
     circle->scale = scale;
+    circle->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector circle_collider_position(CircleCollider* circle) {
@@ -40,16 +41,22 @@ SOREN_EXPORT Vector circle_collider_position(CircleCollider* circle) {
 
 SOREN_EXPORT void circle_collider_set_position(CircleCollider* circle, Vector position) {
     circle->position = position;
+    circle->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT RectF circle_collider_bounds(CircleCollider* circle) {
-    float radius = circle_collider_radius(circle);
-    return (RectF){ 
-        circle->position.x - radius,
-        circle->position.y - radius,
-        radius * 2,
-        radius * 2
-    };
+    if (circle->base.bounds_dirty) {
+        float radius = circle_collider_radius(circle);
+        circle->base.bounds = (RectF){ 
+            circle->position.x - radius,
+            circle->position.y - radius,
+            radius * 2,
+            radius * 2
+        };
+        circle->base.bounds_dirty = false;
+    }
+
+    return circle->base.bounds;
 }
 
 SOREN_EXPORT void circle_collider_debug_draw(CircleCollider* circle, SDL_Renderer* renderer, SDL_FColor color) {
@@ -66,6 +73,7 @@ SOREN_EXPORT float circle_collider_original_radius(CircleCollider* circle) {
 
 SOREN_EXPORT void circle_collider_set_original_radius(CircleCollider* circle, float value) {
     circle->radius = value;
+    circle->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT bool circle_collider_overlaps_rect(CircleCollider* collider, RectF rect) {
@@ -85,13 +93,10 @@ SOREN_EXPORT bool circle_collider_overlaps_collider(CircleCollider* collider, Co
             return collision_line_to_circle((LineCollider*)other, collider);
         case COLLIDER_CIRCLE:
             return collision_circle_to_circle(collider, (CircleCollider*)other);
+        case COLLIDER_CAPSULE:
+            return collision_circle_to_capsule(collider, (CapsuleCollider*)other);
         case COLLIDER_BOX:
-            BoxCollider* box = (BoxCollider*)other;
-            if (box_collider_rotation(box) == 0) {
-                return collision_circle_to_box(collider, box);
-            } else {
-                return collision_circle_to_polygon(collider, (PolygonCollider*)box);
-            }
+            return collision_circle_to_box(collider, (BoxCollider*)other);
         case COLLIDER_POLYGON:
             return collision_circle_to_polygon(collider, (PolygonCollider*)other);
         default:
@@ -127,13 +132,10 @@ SOREN_EXPORT bool circle_collider_collides_collider(CircleCollider* collider, Co
             return collision_line_to_circle_ext((LineCollider*)other, collider, out_hit);
         case COLLIDER_CIRCLE:
             return collision_circle_to_circle_ext(collider, (CircleCollider*)other, out_result);
+        case COLLIDER_CAPSULE:
+            return collision_circle_to_capsule_ext(collider, (CapsuleCollider*)other, out_result);
         case COLLIDER_BOX:
-            BoxCollider* box = (BoxCollider*)other;
-            if (box_collider_rotation(box) == 0) {
-                return collision_circle_to_box_ext(collider, box, out_result);
-            } else {
-                return collision_circle_to_polygon_ext(collider, (PolygonCollider*)box, out_result);
-            }
+            return collision_circle_to_box_ext(collider, (BoxCollider*)other, out_result);
         case COLLIDER_POLYGON:
             return collision_circle_to_polygon_ext(collider, (PolygonCollider*)other, out_result);
         default:
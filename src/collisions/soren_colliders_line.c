@@ -48,6 +48,7 @@ SOREN_EXPORT void line_collider_set_rotation(LineCollider* line, float rotation)
 
     line->rotation = rotation;
     line->dirty = true;
+    line->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT float line_collider_scale(LineCollider* line) {
@@ -60,6 +61,7 @@ SOREN_EXPORT void line_collider_set_scale(LineCollider* line, float scale) {
 
     line->scale = scale;
     line->dirty = true;
+    line->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector line_collider_position(LineCollider* line) {
@@ -71,18 +73,23 @@ SOREN_EXPORT void line_collider_set_position(LineCollider* line, Vector position
         return;
 
     line->position = position;
-    line->dirty = true;
+    line->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT RectF line_collider_bounds(LineCollider* line) {
-    if (line->dirty) {
-        line_collider_clean(line);
+    if (line->base.bounds_dirty) {
+        if (line->dirty) {
+            line_collider_clean(line);
+        }
+
+        RectF bounds = line->bounding_box;
+        bounds.x += line->position.x;
+        bounds.y += line->position.y;
+        line->base.bounds = bounds;
+        line->base.bounds_dirty = false;
     }
 
-    RectF bounds = line->bounding_box;
-    bounds.x += line->position.x;
-    bounds.y += line->position.y;
-    return bounds;
+    return line->base.bounds;
 }
 
 SOREN_EXPORT void line_collider_debug_draw(LineCollider* line, SDL_Renderer* renderer, SDL_FColor color) {
@@ -138,6 +145,7 @@ SOREN_EXPORT void line_collider_set_original_start(LineCollider* line, Vector st
 
     line->original_start = start;
     line->dirty = true;
+    line->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector line_collider_original_end(LineCollider* line) {
@@ -150,6 +158,7 @@ SOREN_EXPORT void line_collider_set_original_end(LineCollider* line, Vector end)
 
     line->original_end = end;
     line->dirty = true;
+    line->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector line_collider_original_pivot(LineCollider* line) {
@@ -162,6 +171,7 @@ SOREN_EXPORT void line_collider_set_original_pivot(LineCollider* line, Vector pi
 
     line->original_pivot = pivot;
     line->dirty = true;
+    line->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT bool line_collider_overlaps_rect(LineCollider* collider, RectF rect) {
@@ -182,6 +192,8 @@ SOREN_EXPORT bool line_collider_overlaps_collider(LineCollider* collider, Collid
             return collision_line_to_line(collider, (LineCollider*)other);
         case COLLIDER_CIRCLE:
             return collision_line_to_circle(collider, (CircleCollider*)other);
+        case COLLIDER_CAPSULE:
+            return collision_line_to_capsule(collider, (CapsuleCollider*)other);
         case COLLIDER_BOX:
         case COLLIDER_POLYGON:
             return collision_line_to_poly(collider, (PolygonCollider*)other);
@@ -225,6 +237,8 @@ SOREN_EXPORT bool line_collider_collides_collider(LineCollider* collider, Collid
             return collision_line_to_line_ext(collider, (LineCollider*)other, out_result);
         case COLLIDER_CIRCLE:
             return collision_line_to_circle_ext(collider, (CircleCollider*)other, out_hit);
+        case COLLIDER_CAPSULE:
+            return collision_line_to_capsule_ext(collider, (CapsuleCollider*)other, out_hit);
         case COLLIDER_BOX:
         case COLLIDER_POLYGON:
             return collision_line_to_poly_ext(collider, (PolygonCollider*)other, out_hit);
@@ -241,6 +255,9 @@ SOREN_EXPORT bool line_collider_collides_line(LineCollider* collider, Vector sta
     bool result = collision_line_to_segment_ext(collider, start, end, &collision_result);
     if (result && out_result) {
         collision_result_to_raycast_hit(&collision_result, out_result);
+        out_result->point = collision_result.point;
+        out_result->distance = vector_distance(start, collision_result.point);
+        out_result->fraction = out_result->distance / vector_distance(start, end);
     }
 
     return result;
@@ -20,6 +20,7 @@ SOREN_EXPORT void point_collider_set_rotation(PointCollider* point, float rotati
     }
 
     point->rotation = rotation;
+    point->base.bounds_dirty = true;
     if (point->scale != 1) {
         box_collider_set_rotation(point->box, rotation);
     }
@@ -48,6 +49,7 @@ SOREN_EXPORT void point_collider_set_scale(PointCollider* point, float scale) {
     }
 
     point->scale = scale;
+    point->base.bounds_dirty = true;
     box_collider_set_scale(point->box, scale);
 }
 
@@ -61,6 +63,7 @@ SOREN_EXPORT void point_collider_set_position(PointCollider* point, Vector posit
     }
 
     point->position = position;
+    point->base.bounds_dirty = true;
 
     if(point->scale == 1) {
         box_collider_set_position(point->box, position);
@@ -68,16 +71,22 @@ SOREN_EXPORT void point_collider_set_position(PointCollider* point, Vector posit
 }
 
 SOREN_EXPORT RectF point_collider_bounds(PointCollider* point) {
-    if (point->scale == 1) {
-        return (RectF){
-            point->position.x,
-            point->position.y,
-            1,
-            1
-        };
-    } else {
-        return box_collider_bounds(point->box);
+    if (point->base.bounds_dirty) {
+        if (point->scale == 1) {
+            point->base.bounds = (RectF){
+                point->position.x,
+                point->position.y,
+                1,
+                1
+            };
+        } else {
+            point->base.bounds = box_collider_bounds(point->box);
+        }
+
+        point->base.bounds_dirty = false;
     }
+
+    return point->base.bounds;
 }
 
 SOREN_EXPORT void point_collider_debug_draw(PointCollider* point, SDL_Renderer* renderer, SDL_FColor color) {
@@ -115,6 +124,8 @@ SOREN_EXPORT bool point_collider_overlaps_collider(PointCollider* collider, Coll
             return collision_point_to_line(position, (LineCollider*)other);
         case COLLIDER_CIRCLE:
             return collision_point_to_circle(position, (CircleCollider*)other);
+        case COLLIDER_CAPSULE:
+            return collision_point_to_capsule(position, (CapsuleCollider*)other);
         case COLLIDER_BOX:
             return collision_point_to_box(position, (BoxCollider*)other);
         case COLLIDER_POLYGON:
@@ -170,6 +181,8 @@ SOREN_EXPORT bool point_collider_collides_collider(PointCollider* collider, Coll
             return collision_point_to_line_ext(position, (LineCollider*)other, out_result);
         case COLLIDER_CIRCLE:
             return collision_point_to_circle_ext(position, (CircleCollider*)other, out_result);
+        case COLLIDER_CAPSULE:
+            return collision_point_to_capsule_ext(position, (CapsuleCollider*)other, out_result);
         case COLLIDER_BOX:
             return collision_point_to_box_ext(position, (BoxCollider*)other, out_result);
         case COLLIDER_POLYGON:
@@ -190,6 +203,9 @@ SOREN_EXPORT bool point_collider_collides_line(PointCollider* collider, Vector s
         bool result = collision_point_to_segment_ext(collider_position(collider), start, end, &collision_result);
         if (result && out_result) {
             collision_result_to_raycast_hit(&collision_result, out_result);
+            out_result->point = collision_result.point;
+            out_result->distance = vector_distance(start, collision_result.point);
+            out_result->fraction = out_result->distance / vector_distance(start, end);
         }
 
         return result;
@@ -5,6 +5,7 @@
 #include <float.h>
 
 #include "soren_collisions_shared.h"
+#include "soren_collisions_simd.h"
 
 
 SOREN_EXPORT PolygonCollider* polygon_collider_create(Vector* points, int count) {
@@ -20,16 +21,22 @@ SOREN_EXPORT void polygon_collider_init(PolygonCollider* polygon, Vector* points
     assert(polygon);
     collider_init((Collider*)polygon, COLLIDER_POLYGON);
     polygon->bounding_box = RECTF_EMPTY;
+    polygon->bounding_radius = 0;
     polygon->position = VECTOR_ZERO;
     polygon->original_center = VECTOR_ZERO;
     polygon->scale = 1;
     polygon->rotation = 0;
     polygon->dirty = true;
     polygon->points_count = count;
+    polygon->axes_rotation = 0;
+    polygon->axes_count = 0;
+    polygon->axes_dirty = true;
 
     polygon->edge_normals = soren_malloc(count * sizeof(*polygon->edge_normals));
     polygon->points = soren_malloc(count * sizeof(*polygon->points));
     polygon->original_points = soren_malloc(count * sizeof(*polygon->original_points));
+    polygon->axes = soren_calloc(count, sizeof(*polygon->axes));
+    polygon->original_axes = soren_calloc(count, sizeof(*polygon->original_axes));
 
     SDL_memcpy(polygon->original_points, points, count * sizeof(*points));
 }
@@ -38,6 +45,8 @@ void polygon_collider_free_resources(PolygonCollider* polygon) {
     soren_free(polygon->edge_normals);
     soren_free(polygon->points);
     soren_free(polygon->original_points);
+    soren_free(polygon->axes);
+    soren_free(polygon->original_axes);
 }
 
 static void polygon_set_edge_normal(PolygonCollider* polygon, int index) {
@@ -59,69 +68,44 @@ static void polygon_set_edge_normal(PolygonCollider* polygon, int index) {
     }
 }
 
-static void polygon_clean(PolygonCollider* polygon) {
-    if (!polygon->dirty)
-        return;
-
+// Transforms the points of the polygon by its scale and rotation. The sine and cosine of
+// the rotation are passed in so the batch update can share them with the axes.
+static void polygon_clean_points(PolygonCollider* polygon, float sin, float cos) {
     polygon->dirty = false;
-    float min_x = FLT_MAX;
-    float min_y = FLT_MAX;
-    float max_x = FLT_MIN;
-    float max_y = FLT_MIN;
-
-    // There are two branches to calculate the final points of the polygon.
-    // The first is used if the poly has been rotated, and includes all
-    // transformations. The second eschews the unnecessary rotation transforms
-    // for efficiency.
-    if (polygon->rotation != 0) {
-        float sin = sinf(polygon->rotation);
-        Vector center = polygon_collider_center(polygon);
-        Matrix transform = matrix_create_trso(VECTOR_ZERO, polygon->rotation, vector_create(polygon->scale, polygon->scale), center);
 
-        for (int i = 0; i < polygon->points_count; i++) {
-            Vector p = polygon->original_points[i];
+    // Unrotated polygons are only scaled, so they don't need to be moved to their center first.
+    Vector origin = polygon->rotation != 0 ? polygon_collider_center(polygon) : VECTOR_ZERO;
+    float scale = polygon->scale;
+
+    // Equivalent to matrix_create_trso(VECTOR_ZERO, rotation, scale, origin) without recomputing the sine and cosine.
+    Matrix transform = {
+        .m11 = cos * scale,
+        .m12 = sin * scale,
+        .m21 = -sin * scale,
+        .m22 = cos * scale
+    };
+    transform.m31 = -(origin.x * transform.m11 + origin.y * transform.m21);
+    transform.m32 = -(origin.x * transform.m12 + origin.y * transform.m22);
+    transform.m31 += origin.x;
+    transform.m32 += origin.y;
 
-            p = vector_transform(p, &transform);
+    polygon->bounding_box = collision_transform_points(polygon->original_points, polygon->points, polygon->points_count, &transform);
+    polygon->bounding_radius = SDL_sqrtf(collision_points_radius_squared(polygon->points, polygon->points_count));
 
-            if (p.x < min_x)
-                min_x = p.x;
-            if (p.x > max_x)
-                max_x = p.x;
-            if (p.y < min_y)
-                min_y = p.y;
-            if (p.y > max_y)
-                max_y = p.y;
+    for (int i = 0; i < polygon->points_count; i++) {
+        polygon_set_edge_normal(polygon, i);
+    }
+}
 
-            polygon->points[i] = p;
+static void polygon_clean(PolygonCollider* polygon) {
+    if (!polygon->dirty)
+        return;
 
-            polygon_set_edge_normal(polygon, i);
-        }
+    if (polygon->rotation != 0) {
+        polygon_clean_points(polygon, SDL_sinf(polygon->rotation), SDL_cosf(polygon->rotation));
     } else {
-        for (int i = 0; i < polygon->points_count; i++) {
-            Vector p = polygon->original_points[i];
-            p = vector_multiply_scalar(p, polygon->scale);
-
-            if (p.x < min_x)
-                min_x = p.x;
-            if (p.x > max_x)
-                max_x = p.x;
-            if (p.y < min_y)
-                min_y = p.y;
-            if (p.y > max_y)
-                max_y = p.y;
-
-            polygon->points[i] = p;
-
-            polygon_set_edge_normal(polygon, i);
-        }
+        polygon_clean_points(polygon, 0, 1);
     }
-
-    polygon->bounding_box = (RectF) {
-        min_x,
-        min_y,
-        max_x - min_x,
-        max_y - min_y
-    };
 }
 
 SOREN_EXPORT float polygon_collider_rotation(PolygonCollider* polygon) {
@@ -134,6 +118,7 @@ SOREN_EXPORT void polygon_collider_set_rotation(PolygonCollider* polygon, float
     
     polygon->rotation = rotation;
     polygon->dirty = true;
+    polygon->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT float polygon_collider_scale(PolygonCollider* polygon) {
@@ -147,6 +132,7 @@ SOREN_EXPORT void polygon_collider_set_scale(PolygonCollider* polygon, float sca
     collider_assert_scale(scale);
     polygon->scale = scale;
     polygon->dirty = true;
+    polygon->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector polygon_collider_position(PolygonCollider* polygon) {
@@ -155,6 +141,7 @@ SOREN_EXPORT Vector polygon_collider_position(PolygonCollider* polygon) {
 
 SOREN_EXPORT void polygon_collider_set_position(PolygonCollider* polygon, Vector position) {
     polygon->position = position;
+    polygon->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector polygon_collider_center(PolygonCollider* polygon) {
@@ -172,6 +159,7 @@ SOREN_EXPORT Vector polygon_collider_original_center(PolygonCollider* polygon) {
 SOREN_EXPORT void polygon_collider_set_original_center(PolygonCollider* polygon, Vector center) {
     polygon->original_center = center;
     polygon->dirty = true;
+    polygon->base.bounds_dirty = true;
 }
 
 SOREN_EXPORT Vector* polygon_collider_points(PolygonCollider* polygon, int* out_count) {
@@ -184,15 +172,20 @@ SOREN_EXPORT Vector* polygon_collider_points(PolygonCollider* polygon, int* out_
 }
 
 SOREN_EXPORT RectF polygon_collider_bounds(PolygonCollider* polygon) {
-    polygon_clean(polygon);
-    Vector center = polygon_collider_center(polygon);
+    if (polygon->base.bounds_dirty) {
+        polygon_clean(polygon);
+        Vector center = polygon_collider_center(polygon);
 
-    return (RectF){
-        .x = polygon->bounding_box.x + polygon->position.x - center.x,
-        .y = polygon->bounding_box.y + polygon->position.y - center.y,
-        .w = polygon->bounding_box.w,
-        .h = polygon->bounding_box.h
-    };
+        polygon->base.bounds = (RectF){
+            .x = polygon->bounding_box.x + polygon->position.x - center.x,
+            .y = polygon->bounding_box.y + polygon->position.y - center.y,
+            .w = polygon->bounding_box.w,
+            .h = polygon->bounding_box.h
+        };
+        polygon->base.bounds_dirty = false;
+    }
+
+    return polygon->base.bounds;
 }
 
 SOREN_EXPORT void polygon_collider_debug_draw(PolygonCollider* polygon, SDL_Renderer* renderer, SDL_FColor color) {
@@ -220,6 +213,97 @@ SOREN_EXPORT Vector* polygon_collider_edge_normals(PolygonCollider* polygon, int
     return polygon->edge_normals;
 }
 
+// Edges whose normals are closer to parallel than this share an axis.
+#define POLYGON_AXIS_EPSILON 0.0001f
+
+static void polygon_build_original_axes(PolygonCollider* polygon) {
+    polygon->axes_count = 0;
+
+    for (int i = 0; i < polygon->points_count; i++) {
+        Vector start = polygon->original_points[i];
+        Vector end = polygon->original_points[(i + 1) % polygon->points_count];
+
+        if (vector_equals(start, end)) {
+            continue;
+        }
+
+        Vector axis = vector_normalize(vector_perpendicular(start, end));
+        bool unique = true;
+
+        for (int j = 0; j < polygon->axes_count; j++) {
+            Vector other = polygon->original_axes[j];
+            if (SDL_fabsf(axis.x * other.y - axis.y * other.x) < POLYGON_AXIS_EPSILON) {
+                unique = false;
+                break;
+            }
+        }
+
+        if (unique) {
+            polygon->original_axes[polygon->axes_count++] = axis;
+        }
+    }
+
+    polygon->axes_dirty = false;
+}
+
+static inline bool polygon_axes_dirty(PolygonCollider* polygon) {
+    // The scale is uniform, so only the rotation changes the direction of the axes.
+    return polygon->axes_dirty || polygon->axes_rotation != polygon->rotation;
+}
+
+static void polygon_clean_axes(PolygonCollider* polygon, float sin, float cos) {
+    if (polygon->axes_dirty) {
+        polygon_build_original_axes(polygon);
+    }
+
+    if (polygon->rotation == 0) {
+        SDL_memcpy(polygon->axes, polygon->original_axes, polygon->axes_count * sizeof(*polygon->axes));
+    } else {
+        Matrix rotation = { .m11 = cos, .m12 = sin, .m21 = -sin, .m22 = cos };
+        collision_transform_points(polygon->original_axes, polygon->axes, polygon->axes_count, &rotation);
+    }
+
+    polygon->axes_rotation = polygon->rotation;
+}
+
+SOREN_EXPORT Vector* polygon_collider_axes(PolygonCollider* polygon, int* out_count) {
+    if (polygon_axes_dirty(polygon)) {
+        polygon_clean_axes(polygon, SDL_sinf(polygon->rotation), SDL_cosf(polygon->rotation));
+    }
+
+    if (out_count)
+        *out_count = polygon->axes_count;
+
+    return polygon->axes;
+}
+
+SOREN_EXPORT void polygon_collider_clean(PolygonCollider* polygon) {
+    bool points_dirty = polygon->dirty;
+    bool axes_dirty = polygon_axes_dirty(polygon);
+
+    if (points_dirty || axes_dirty) {
+        // Computed once and shared by the points and the axes.
+        float sin = polygon->rotation != 0 ? SDL_sinf(polygon->rotation) : 0;
+        float cos = polygon->rotation != 0 ? SDL_cosf(polygon->rotation) : 1;
+
+        if (points_dirty) {
+            polygon_clean_points(polygon, sin, cos);
+        }
+
+        if (axes_dirty) {
+            polygon_clean_axes(polygon, sin, cos);
+        }
+    }
+
+    polygon_collider_bounds(polygon);
+}
+
+SOREN_EXPORT void polygon_collider_clean_batch(PolygonCollider** polygons, int count) {
+    for (int i = 0; i < count; i++) {
+        polygon_collider_clean(polygons[i]);
+    }
+}
+
 SOREN_EXPORT bool polygon_collider_overlaps_rect(PolygonCollider* collider, RectF rect) {
     BoxCollider* box = collision_shared_box_collider_init(rect);
     return collision_polygon_to_polygon(collider, (PolygonCollider*)box);
@@ -238,6 +322,8 @@ SOREN_EXPORT bool polygon_collider_overlaps_collider(PolygonCollider* collider,
             return collision_line_to_poly((LineCollider*)other, collider);
         case COLLIDER_CIRCLE:
             return collision_circle_to_polygon((CircleCollider*)other, collider);
+        case COLLIDER_CAPSULE:
+            return collision_capsule_to_polygon((CapsuleCollider*)other, collider);
         case COLLIDER_BOX:
         case COLLIDER_POLYGON:
             return collision_polygon_to_polygon(collider, (PolygonCollider*)other);
@@ -280,6 +366,13 @@ SOREN_EXPORT bool polygon_collider_collides_collider(PolygonCollider* collider,
             }
 
             return result;
+        case COLLIDER_CAPSULE:
+            bool capsule_result = collision_capsule_to_polygon_ext((CapsuleCollider*)other, collider, out_result);
+            if (capsule_result && out_result) {
+                collision_result_invert(out_result);
+            }
+
+            return capsule_result;
         case COLLIDER_BOX:
         case COLLIDER_POLYGON:
             return collision_polygon_to_polygon_ext(collider, (PolygonCollider*)other, out_result);
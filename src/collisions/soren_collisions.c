@@ -2,6 +2,9 @@
 #include <collisions/soren_collisions.h>
 #include <collisions/soren_collision_utils.h>
 
+#include "soren_collisions_shared.h"
+#include "soren_collisions_simd.h"
+
 #include <float.h>
 #include <math.h>
 
@@ -140,9 +143,122 @@ SOREN_EXPORT bool collision_radius_to_radius_ext(Vector first_position, float fi
     return collided;
 }
 
+// Oriented boxes are tested directly instead of as polygons. Opposite edges of a box
+// are parallel, so only two of its four edge normals are needed as separating axes.
+typedef struct CollisionObb {
+    Vector center;
+    Vector axes[2];
+    float half_extents[2];
+} CollisionObb;
+
+static inline CollisionObb collision_box_to_obb(BoxCollider* box) {
+    Vector* points = polygon_collider_points((PolygonCollider*)box, NULL);
+    Vector offset = vector_subtract(polygon_collider_position((PolygonCollider*)box), polygon_collider_center((PolygonCollider*)box));
+    Vector size = box_collider_size(box);
+
+    // The points are built clockwise from the top left corner, so the first and third
+    // points are opposite corners, and the first edge runs along the width of the box.
+    return (CollisionObb){
+        .center = vector_add(vector_multiply_scalar(vector_add(points[0], points[2]), 0.5f), offset),
+        .axes = {
+            vector_divide_scalar(vector_subtract(points[1], points[0]), size.x),
+            vector_divide_scalar(vector_subtract(points[3], points[0]), size.y)
+        },
+        .half_extents = { size.x / 2, size.y / 2 }
+    };
+}
+
+static inline CollisionObb collision_rect_to_obb(RectF rect) {
+    return (CollisionObb){
+        .center = vector_create(rect.x + rect.w / 2, rect.y + rect.h / 2),
+        .axes = { vector_create(1, 0), vector_create(0, 1) },
+        .half_extents = { rect.w / 2, rect.h / 2 }
+    };
+}
+
+static inline void collision_obb_get_interval(CollisionObb* obb, Vector axis, float* out_min, float* out_max) {
+    float center = vector_dot(obb->center, axis);
+    float radius = obb->half_extents[0] * SDL_fabsf(vector_dot(obb->axes[0], axis))
+        + obb->half_extents[1] * SDL_fabsf(vector_dot(obb->axes[1], axis));
+
+    *out_min = center - radius;
+    *out_max = center + radius;
+}
+
+// Fills out the result the same way as collision_shape_to_shape_ext.
+static bool collision_obb_to_obb(CollisionObb* first, CollisionObb* second, CollisionResult* out_result) {
+    CollisionResult result = (CollisionResult){0};
+    Vector offset = vector_subtract(first->center, second->center);
+    Vector translation_axis = VECTOR_ZERO;
+    float min_interval_distance = FLT_MAX;
+    bool collides = false;
+
+    for (int i = 0; i < 4; i++) {
+        Vector axis = i < 2 ? first->axes[i] : second->axes[i - 2];
+
+        float min_a, max_a, min_b, max_b;
+        collision_obb_get_interval(first, axis, &min_a, &max_a);
+        collision_obb_get_interval(second, axis, &min_b, &max_b);
+
+        float interval_distance = min_a < min_b ? min_b - max_a : min_a - max_b;
+        if (interval_distance >= 0)
+            goto end;
+
+        interval_distance = -interval_distance;
+
+        if (interval_distance < min_interval_distance) {
+            min_interval_distance = interval_distance;
+            translation_axis = axis;
+
+            if (vector_dot(translation_axis, offset) < 0)
+                translation_axis = vector_negate(translation_axis);
+        }
+    }
+
+    collides = true;
+    result.normal = translation_axis;
+    result.minimum_translation_vector = vector_multiply_scalar(vector_negate(translation_axis), min_interval_distance);
+
+    end:
+        if (out_result) {
+            *out_result = result;
+        }
+
+        return collides;
+}
+
+// Tests the circle against the box in the space of the box, where it's just a rect,
+// then transforms the results back.
+static bool collision_radius_to_obb(Vector position, float radius, CollisionObb* obb, CollisionResult* out_result) {
+    Vector offset = vector_subtract(position, obb->center);
+    Vector local = vector_create(vector_dot(offset, obb->axes[0]), vector_dot(offset, obb->axes[1]));
+    RectF rect = (RectF){ -obb->half_extents[0], -obb->half_extents[1], obb->half_extents[0] * 2, obb->half_extents[1] * 2 };
+
+    if (!out_result) {
+        return collision_radius_to_rect(local, radius, rect);
+    }
+
+    if (!collision_radius_to_rect_ext(local, radius, rect, out_result)) {
+        return false;
+    }
+
+    Vector u = obb->axes[0];
+    Vector v = obb->axes[1];
+    Vector normal = out_result->normal;
+    Vector mtv = out_result->minimum_translation_vector;
+    Vector point = out_result->point;
+
+    out_result->normal = vector_add(vector_multiply_scalar(u, normal.x), vector_multiply_scalar(v, normal.y));
+    out_result->minimum_translation_vector = vector_add(vector_multiply_scalar(u, mtv.x), vector_multiply_scalar(v, mtv.y));
+    out_result->point = vector_add(obb->center, vector_add(vector_multiply_scalar(u, point.x), vector_multiply_scalar(v, point.y)));
+
+    return true;
+}
+
 SOREN_EXPORT bool collision_circle_to_box(CircleCollider* first, BoxCollider* second) {
     if (collider_rotation(second) != 0) {
-        return collision_circle_to_polygon(first, (PolygonCollider*)second);
+        CollisionObb obb = collision_box_to_obb(second);
+        return collision_radius_to_obb(circle_collider_position(first), circle_collider_radius(first), &obb, NULL);
     }
 
     RectF bounds = box_collider_bounds(second);
@@ -156,7 +272,8 @@ SOREN_EXPORT bool collision_circle_to_box(CircleCollider* first, BoxCollider* se
 
 SOREN_EXPORT bool collision_circle_to_box_ext(CircleCollider* first, BoxCollider* second, CollisionResult* out_result) {
     if (collider_rotation(second) != 0) {
-        return collision_circle_to_polygon_ext(first, (PolygonCollider*)second, out_result);
+        CollisionObb obb = collision_box_to_obb(second);
+        return collision_radius_to_obb(circle_collider_position(first), circle_collider_radius(first), &obb, out_result);
     }
 
     RectF bounds = box_collider_bounds(second);
@@ -350,149 +467,147 @@ SOREN_EXPORT bool collision_radius_to_shape_ext(Vector position, float radius, V
     return true;
 }
 
-SOREN_EXPORT bool collision_polygon_to_polygon(PolygonCollider* first, PolygonCollider* second) {
-    int first_count = 0;
-    Vector* first_points = polygon_collider_points(first, &first_count);
-    Vector* first_edges = polygon_collider_edge_normals(first, NULL);
-    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
-    // Vector first_position = polygon_collider_position(first);
-
-    int second_count = 0;
-    Vector* second_points = polygon_collider_points(second, &second_count);
-    Vector* second_edges = polygon_collider_edge_normals(second, NULL);
-    Vector second_position = vector_subtract(polygon_collider_position(second), polygon_collider_center(second));
-    // Vector second_position = polygon_collider_position(second);
+static inline void collision_shape_to_shape_get_interval(Vector axis, Vector* points, int points_count, float* out_min, float* out_max) {
+    collision_project_points(axis, points, points_count, out_min, out_max);
+}
 
-    return collision_shape_to_shape(
-        first_points,
-        first_edges,
-        first_count,
-        first_position,
-        second_points,
-        second_edges,
-        second_count,
-        second_position);
+static inline float collision_shape_bounding_radius(Vector* points, int points_count) {
+    return SDL_sqrtf(collision_points_radius_squared(points, points_count));
 }
 
-SOREN_EXPORT bool collision_polygon_to_polygon_ext(PolygonCollider* first, PolygonCollider* second, CollisionResult* out_result) {
-    int first_count = 0;
-    Vector* first_points = polygon_collider_points(first, &first_count);
-    Vector* first_edges = polygon_collider_edge_normals(first, NULL);
-    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
-    // Vector first_position = polygon_collider_position(first);
+// Checks if the circles around each shape overlap. This is much cheaper than
+// projecting both shapes onto every axis, and rules out most pairs that only
+// overlap in the broadphase. Polygons keep their radius up to date with their
+// points, so it's only measured here for other shapes.
+static inline bool collision_shape_to_shape_bounding_circles(float first_radius, float second_radius, Vector offset) {
+    float radius = first_radius + second_radius;
 
-    int second_count = 0;
-    Vector* second_points = polygon_collider_points(second, &second_count);
-    Vector* second_edges = polygon_collider_edge_normals(second, NULL);
-    Vector second_position = vector_subtract(polygon_collider_position(second), polygon_collider_center(second));
-    // Vector second_position = polygon_collider_position(second);
+    return vector_length_squared(offset) <= radius * radius;
+}
 
-    return collision_shape_to_shape_ext(
-        first_points,
-        first_edges,
-        first_count,
-        first_position,
-        second_points,
-        second_edges,
-        second_count,
-        second_position,
-        out_result);
+static inline float collision_shape_to_shape_interval_distance(float min_a, float max_a, float min_b, float max_b) {
+    if (min_a < min_b)
+        return min_b - max_a;
+    
+    return min_a - max_b;
 }
 
-SOREN_EXPORT bool collision_polygon_to_shape(PolygonCollider* first, Vector* points, Vector* edge_normals, int points_count, Vector shape_position) {
-    int first_count = 0;
-    Vector* first_points = polygon_collider_points(first, &first_count);
-    Vector* first_edges = polygon_collider_edge_normals(first, NULL);
-    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
+static inline bool collision_shape_to_shape_separated(
+    Vector axis,
+    Vector* first_points,
+    int first_points_count,
+    Vector* second_points,
+    int second_points_count,
+    Vector offset)
+{
+    float min_a, max_a, min_b, max_b;
+    collision_shape_to_shape_get_interval(axis, first_points, first_points_count, &min_a, &max_a);
+    collision_shape_to_shape_get_interval(axis, second_points, second_points_count, &min_b, &max_b);
 
-    return collision_shape_to_shape(
-        first_points,
-        first_edges,
-        first_count,
-        first_position,
-        points,
-        edge_normals,
-        points_count,
-        shape_position);
+    float relative_interval_offset = vector_dot(offset, axis);
+    return collision_shape_to_shape_interval_distance(min_a + relative_interval_offset, max_a + relative_interval_offset, min_b, max_b) >= 0;
 }
 
-SOREN_EXPORT bool collision_polygon_to_shape_ext(PolygonCollider* first, Vector* points, Vector* edge_normals, int points_count, Vector shape_position, CollisionResult* out_result) {
-    int first_count = 0;
-    Vector* first_points = polygon_collider_points(first, &first_count);
-    Vector* first_edges = polygon_collider_edge_normals(first, NULL);
-    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
+// Remembers the last separating axis, or the last contact normal, of each polygon pair.
+// Pairs that were separated on the last test are almost always still separated by the
+// same axis, so testing it first rejects most of them after a single projection.
+// Any axis that separates the shapes proves they don't overlap, so an old axis can
+// only cost the extra projection, never give a wrong result.
+//
+// The cache is thread local so the narrowphase pool can use it without locking.
+// Entries that haven't been used for COLLISION_AXIS_CACHE_MAX_AGE steps are ignored.
 
-    return collision_shape_to_shape_ext(
-        first_points,
-        first_edges,
-        first_count,
-        first_position,
-        points,
-        edge_normals,
-        points_count,
-        shape_position,
-        out_result);
+// Must be a power of two.
+#define COLLISION_AXIS_CACHE_SIZE 1024
+#define COLLISION_AXIS_CACHE_MAX_AGE 8
+
+typedef struct CollisionAxisCacheEntry {
+    PolygonCollider* first;
+    PolygonCollider* second;
+    Vector axis;
+    uint32_t step;
+} CollisionAxisCacheEntry;
+
+static uint32_t collision_axis_cache_step = 1;
+static soren_thread_local CollisionAxisCacheEntry collision_axis_cache[COLLISION_AXIS_CACHE_SIZE];
+
+SOREN_EXPORT void collision_axis_cache_advance(void) {
+    collision_axis_cache_step++;
 }
 
-static inline void collision_shape_to_shape_get_interval(Vector axis, Vector* points, int points_count, float* out_min, float* out_max) {
-    float dot = vector_dot(points[0], axis);
-    *out_min = dot;
-    *out_max = dot;
+SOREN_EXPORT void collision_axis_cache_clear(void) {
+    SDL_memset(collision_axis_cache, 0, sizeof(collision_axis_cache));
+}
 
-    for (int i = 1; i < points_count; i++) {
-        dot = vector_dot(points[i], axis);
-        if (dot < *out_min)
-            *out_min = dot;
-        
-        if (dot > *out_max)
-            *out_max = dot;
+static Vector* collision_axis_cache_get(PolygonCollider* first, PolygonCollider* second) {
+    // The pair is stored in a consistent order so both orders share an entry.
+    if ((uintptr_t)first > (uintptr_t)second) {
+        PolygonCollider* temp = first;
+        first = second;
+        second = temp;
     }
-}
 
-static inline float collision_shape_to_shape_interval_distance(float min_a, float max_a, float min_b, float max_b) {
-    if (min_a < min_b)
-        return min_b - max_a;
-    
-    return min_a - max_b;
+    uintptr_t hash = ((uintptr_t)first >> 4) * 31 + ((uintptr_t)second >> 4);
+    CollisionAxisCacheEntry* entry = collision_axis_cache + (hash & (COLLISION_AXIS_CACHE_SIZE - 1));
+
+    if (entry->first != first
+        || entry->second != second
+        || collision_axis_cache_step - entry->step > COLLISION_AXIS_CACHE_MAX_AGE)
+    {
+        entry->first = first;
+        entry->second = second;
+        entry->axis = VECTOR_ZERO;
+    }
+
+    entry->step = collision_axis_cache_step;
+    return &entry->axis;
 }
 
-SOREN_EXPORT bool collision_shape_to_shape(
+// Runs the separating axis test using the given axes. The axes don't need to match
+// the edges of the shapes, which lets polygons skip the axes of parallel edges.
+//
+// If cached_axis isn't NULL, it's tested before any of the other axes unless it's zero,
+// and is then set to the separating axis, or to the collision normal for the ext version.
+static bool collision_shape_to_shape_axes(
     Vector* first_points,
-    Vector* first_edge_normals,
     int first_points_count,
+    Vector* first_axes,
+    int first_axes_count,
     Vector first_position,
+    float first_radius,
     Vector* second_points,
-    Vector* second_edge_normals,
     int second_points_count,
-    Vector second_position)
+    Vector* second_axes,
+    int second_axes_count,
+    Vector second_position,
+    float second_radius,
+    Vector* cached_axis)
 {
     bool intersecting = true;
     Vector offset = vector_subtract(first_position, second_position);
     Vector axis = VECTOR_ZERO;
 
-    // String str = string_create("");
-    // for (int i = 0; i < first_points_count; i++) {
-    //     string_clear(&str);
-    //     vector_to_string(first_edge_normals[i], &str);
-    //     log_trace(soren_logger, &str);
-    // }
+    if (cached_axis
+        && !vector_equals(*cached_axis, VECTOR_ZERO)
+        && collision_shape_to_shape_separated(*cached_axis, first_points, first_points_count, second_points, second_points_count, offset))
+    {
+        return false;
+    }
 
-    // for (int i = 0; i < second_points_count; i++) {
-    //     string_clear(&str);
-    //     vector_to_string(second_edge_normals[i], &str);
-    //     log_trace(soren_logger, &str);
-    // }
+    if (!collision_shape_to_shape_bounding_circles(first_radius, second_radius, offset)) {
+        return false;
+    }
 
     float min_a = 0;
     float max_a = 0;
     float min_b = 0;
     float max_b = 0;
 
-    for (int edge_index = 0; edge_index < first_points_count + second_points_count; edge_index++) {
-        if (edge_index < first_points_count) {
-            axis = first_edge_normals[edge_index];
+    for (int axis_index = 0; axis_index < first_axes_count + second_axes_count; axis_index++) {
+        if (axis_index < first_axes_count) {
+            axis = first_axes[axis_index];
         } else {
-            axis = second_edge_normals[edge_index - first_points_count];
+            axis = second_axes[axis_index - first_axes_count];
         }
 
         collision_shape_to_shape_get_interval(axis, first_points, first_points_count, &min_a, &max_a);
@@ -503,22 +618,32 @@ SOREN_EXPORT bool collision_shape_to_shape(
         max_a += relative_interval_offset;
 
         float interval_distance = collision_shape_to_shape_interval_distance(min_a, max_a, min_b, max_b);
-        if (interval_distance >= 0)
+        if (interval_distance >= 0) {
+            if (cached_axis) {
+                *cached_axis = axis;
+            }
+
             return false;
+        }
     }
 
     return true;
 }
 
-SOREN_EXPORT bool collision_shape_to_shape_ext(
+static bool collision_shape_to_shape_axes_ext(
     Vector* first_points,
-    Vector* first_edge_normals,
     int first_points_count,
+    Vector* first_axes,
+    int first_axes_count,
     Vector first_position,
+    float first_radius,
     Vector* second_points,
-    Vector* second_edge_normals,
     int second_points_count,
+    Vector* second_axes,
+    int second_axes_count,
     Vector second_position,
+    float second_radius,
+    Vector* cached_axis,
     CollisionResult* out_result)
 {
     bool collides = false;
@@ -529,16 +654,27 @@ SOREN_EXPORT bool collision_shape_to_shape_ext(
     Vector translation_axis = VECTOR_ZERO;
     float min_interval_distance = FLT_MAX;
 
+    if (cached_axis
+        && !vector_equals(*cached_axis, VECTOR_ZERO)
+        && collision_shape_to_shape_separated(*cached_axis, first_points, first_points_count, second_points, second_points_count, offset))
+    {
+        goto end;
+    }
+
+    if (!collision_shape_to_shape_bounding_circles(first_radius, second_radius, offset)) {
+        goto end;
+    }
+
     float min_a = 0;
     float max_a = 0;
     float min_b = 0;
     float max_b = 0;
 
-    for (int edge_index = 0; edge_index < first_points_count + second_points_count; edge_index++) {
-        if (edge_index < first_points_count) {
-            axis = first_edge_normals[edge_index];
+    for (int axis_index = 0; axis_index < first_axes_count + second_axes_count; axis_index++) {
+        if (axis_index < first_axes_count) {
+            axis = first_axes[axis_index];
         } else {
-            axis = second_edge_normals[edge_index - first_points_count];
+            axis = second_axes[axis_index - first_axes_count];
         }
 
         collision_shape_to_shape_get_interval(axis, first_points, first_points_count, &min_a, &max_a);
@@ -549,8 +685,13 @@ SOREN_EXPORT bool collision_shape_to_shape_ext(
         max_a += relative_interval_offset;
 
         float interval_distance =  collision_shape_to_shape_interval_distance(min_a, max_a, min_b, max_b);
-        if (interval_distance >= 0)
+        if (interval_distance >= 0) {
+            if (cached_axis) {
+                *cached_axis = axis;
+            }
+
             goto end;
+        }
 
         if (interval_distance < 0)
             interval_distance *= -1;
@@ -569,6 +710,10 @@ SOREN_EXPORT bool collision_shape_to_shape_ext(
     result.normal = translation_axis;
     result.minimum_translation_vector = vector_multiply_scalar(vector_negate(translation_axis), min_interval_distance);
 
+    if (cached_axis) {
+        *cached_axis = translation_axis;
+    }
+
     end:
         if (out_result) {
             *out_result = result;
@@ -577,58 +722,224 @@ SOREN_EXPORT bool collision_shape_to_shape_ext(
         return collides;
 }
 
-SOREN_EXPORT bool collision_box_to_box(BoxCollider* first, BoxCollider* second) {
-    if (collider_rotation(first) != 0 || collider_rotation(second) != 0) {
-        return collision_polygon_to_polygon((PolygonCollider*)first, (PolygonCollider*)second);
-    }
-
-    RectF first_bounds = collider_bounds(first);
-    RectF second_bounds = collider_bounds(second);
-
-    return collision_rect_to_rect(first_bounds, second_bounds);
+SOREN_EXPORT bool collision_shape_to_shape(
+    Vector* first_points,
+    Vector* first_edge_normals,
+    int first_points_count,
+    Vector first_position,
+    Vector* second_points,
+    Vector* second_edge_normals,
+    int second_points_count,
+    Vector second_position)
+{
+    return collision_shape_to_shape_axes(
+        first_points,
+        first_points_count,
+        first_edge_normals,
+        first_points_count,
+        first_position,
+        collision_shape_bounding_radius(first_points, first_points_count),
+        second_points,
+        second_points_count,
+        second_edge_normals,
+        second_points_count,
+        second_position,
+        collision_shape_bounding_radius(second_points, second_points_count),
+        NULL);
 }
 
-SOREN_EXPORT bool collision_box_to_box_ext(BoxCollider* first, BoxCollider* second, CollisionResult* out_result) {
-    if (collider_rotation(first) != 0 || collider_rotation(second) != 0) {
-        return collision_polygon_to_polygon((PolygonCollider*)first, (PolygonCollider*)second);
-    }
-
-    RectF first_bounds = collider_bounds(first);
-    RectF second_bounds = collider_bounds(second);
-
-    return collision_rect_to_rect_ext(first_bounds, second_bounds, out_result);
+SOREN_EXPORT bool collision_shape_to_shape_ext(
+    Vector* first_points,
+    Vector* first_edge_normals,
+    int first_points_count,
+    Vector first_position,
+    Vector* second_points,
+    Vector* second_edge_normals,
+    int second_points_count,
+    Vector second_position,
+    CollisionResult* out_result)
+{
+    return collision_shape_to_shape_axes_ext(
+        first_points,
+        first_points_count,
+        first_edge_normals,
+        first_points_count,
+        first_position,
+        collision_shape_bounding_radius(first_points, first_points_count),
+        second_points,
+        second_points_count,
+        second_edge_normals,
+        second_points_count,
+        second_position,
+        collision_shape_bounding_radius(second_points, second_points_count),
+        NULL,
+        out_result);
 }
 
-SOREN_EXPORT bool collision_box_to_rect(BoxCollider* first, RectF second) {
-    if (collider_rotation(first) != 0) {
-        BoxCollider* shared = collision_shared_box_collider_init(second);
-        return collision_polygon_to_polygon((PolygonCollider*)first, (PolygonCollider*)shared);
-    }
+SOREN_EXPORT bool collision_polygon_to_polygon(PolygonCollider* first, PolygonCollider* second) {
+    int first_count = 0;
+    int first_axes_count = 0;
+    Vector* first_points = polygon_collider_points(first, &first_count);
+    Vector* first_axes = polygon_collider_axes(first, &first_axes_count);
+    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
 
-    RectF first_bounds = collider_bounds(first);
+    int second_count = 0;
+    int second_axes_count = 0;
+    Vector* second_points = polygon_collider_points(second, &second_count);
+    Vector* second_axes = polygon_collider_axes(second, &second_axes_count);
+    Vector second_position = vector_subtract(polygon_collider_position(second), polygon_collider_center(second));
 
-    return collision_rect_to_rect(first_bounds, second);
+    return collision_shape_to_shape_axes(
+        first_points,
+        first_count,
+        first_axes,
+        first_axes_count,
+        first_position,
+        first->bounding_radius,
+        second_points,
+        second_count,
+        second_axes,
+        second_axes_count,
+        second_position,
+        second->bounding_radius,
+        collision_axis_cache_get(first, second));
 }
 
-SOREN_EXPORT bool collision_box_to_rect_ext(BoxCollider* first, RectF second, CollisionResult* out_result) {
-    if (collider_rotation(first) != 0) {
-        BoxCollider* shared = collision_shared_box_collider_init(second);
-        return collision_polygon_to_polygon_ext((PolygonCollider*)first, (PolygonCollider*)shared, out_result);
-    }
+SOREN_EXPORT bool collision_polygon_to_polygon_ext(PolygonCollider* first, PolygonCollider* second, CollisionResult* out_result) {
+    int first_count = 0;
+    int first_axes_count = 0;
+    Vector* first_points = polygon_collider_points(first, &first_count);
+    Vector* first_axes = polygon_collider_axes(first, &first_axes_count);
+    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
 
-    RectF first_bounds = collider_bounds(first);
+    int second_count = 0;
+    int second_axes_count = 0;
+    Vector* second_points = polygon_collider_points(second, &second_count);
+    Vector* second_axes = polygon_collider_axes(second, &second_axes_count);
+    Vector second_position = vector_subtract(polygon_collider_position(second), polygon_collider_center(second));
 
-    return collision_rect_to_rect_ext(first_bounds, second, out_result);
+    return collision_shape_to_shape_axes_ext(
+        first_points,
+        first_count,
+        first_axes,
+        first_axes_count,
+        first_position,
+        first->bounding_radius,
+        second_points,
+        second_count,
+        second_axes,
+        second_axes_count,
+        second_position,
+        second->bounding_radius,
+        collision_axis_cache_get(first, second),
+        out_result);
 }
 
-SOREN_EXPORT bool collision_rect_to_rect(RectF first, RectF second) {
-    return rectf_contains_or_intersects(first, second);
-}
+SOREN_EXPORT bool collision_polygon_to_shape(PolygonCollider* first, Vector* points, Vector* edge_normals, int points_count, Vector shape_position) {
+    int first_count = 0;
+    int first_axes_count = 0;
+    Vector* first_points = polygon_collider_points(first, &first_count);
+    Vector* first_axes = polygon_collider_axes(first, &first_axes_count);
+    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
 
-static inline RectF collision_rect_to_rect_minkowski_difference(RectF first, RectF second) {
-    return (RectF) {
-        first.x - rectf_right(second),
-        first.y - rectf_bottom(second),
+    return collision_shape_to_shape_axes(
+        first_points,
+        first_count,
+        first_axes,
+        first_axes_count,
+        first_position,
+        first->bounding_radius,
+        points,
+        points_count,
+        edge_normals,
+        points_count,
+        shape_position,
+        collision_shape_bounding_radius(points, points_count),
+        NULL);
+}
+
+SOREN_EXPORT bool collision_polygon_to_shape_ext(PolygonCollider* first, Vector* points, Vector* edge_normals, int points_count, Vector shape_position, CollisionResult* out_result) {
+    int first_count = 0;
+    int first_axes_count = 0;
+    Vector* first_points = polygon_collider_points(first, &first_count);
+    Vector* first_axes = polygon_collider_axes(first, &first_axes_count);
+    Vector first_position = vector_subtract(polygon_collider_position(first), polygon_collider_center(first));
+
+    return collision_shape_to_shape_axes_ext(
+        first_points,
+        first_count,
+        first_axes,
+        first_axes_count,
+        first_position,
+        first->bounding_radius,
+        points,
+        points_count,
+        edge_normals,
+        points_count,
+        shape_position,
+        collision_shape_bounding_radius(points, points_count),
+        NULL,
+        out_result);
+}
+
+SOREN_EXPORT bool collision_box_to_box(BoxCollider* first, BoxCollider* second) {
+    if (collider_rotation(first) != 0 || collider_rotation(second) != 0) {
+        CollisionObb first_obb = collision_box_to_obb(first);
+        CollisionObb second_obb = collision_box_to_obb(second);
+        return collision_obb_to_obb(&first_obb, &second_obb, NULL);
+    }
+
+    RectF first_bounds = collider_bounds(first);
+    RectF second_bounds = collider_bounds(second);
+
+    return collision_rect_to_rect(first_bounds, second_bounds);
+}
+
+SOREN_EXPORT bool collision_box_to_box_ext(BoxCollider* first, BoxCollider* second, CollisionResult* out_result) {
+    if (collider_rotation(first) != 0 || collider_rotation(second) != 0) {
+        CollisionObb first_obb = collision_box_to_obb(first);
+        CollisionObb second_obb = collision_box_to_obb(second);
+        return collision_obb_to_obb(&first_obb, &second_obb, out_result);
+    }
+
+    RectF first_bounds = collider_bounds(first);
+    RectF second_bounds = collider_bounds(second);
+
+    return collision_rect_to_rect_ext(first_bounds, second_bounds, out_result);
+}
+
+SOREN_EXPORT bool collision_box_to_rect(BoxCollider* first, RectF second) {
+    if (collider_rotation(first) != 0) {
+        CollisionObb first_obb = collision_box_to_obb(first);
+        CollisionObb second_obb = collision_rect_to_obb(second);
+        return collision_obb_to_obb(&first_obb, &second_obb, NULL);
+    }
+
+    RectF first_bounds = collider_bounds(first);
+
+    return collision_rect_to_rect(first_bounds, second);
+}
+
+SOREN_EXPORT bool collision_box_to_rect_ext(BoxCollider* first, RectF second, CollisionResult* out_result) {
+    if (collider_rotation(first) != 0) {
+        CollisionObb first_obb = collision_box_to_obb(first);
+        CollisionObb second_obb = collision_rect_to_obb(second);
+        return collision_obb_to_obb(&first_obb, &second_obb, out_result);
+    }
+
+    RectF first_bounds = collider_bounds(first);
+
+    return collision_rect_to_rect_ext(first_bounds, second, out_result);
+}
+
+SOREN_EXPORT bool collision_rect_to_rect(RectF first, RectF second) {
+    return rectf_contains_or_intersects(first, second);
+}
+
+static inline RectF collision_rect_to_rect_minkowski_difference(RectF first, RectF second) {
+    return (RectF) {
+        first.x - rectf_right(second),
+        first.y - rectf_bottom(second),
         first.w + second.w,
         first.h + second.h
     };
@@ -940,7 +1251,7 @@ SOREN_EXPORT bool collision_segment_to_shape_ext(Vector start, Vector end, Vecto
                 normal.x = edge.y;
                 normal.y = -edge.x;
                 fraction = distance_fraction;
-                intersection_point = intersection_point;
+                intersection_point = intersection;
             }
         }
     }
@@ -1027,6 +1338,11 @@ SOREN_EXPORT bool collision_segment_to_radius(Vector start, Vector end, Vector p
         return false;
     }
 
+    // The circle is past the end of the segment.
+    if (-b - sqrtf(discriminant) > line_length) {
+        return false;
+    }
+
     return true;
 }
 
@@ -1051,6 +1367,10 @@ SOREN_EXPORT bool collision_segment_to_radius_ext(Vector start, Vector end, Vect
     }
 
     hit.fraction = -b - sqrtf(discriminant);
+    if (hit.fraction > line_length) {
+        goto end;
+    }
+
     if (hit.fraction < 0) {
         hit.fraction = 0;
     }
@@ -1110,7 +1430,7 @@ static bool collision_segment_to_segment_intersection(Vector first_start, Vector
     Vector intersection = VECTOR_ZERO;
     
     Vector b = vector_subtract(first_end, first_start);
-    Vector d = vector_subtract(second_end, first_end);
+    Vector d = vector_subtract(second_end, second_start);
     float b_dot_d_perp = b.x * d.y - b.y * d.x;
     bool collides = false;
 
@@ -1202,4 +1522,875 @@ SOREN_EXPORT bool collision_segment_to_segment_ext(Vector first_start, Vector fi
         }
 
         return collides;
-}
\ No newline at end of file
+}
+
+// Capsules are tested analytically. A capsule is every point within its radius of a
+// segment, so most tests reduce to finding the closest points between the segment and
+// the other shape, then comparing the distance against the radii.
+
+// Finds the closest points between two segments. Either of the segments can be a single point.
+static void collision_segment_closest_points(Vector first_start, Vector first_end, Vector second_start, Vector second_end, Vector* out_first, Vector* out_second) {
+    Vector first_direction = vector_subtract(first_end, first_start);
+    Vector second_direction = vector_subtract(second_end, second_start);
+    Vector offset = vector_subtract(first_start, second_start);
+
+    float first_length_squared = vector_dot(first_direction, first_direction);
+    float second_length_squared = vector_dot(second_direction, second_direction);
+    float f = vector_dot(second_direction, offset);
+    float s = 0;
+    float t = 0;
+
+    if (first_length_squared <= CAPSULE_EPSILON && second_length_squared <= CAPSULE_EPSILON) {
+        // Both segments are points.
+    } else if (first_length_squared <= CAPSULE_EPSILON) {
+        t = SDL_clamp(f / second_length_squared, 0, 1);
+    } else {
+        float c = vector_dot(first_direction, offset);
+        if (second_length_squared <= CAPSULE_EPSILON) {
+            s = SDL_clamp(-c / first_length_squared, 0, 1);
+        } else {
+            float b = vector_dot(first_direction, second_direction);
+            float denominator = first_length_squared * second_length_squared - b * b;
+
+            // Parallel segments have infinitely many closest points, so any s works.
+            if (denominator != 0) {
+                s = SDL_clamp((b * f - c * second_length_squared) / denominator, 0, 1);
+            }
+
+            t = (b * s + f) / second_length_squared;
+
+            if (t < 0) {
+                t = 0;
+                s = SDL_clamp(-c / first_length_squared, 0, 1);
+            } else if (t > 1) {
+                t = 1;
+                s = SDL_clamp((b - c) / first_length_squared, 0, 1);
+            }
+        }
+    }
+
+    *out_first = vector_add(first_start, vector_multiply_scalar(first_direction, s));
+    *out_second = vector_add(second_start, vector_multiply_scalar(second_direction, t));
+}
+
+Vector collision_closest_point_on_segment(Vector start, Vector end, Vector point) {
+    Vector closest;
+    Vector unused;
+    collision_segment_closest_points(start, end, point, point, &closest, &unused);
+    return closest;
+}
+
+static inline Vector collision_capsule_perpendicular(CapsuleCollider* capsule) {
+    return vector_create(-capsule->axis.y, capsule->axis.x);
+}
+
+// Works the same as collision_radius_to_radius_ext, but uses the fallback normal when the
+// positions are on top of each other, which happens whenever a segment passes through a point.
+static bool collision_rounded_to_rounded_ext(Vector first_position, float first_radius, Vector second_position, float second_radius, Vector fallback_normal, CollisionResult* out_result) {
+    CollisionResult result = (CollisionResult){ 0 };
+
+    float distance_squared = vector_distance_squared(first_position, second_position);
+    float sum_of_radii = first_radius + second_radius;
+    bool collided = distance_squared < sum_of_radii * sum_of_radii;
+    if (collided) {
+        float distance = SDL_sqrtf(distance_squared);
+        float depth = sum_of_radii - distance;
+
+        result.normal = distance > CAPSULE_EPSILON
+            ? vector_divide_scalar(vector_subtract(first_position, second_position), distance)
+            : fallback_normal;
+        result.minimum_translation_vector = vector_multiply_scalar(result.normal, -depth);
+        result.point = vector_add(second_position, vector_multiply_scalar(result.normal, second_radius));
+    }
+
+    if (out_result) {
+        *out_result = result;
+    }
+
+    return collided;
+}
+
+// Tests a segment with a radius against a convex shape with a radius. If the segment and the
+// shape overlap, the separating axis test finds the depth, which is then grown by the radii.
+// Otherwise the distance between them decides whether the rounded shapes overlap.
+static bool collision_capsule_to_shape_ext(
+    Vector start,
+    Vector end,
+    float radius,
+    Vector* points,
+    int points_count,
+    Vector* axes,
+    int axes_count,
+    Vector shape_position,
+    float shape_radius,
+    CollisionResult* out_result)
+{
+    CollisionResult result = (CollisionResult){ 0 };
+    bool collides = false;
+
+    Vector segment_axis = VECTOR_ZERO;
+    bool has_segment_axis = vector_distance_squared(start, end) > CAPSULE_EPSILON;
+    if (has_segment_axis) {
+        segment_axis = vector_normalize(vector_perpendicular(start, end));
+    }
+
+    float min_overlap = FLT_MAX;
+    Vector normal = vector_create(0, -1);
+    bool separated = false;
+
+    for (int i = 0; i < axes_count + has_segment_axis; i++) {
+        Vector axis = i < axes_count ? axes[i] : segment_axis;
+
+        float min_a = SDL_min(vector_dot(start, axis), vector_dot(end, axis));
+        float max_a = SDL_max(vector_dot(start, axis), vector_dot(end, axis));
+
+        float min_b, max_b;
+        collision_shape_to_shape_get_interval(axis, points, points_count, &min_b, &max_b);
+
+        float offset = vector_dot(shape_position, axis);
+        min_b += offset;
+        max_b += offset;
+
+        if (max_a < min_b || max_b < min_a) {
+            separated = true;
+            break;
+        }
+
+        // The normal points from the shape towards the capsule.
+        float forward = max_b - min_a;
+        float backward = max_a - min_b;
+        if (forward < backward) {
+            if (forward < min_overlap) {
+                min_overlap = forward;
+                normal = axis;
+            }
+        } else if (backward < min_overlap) {
+            min_overlap = backward;
+            normal = vector_negate(axis);
+        }
+    }
+
+    if (!separated) {
+        if (min_overlap == FLT_MAX) {
+            min_overlap = 0;
+        }
+
+        // The contact point is the point of the shape furthest into the capsule.
+        Vector deepest = points[0];
+        float deepest_distance = vector_dot(points[0], normal);
+        for (int i = 1; i < points_count; i++) {
+            float distance = vector_dot(points[i], normal);
+            if (distance > deepest_distance) {
+                deepest_distance = distance;
+                deepest = points[i];
+            }
+        }
+
+        result.normal = normal;
+        result.minimum_translation_vector = vector_multiply_scalar(normal, -(min_overlap + radius + shape_radius));
+        result.point = vector_add(vector_add(deepest, shape_position), vector_multiply_scalar(normal, shape_radius));
+        collides = true;
+        goto end;
+    }
+
+    float min_distance = FLT_MAX;
+    Vector capsule_point = VECTOR_ZERO;
+    Vector shape_point = VECTOR_ZERO;
+
+    for (int i = 0, j = points_count - 1; i < points_count; j = i++) {
+        Vector first_closest;
+        Vector second_closest;
+        collision_segment_closest_points(
+            start,
+            end,
+            vector_add(points[j], shape_position),
+            vector_add(points[i], shape_position),
+            &first_closest,
+            &second_closest);
+
+        float distance = vector_distance_squared(first_closest, second_closest);
+        if (distance < min_distance) {
+            min_distance = distance;
+            capsule_point = first_closest;
+            shape_point = second_closest;
+        }
+    }
+
+    collides = collision_rounded_to_rounded_ext(capsule_point, radius, shape_point, shape_radius, normal, &result);
+
+    end:
+        if (out_result) {
+            *out_result = result;
+        }
+
+        return collides;
+}
+
+SOREN_EXPORT bool collision_capsule_to_circle(CapsuleCollider* first, CircleCollider* second) {
+    Vector position = circle_collider_position(second);
+    Vector closest = collision_closest_point_on_segment(capsule_collider_start(first), capsule_collider_end(first), position);
+
+    return collision_radius_to_radius(
+        closest,
+        capsule_collider_radius(first),
+        position,
+        circle_collider_radius(second));
+}
+
+SOREN_EXPORT bool collision_capsule_to_circle_ext(CapsuleCollider* first, CircleCollider* second, CollisionResult* out_result) {
+    Vector position = circle_collider_position(second);
+    Vector closest = collision_closest_point_on_segment(capsule_collider_start(first), capsule_collider_end(first), position);
+
+    return collision_rounded_to_rounded_ext(
+        closest,
+        capsule_collider_radius(first),
+        position,
+        circle_collider_radius(second),
+        collision_capsule_perpendicular(first),
+        out_result);
+}
+
+SOREN_EXPORT bool collision_circle_to_capsule(CircleCollider* first, CapsuleCollider* second) {
+    return collision_capsule_to_circle(second, first);
+}
+
+SOREN_EXPORT bool collision_circle_to_capsule_ext(CircleCollider* first, CapsuleCollider* second, CollisionResult* out_result) {
+    Vector position = circle_collider_position(first);
+    Vector closest = collision_closest_point_on_segment(capsule_collider_start(second), capsule_collider_end(second), position);
+
+    return collision_rounded_to_rounded_ext(
+        position,
+        circle_collider_radius(first),
+        closest,
+        capsule_collider_radius(second),
+        vector_negate(collision_capsule_perpendicular(second)),
+        out_result);
+}
+
+SOREN_EXPORT bool collision_capsule_to_capsule(CapsuleCollider* first, CapsuleCollider* second) {
+    Vector first_closest;
+    Vector second_closest;
+    collision_segment_closest_points(
+        capsule_collider_start(first),
+        capsule_collider_end(first),
+        capsule_collider_start(second),
+        capsule_collider_end(second),
+        &first_closest,
+        &second_closest);
+
+    return collision_radius_to_radius(
+        first_closest,
+        capsule_collider_radius(first),
+        second_closest,
+        capsule_collider_radius(second));
+}
+
+SOREN_EXPORT bool collision_capsule_to_capsule_ext(CapsuleCollider* first, CapsuleCollider* second, CollisionResult* out_result) {
+    Vector first_start = capsule_collider_start(first);
+    Vector first_end = capsule_collider_end(first);
+    Vector second_start = capsule_collider_start(second);
+    Vector second_end = capsule_collider_end(second);
+
+    Vector first_closest;
+    Vector second_closest;
+    collision_segment_closest_points(first_start, first_end, second_start, second_end, &first_closest, &second_closest);
+
+    bool second_is_point = vector_distance_squared(second_start, second_end) <= CAPSULE_EPSILON;
+
+    // When the segments cross, the distance between them doesn't say how far the capsules
+    // need to move apart, so the depth is found with the separating axis test instead.
+    if (vector_distance_squared(first_closest, second_closest) <= CAPSULE_EPSILON * CAPSULE_EPSILON && !second_is_point) {
+        Vector points[2] = { second_start, second_end };
+        Vector axis = vector_normalize(vector_perpendicular(second_start, second_end));
+
+        return collision_capsule_to_shape_ext(
+            first_start,
+            first_end,
+            capsule_collider_radius(first),
+            points,
+            2,
+            &axis,
+            1,
+            VECTOR_ZERO,
+            capsule_collider_radius(second),
+            out_result);
+    }
+
+    return collision_rounded_to_rounded_ext(
+        first_closest,
+        capsule_collider_radius(first),
+        second_closest,
+        capsule_collider_radius(second),
+        collision_capsule_perpendicular(first),
+        out_result);
+}
+
+SOREN_EXPORT bool collision_capsule_to_polygon(CapsuleCollider* first, PolygonCollider* second) {
+    return collision_capsule_to_polygon_ext(first, second, NULL);
+}
+
+SOREN_EXPORT bool collision_capsule_to_polygon_ext(CapsuleCollider* first, PolygonCollider* second, CollisionResult* out_result) {
+    Vector position = vector_subtract(polygon_collider_position(second), polygon_collider_center(second));
+    int points_count = 0;
+    int axes_count = 0;
+    Vector* points = polygon_collider_points(second, &points_count);
+    Vector* axes = polygon_collider_axes(second, &axes_count);
+
+    return collision_capsule_to_shape_ext(
+        capsule_collider_start(first),
+        capsule_collider_end(first),
+        capsule_collider_radius(first),
+        points,
+        points_count,
+        axes,
+        axes_count,
+        position,
+        0,
+        out_result);
+}
+
+SOREN_EXPORT bool collision_capsule_to_rect(CapsuleCollider* first, RectF second) {
+    return collision_capsule_to_rect_ext(first, second, NULL);
+}
+
+SOREN_EXPORT bool collision_capsule_to_rect_ext(CapsuleCollider* first, RectF second, CollisionResult* out_result) {
+    Vector points[4] = {
+        vector_create(second.x, second.y),
+        vector_create(rectf_right(second), second.y),
+        vector_create(rectf_right(second), rectf_bottom(second)),
+        vector_create(second.x, rectf_bottom(second))
+    };
+
+    Vector axes[2] = {
+        vector_create(1, 0),
+        vector_create(0, 1)
+    };
+
+    return collision_capsule_to_shape_ext(
+        capsule_collider_start(first),
+        capsule_collider_end(first),
+        capsule_collider_radius(first),
+        points,
+        4,
+        axes,
+        2,
+        VECTOR_ZERO,
+        0,
+        out_result);
+}
+
+SOREN_EXPORT bool collision_point_to_capsule(Vector point, CapsuleCollider* capsule) {
+    Vector closest = collision_closest_point_on_segment(capsule_collider_start(capsule), capsule_collider_end(capsule), point);
+    return collision_radius_to_radius(point, SOREN_POINT_RADIUS, closest, capsule_collider_radius(capsule));
+}
+
+SOREN_EXPORT bool collision_point_to_capsule_ext(Vector point, CapsuleCollider* capsule, CollisionResult* out_result) {
+    Vector closest = collision_closest_point_on_segment(capsule_collider_start(capsule), capsule_collider_end(capsule), point);
+
+    return collision_rounded_to_rounded_ext(
+        point,
+        SOREN_POINT_RADIUS,
+        closest,
+        capsule_collider_radius(capsule),
+        vector_negate(collision_capsule_perpendicular(capsule)),
+        out_result);
+}
+
+SOREN_EXPORT bool collision_line_to_capsule(LineCollider* line, CapsuleCollider* capsule) {
+    return collision_segment_to_capsule(
+        line_collider_adjusted_start(line),
+        line_collider_adjusted_end(line),
+        capsule);
+}
+
+SOREN_EXPORT bool collision_line_to_capsule_ext(LineCollider* line, CapsuleCollider* capsule, RaycastHit* out_result) {
+    return collision_segment_to_capsule_ext(
+        line_collider_adjusted_start(line),
+        line_collider_adjusted_end(line),
+        capsule,
+        out_result);
+}
+
+SOREN_EXPORT bool collision_segment_to_capsule(Vector start, Vector end, CapsuleCollider* capsule) {
+    Vector segment_closest;
+    Vector capsule_closest;
+    collision_segment_closest_points(
+        start,
+        end,
+        capsule_collider_start(capsule),
+        capsule_collider_end(capsule),
+        &segment_closest,
+        &capsule_closest);
+
+    float radius = capsule_collider_radius(capsule);
+    return vector_distance_squared(segment_closest, capsule_closest) <= radius * radius;
+}
+
+// Casts the segment against both caps and both sides of the capsule, keeping the closest hit.
+SOREN_EXPORT bool collision_segment_to_capsule_ext(Vector start, Vector end, CapsuleCollider* capsule, RaycastHit* out_result) {
+    RaycastHit hit = (RaycastHit){0};
+    bool collides = false;
+
+    Vector capsule_start = capsule_collider_start(capsule);
+    Vector capsule_end = capsule_collider_end(capsule);
+    float radius = capsule_collider_radius(capsule);
+
+    Vector closest = collision_closest_point_on_segment(capsule_start, capsule_end, start);
+    if (vector_distance_squared(start, closest) <= radius * radius) {
+        hit.point = start;
+        hit.normal = vector_distance_squared(start, closest) > CAPSULE_EPSILON
+            ? vector_normalize(vector_subtract(start, closest))
+            : collision_capsule_perpendicular(capsule);
+        collides = true;
+        goto end;
+    }
+
+    float line_length = vector_distance(start, end);
+    float fraction = FLT_MAX;
+    Vector normal = VECTOR_ZERO;
+
+    RaycastHit cap_hit;
+    if (collision_segment_to_radius_ext(start, end, capsule_start, radius, &cap_hit) && cap_hit.fraction < fraction) {
+        fraction = cap_hit.fraction;
+        normal = cap_hit.normal;
+    }
+
+    if (collision_segment_to_radius_ext(start, end, capsule_end, radius, &cap_hit) && cap_hit.fraction < fraction) {
+        fraction = cap_hit.fraction;
+        normal = cap_hit.normal;
+    }
+
+    Vector perpendicular = collision_capsule_perpendicular(capsule);
+    for (int side = -1; side <= 1; side += 2) {
+        Vector side_normal = vector_multiply_scalar(perpendicular, (float)side);
+        Vector offset = vector_multiply_scalar(side_normal, radius);
+
+        Vector intersection;
+        if (collision_segment_to_segment_intersection(start, end, vector_add(capsule_start, offset), vector_add(capsule_end, offset), &intersection)) {
+            float side_fraction = vector_distance(start, intersection) / line_length;
+            if (side_fraction < fraction) {
+                fraction = side_fraction;
+                normal = side_normal;
+            }
+        }
+    }
+
+    if (fraction > 1) {
+        goto end;
+    }
+
+    hit.fraction = fraction;
+    hit.distance = line_length * fraction;
+    hit.point = vector_add(start, vector_multiply_scalar(vector_subtract(end, start), fraction));
+    hit.normal = normal;
+    collides = true;
+
+    end:
+        if (out_result) {
+            *out_result = hit;
+        }
+
+        return collides;
+}
+
+// A collider reduced to either a circle or a convex set of points for the swept tests below.
+// Capsules are a segment with a radius. Points, lines, and capsules use the internal storage,
+// since they don't keep their points in an array.
+typedef struct CollisionCastShape {
+    Vector* points;
+    Vector* axes;
+    int points_count;
+    int axes_count;
+    Vector position;
+    float radius;
+    bool is_circle;
+    Vector point_storage[2];
+    Vector axis_storage[2];
+} CollisionCastShape;
+
+static void collision_cast_shape_init(CollisionCastShape* shape, Collider* collider) {
+    *shape = (CollisionCastShape){0};
+
+    switch (collider->collider_type) {
+        case COLLIDER_CIRCLE:
+            shape->is_circle = true;
+            shape->position = circle_collider_position((CircleCollider*)collider);
+            shape->radius = circle_collider_radius((CircleCollider*)collider);
+            break;
+        case COLLIDER_CAPSULE:
+            CapsuleCollider* capsule = (CapsuleCollider*)collider;
+            Vector capsule_start = capsule_collider_start(capsule);
+            Vector capsule_end = capsule_collider_end(capsule);
+
+            shape->point_storage[0] = capsule_start;
+            shape->point_storage[1] = capsule_end;
+            shape->points = shape->point_storage;
+            shape->radius = capsule_collider_radius(capsule);
+
+            // A capsule that's no taller than it is wide is a circle around a single point.
+            if (vector_equals(capsule_start, capsule_end)) {
+                shape->points_count = 1;
+                break;
+            }
+
+            shape->points_count = 2;
+            shape->axis_storage[0] = vector_normalize(vector_perpendicular(capsule_start, capsule_end));
+            shape->axis_storage[1] = capsule->axis;
+            shape->axes = shape->axis_storage;
+            shape->axes_count = 2;
+            break;
+        case COLLIDER_POINT:
+            PointCollider* point = (PointCollider*)collider;
+            if (point_collider_using_internal_collider(point)) {
+                collision_cast_shape_init(shape, (Collider*)point->box);
+            } else {
+                shape->point_storage[0] = VECTOR_ZERO;
+                shape->points = shape->point_storage;
+                shape->points_count = 1;
+                shape->position = point_collider_position(point);
+            }
+            break;
+        case COLLIDER_LINE:
+            LineCollider* line = (LineCollider*)collider;
+            Vector start = line_collider_adjusted_start(line);
+            Vector end = line_collider_adjusted_end(line);
+
+            shape->point_storage[0] = start;
+            shape->point_storage[1] = end;
+            shape->points = shape->point_storage;
+            shape->points_count = 2;
+
+            // A segment needs to be tested along its direction as well as its normal.
+            shape->axis_storage[0] = vector_normalize(vector_perpendicular(start, end));
+            shape->axis_storage[1] = vector_normalize(vector_subtract(end, start));
+            shape->axes = shape->axis_storage;
+            shape->axes_count = 2;
+            break;
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            PolygonCollider* polygon = (PolygonCollider*)collider;
+            shape->points = polygon_collider_points(polygon, &shape->points_count);
+            shape->axes = polygon_collider_axes(polygon, &shape->axes_count);
+            shape->position = vector_subtract(polygon_collider_position(polygon), polygon_collider_center(polygon));
+            break;
+        default:
+            throw(InvalidColliderType, "Invalid collider type");
+            break;
+    }
+}
+
+static Vector collision_cast_shape_center(CollisionCastShape* shape) {
+    if (shape->points_count == 0) {
+        return shape->position;
+    }
+
+    Vector sum = VECTOR_ZERO;
+    for (int i = 0; i < shape->points_count; i++) {
+        sum = vector_add(sum, shape->points[i]);
+    }
+
+    return vector_add(shape->position, vector_divide_scalar(sum, (float)shape->points_count));
+}
+
+// The normal for shapes that already overlap when the cast starts. There's no contact to take
+// it from, so it points against the motion, or away from the other shape when there is no
+// motion, and finally straight up when the shapes are centered on each other.
+static Vector collision_cast_overlap_normal(Vector delta, Vector first_center, Vector second_center) {
+    float length_squared = vector_length_squared(delta);
+    if (length_squared > CAPSULE_EPSILON * CAPSULE_EPSILON) {
+        return vector_divide_scalar(vector_negate(delta), SDL_sqrtf(length_squared));
+    }
+
+    Vector offset = vector_subtract(first_center, second_center);
+    length_squared = vector_length_squared(offset);
+
+    return length_squared > CAPSULE_EPSILON * CAPSULE_EPSILON
+        ? vector_divide_scalar(offset, SDL_sqrtf(length_squared))
+        : vector_create(0, -1);
+}
+
+static bool collision_cast_radius_overlaps_shape(Vector position, float radius, CollisionCastShape* shape) {
+    Vector offset = vector_subtract(position, shape->position);
+    float radius_squared = radius * radius;
+
+    if (shape->points_count == 1) {
+        return vector_distance_squared(offset, shape->points[0]) <= radius_squared;
+    }
+
+    bool has_positive = false;
+    bool has_negative = false;
+
+    for (int i = 0, j = shape->points_count - 1; i < shape->points_count; j = i++) {
+        Vector closest = collisions_closest_point_on_line(shape->points[j], shape->points[i], offset);
+        if (vector_distance_squared(offset, closest) <= radius_squared) {
+            return true;
+        }
+
+        float side = vector_cross(vector_subtract(shape->points[i], shape->points[j]), vector_subtract(offset, shape->points[j]));
+        has_positive |= side > 0;
+        has_negative |= side < 0;
+    }
+
+    // The center is inside the shape if it's on the same side of every edge.
+    return shape->points_count > 2 && !(has_positive && has_negative);
+}
+
+// Sweeps a circle against a stationary shape by casting its center against the shape
+// expanded by the radius. The expanded shape is made up of every edge offset by the
+// radius and a circle around every point.
+static bool collision_cast_radius_to_shape(Vector position, float radius, Vector delta, CollisionCastShape* shape, float* out_fraction, Vector* out_normal) {
+    if (collision_cast_radius_overlaps_shape(position, radius, shape)) {
+        *out_fraction = 0;
+        *out_normal = collision_cast_overlap_normal(delta, position, collision_cast_shape_center(shape));
+        return true;
+    }
+
+    Vector end = vector_add(position, delta);
+    float delta_length_squared = vector_dot(delta, delta);
+    float fraction = FLT_MAX;
+    Vector normal = VECTOR_ZERO;
+
+    for (int i = 0; i < shape->points_count; i++) {
+        Vector point = vector_add(shape->points[i], shape->position);
+
+        RaycastHit hit;
+        if (collision_segment_to_radius_ext(position, end, point, radius, &hit) && hit.fraction < fraction) {
+            fraction = hit.fraction;
+            normal = hit.normal;
+        }
+    }
+
+    // Each edge is offset towards the side facing the motion, which is picked from the
+    // direction of the sweep so the winding of the shape doesn't matter. The other side
+    // faces away from the circle, so it can never be hit first.
+    for (int i = 0, j = shape->points_count - 1; shape->points_count > 1 && i < shape->points_count; j = i++) {
+        Vector edge_start = vector_add(shape->points[j], shape->position);
+        Vector edge_end = vector_add(shape->points[i], shape->position);
+        Vector edge_normal = vector_normalize(vector_perpendicular(edge_start, edge_end));
+
+        if (vector_dot(edge_normal, delta) > 0) {
+            edge_normal = vector_negate(edge_normal);
+        }
+
+        Vector offset = vector_multiply_scalar(edge_normal, radius);
+
+        Vector intersection;
+        if (collision_segment_to_segment_intersection(position, end, vector_add(edge_start, offset), vector_add(edge_end, offset), &intersection)) {
+            float edge_fraction = vector_dot(vector_subtract(intersection, position), delta) / delta_length_squared;
+            if (edge_fraction < fraction) {
+                fraction = edge_fraction;
+                normal = edge_normal;
+            }
+        }
+    }
+
+    if (fraction > 1) {
+        return false;
+    }
+
+    *out_fraction = fraction;
+    *out_normal = normal;
+    return true;
+}
+
+// Sweeps shapes when at least one of them is a capsule. The closest points of two convex shapes
+// always include a point of one of them, so the first contact is found by casting every point
+// of each shape, grown by both radii, against the other shape.
+static bool collision_cast_rounded_to_shape(CollisionCastShape* first, Vector delta, CollisionCastShape* second, float* out_fraction, Vector* out_normal) {
+    CollisionCastShape* capsule = first->radius > 0 ? first : second;
+    CollisionCastShape* other = capsule == first ? second : first;
+
+    Vector capsule_start = capsule->points[0];
+    Vector capsule_end = capsule->points[capsule->points_count - 1];
+    bool overlaps;
+
+    // Points and round capsules don't have any axes, so the separating axis test can't
+    // rule them out. Their distance to the segment decides whether they overlap instead.
+    if (other->axes_count == 0) {
+        Vector point = vector_add(other->points[0], other->position);
+        Vector closest = collision_closest_point_on_segment(capsule_start, capsule_end, point);
+        float radius = capsule->radius + other->radius;
+        overlaps = vector_distance_squared(closest, point) < radius * radius;
+    } else {
+        // Segments can cross a shape without any of the points being close to the other shape.
+        overlaps = collision_capsule_to_shape_ext(
+            capsule_start,
+            capsule_end,
+            capsule->radius,
+            other->points,
+            other->points_count,
+            other->axes,
+            other->axes_count,
+            other->position,
+            other->radius,
+            NULL);
+    }
+
+    if (overlaps) {
+        *out_fraction = 0;
+        *out_normal = collision_cast_overlap_normal(delta, collision_cast_shape_center(first), collision_cast_shape_center(second));
+        return true;
+    }
+
+    float radius = first->radius + second->radius;
+    float fraction = FLT_MAX;
+    Vector normal = VECTOR_ZERO;
+    float point_fraction;
+    Vector point_normal;
+
+    for (int i = 0; i < first->points_count; i++) {
+        Vector position = vector_add(first->points[i], first->position);
+        if (collision_cast_radius_to_shape(position, radius, delta, second, &point_fraction, &point_normal) && point_fraction < fraction) {
+            fraction = point_fraction;
+            normal = point_normal;
+        }
+    }
+
+    // The points of the second shape are cast backwards against the moving shape.
+    for (int i = 0; i < second->points_count; i++) {
+        Vector position = vector_add(second->points[i], second->position);
+        if (collision_cast_radius_to_shape(position, radius, vector_negate(delta), first, &point_fraction, &point_normal) && point_fraction < fraction) {
+            fraction = point_fraction;
+            normal = vector_negate(point_normal);
+        }
+    }
+
+    if (fraction > 1) {
+        return false;
+    }
+
+    *out_fraction = fraction;
+    *out_normal = normal;
+    return true;
+}
+
+// Swept separating axis test. For each axis, finds the span of time that the projections
+// of the shapes overlap while the first one moves along delta. The shapes touch when the
+// spans on every axis overlap, starting at the latest time any axis starts overlapping.
+static bool collision_cast_shape_to_shape(CollisionCastShape* first, Vector delta, CollisionCastShape* second, float* out_fraction, Vector* out_normal) {
+    float enter = 0;
+    float exit = 1;
+    Vector normal = collision_cast_overlap_normal(delta, collision_cast_shape_center(first), collision_cast_shape_center(second));
+
+    for (int i = 0; i < first->axes_count + second->axes_count; i++) {
+        Vector axis = i < first->axes_count ? first->axes[i] : second->axes[i - first->axes_count];
+
+        float min_a, max_a, min_b, max_b;
+        collision_shape_to_shape_get_interval(axis, first->points, first->points_count, &min_a, &max_a);
+        collision_shape_to_shape_get_interval(axis, second->points, second->points_count, &min_b, &max_b);
+
+        float offset_a = vector_dot(first->position, axis);
+        float offset_b = vector_dot(second->position, axis);
+        min_a += offset_a;
+        max_a += offset_a;
+        min_b += offset_b;
+        max_b += offset_b;
+
+        float speed = vector_dot(delta, axis);
+        float axis_enter;
+        float axis_exit;
+        Vector axis_normal;
+
+        if (max_a < min_b) {
+            if (speed <= 0) {
+                return false;
+            }
+
+            axis_enter = (min_b - max_a) / speed;
+            axis_exit = (max_b - min_a) / speed;
+            axis_normal = vector_negate(axis);
+        } else if (max_b < min_a) {
+            if (speed >= 0) {
+                return false;
+            }
+
+            axis_enter = (max_b - min_a) / speed;
+            axis_exit = (min_b - max_a) / speed;
+            axis_normal = axis;
+        } else {
+            axis_enter = 0;
+            axis_normal = normal;
+
+            if (speed > 0) {
+                axis_exit = (max_b - min_a) / speed;
+            } else if (speed < 0) {
+                axis_exit = (min_b - max_a) / speed;
+            } else {
+                axis_exit = FLT_MAX;
+            }
+        }
+
+        if (axis_enter > enter) {
+            enter = axis_enter;
+            normal = axis_normal;
+        }
+
+        exit = SDL_min(exit, axis_exit);
+
+        if (enter > exit) {
+            return false;
+        }
+    }
+
+    // Two points don't have any axes to test and can't be meaningfully cast against each other.
+    if (first->axes_count + second->axes_count == 0) {
+        return false;
+    }
+
+    *out_fraction = enter;
+    *out_normal = normal;
+    return true;
+}
+
+SOREN_EXPORT bool collision_cast_collider(Collider* collider, Vector delta, Collider* other, RaycastHit* out_hit) {
+    CollisionCastShape first;
+    CollisionCastShape second;
+    collision_cast_shape_init(&first, collider);
+    collision_cast_shape_init(&second, other);
+
+    float fraction = 0;
+    Vector normal = VECTOR_ZERO;
+    bool collides;
+
+    if (first.is_circle && second.is_circle) {
+        RaycastHit hit;
+        collides = !vector_equals(delta, VECTOR_ZERO)
+            ? collision_segment_to_radius_ext(first.position, vector_add(first.position, delta), second.position, first.radius + second.radius, &hit)
+            : collision_radius_to_radius(first.position, first.radius, second.position, second.radius);
+
+        if (collides) {
+            fraction = vector_equals(delta, VECTOR_ZERO) ? 0 : hit.fraction;
+
+            // Overlapping circles are pushed apart along the line between their centers,
+            // unless the centers are on top of each other.
+            Vector offset = vector_subtract(first.position, second.position);
+            float distance = vector_length(offset);
+            if (fraction != 0) {
+                normal = hit.normal;
+            } else if (distance > CAPSULE_EPSILON) {
+                normal = vector_divide_scalar(offset, distance);
+            } else {
+                normal = collision_cast_overlap_normal(delta, first.position, second.position);
+            }
+        }
+    } else if (first.is_circle) {
+        collides = collision_cast_radius_to_shape(first.position, first.radius + second.radius, delta, &second, &fraction, &normal);
+    } else if (second.is_circle) {
+        // Cast the circle backwards against the moving shape instead.
+        collides = collision_cast_radius_to_shape(second.position, first.radius + second.radius, vector_negate(delta), &first, &fraction, &normal);
+        normal = vector_negate(normal);
+    } else if (first.radius > 0 || second.radius > 0) {
+        collides = collision_cast_rounded_to_shape(&first, delta, &second, &fraction, &normal);
+    } else {
+        collides = collision_cast_shape_to_shape(&first, delta, &second, &fraction, &normal);
+    }
+
+    if (collides && out_hit) {
+        out_hit->fraction = fraction;
+        out_hit->distance = vector_length(delta) * fraction;
+        out_hit->point = vector_add(collider_position(collider), vector_multiply_scalar(delta, fraction));
+        out_hit->normal = normal;
+    }
+
+    return collides;
+}
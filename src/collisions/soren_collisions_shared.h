@@ -7,5 +7,82 @@ void polygon_collider_free_resources(PolygonCollider* polygon);
 void point_collider_free_resources(PointCollider* point);
 void collider_assert_scale(float scale);
 BoxCollider* collision_shared_box_collider_init(RectF bounds);
+float collider_point_distance(Collider* collider, Vector point);
+
+// Segments shorter than this are treated as a single point by the capsule tests.
+#define CAPSULE_EPSILON 0.0001f
+
+// Unlike collisions_closest_point_on_line, this works when the segment is a single point,
+// which is the case for capsules that are no taller than they are wide.
+Vector collision_closest_point_on_segment(Vector start, Vector end, Vector point);
+
+// Floors a cell coordinate. Only valid for values greater than -32768.
+static inline int fast_floor(float x) {
+    return (int)(x + 32768) - 32768;
+}
+
+// Reserves a block of 2^32 query epochs for a broadphase, which increments its own
+// epoch for each query. The blocks are handed out atomically and never overlap, so
+// a collider in more than one broadphase can't be mistaken as visited, and queries
+// on different broadphases never race on a shared counter.
+uint64_t collider_reserve_query_epochs(void);
+
+// Returns true the first time the collider is seen by the query with the given epoch.
+static inline bool collider_query_visit(Collider* collider, uint64_t epoch) {
+    if (collider->query_epoch == epoch) {
+        return false;
+    }
+
+    collider->query_epoch = epoch;
+    return true;
+}
+
+// Keeps the closest colliders to a point sorted by distance for the nearest
+// neighbour queries of the broadphases.
+typedef struct NearestColliders {
+    Collider** colliders;
+    float* distances;
+    int capacity;
+    int count;
+    float max_distance;
+} NearestColliders;
+
+// The distance a collider needs to be under to be added.
+static inline float nearest_colliders_threshold(NearestColliders* nearest) {
+    return nearest->count < nearest->capacity ? nearest->max_distance : nearest->distances[nearest->count - 1];
+}
+
+static inline bool nearest_colliders_contains(NearestColliders* nearest, Collider* collider) {
+    for (int i = 0; i < nearest->count; i++) {
+        if (nearest->colliders[i] == collider) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline void nearest_colliders_add(NearestColliders* nearest, Collider* collider, float distance) {
+    if (nearest->count < nearest->capacity ? distance > nearest->max_distance : distance >= nearest->distances[nearest->count - 1]) {
+        return;
+    }
+
+    int index = nearest->count < nearest->capacity ? nearest->count++ : nearest->count - 1;
+
+    while (index > 0 && nearest->distances[index - 1] > distance) {
+        nearest->colliders[index] = nearest->colliders[index - 1];
+        nearest->distances[index] = nearest->distances[index - 1];
+        index--;
+    }
+
+    nearest->colliders[index] = collider;
+    nearest->distances[index] = distance;
+}
+
+static inline float rectf_point_distance(RectF rect, Vector point) {
+    float x = SDL_max(0, SDL_max(rectf_left(rect) - point.x, point.x - rectf_right(rect)));
+    float y = SDL_max(0, SDL_max(rectf_top(rect) - point.y, point.y - rectf_bottom(rect)));
+    return SDL_sqrtf(x * x + y * y);
+}
 
 #endif
\ No newline at end of file
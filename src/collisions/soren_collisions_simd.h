@@ -0,0 +1,283 @@
+#ifndef SOREN_COLLISIONS_SIMD_H
+#define SOREN_COLLISIONS_SIMD_H
+
+#include <soren_math.h>
+
+#include <float.h>
+
+// Kernels used by the separating axis tests and the polygon transforms. The points are
+// read straight from the packed x, y pairs of the Vector arrays, so no conversion is
+// needed to use them.
+//
+// The instruction set is chosen at build time, the same way as SFMT. Define HAVE_AVX2,
+// HAVE_SSE2, or HAVE_NEON to pick one explicitly. Otherwise AVX2 is used when the compiler
+// targets it, then SSE2 on x86 and x64, then NEON on ARM. Define SOREN_NO_SIMD to always
+// use the scalar kernels.
+
+#if !defined(SOREN_NO_SIMD)
+    #if defined(HAVE_AVX2) || defined(__AVX2__)
+        #define SOREN_SIMD_AVX2
+    #elif defined(HAVE_SSE2) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SOREN_SIMD_SSE2
+    #elif defined(HAVE_NEON) || defined(__ARM_NEON) || defined(_M_ARM64)
+        #define SOREN_SIMD_NEON
+    #endif
+#endif
+
+#if defined(SOREN_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(SOREN_SIMD_SSE2)
+    #include <emmintrin.h>
+#elif defined(SOREN_SIMD_NEON)
+    #include <arm_neon.h>
+#endif
+
+#if defined(SOREN_SIMD_AVX2) || defined(SOREN_SIMD_SSE2)
+
+// Splits four packed points into their x and y components.
+static inline void collision_simd_load_points4(const Vector* points, __m128* out_x, __m128* out_y) {
+    __m128 first = _mm_loadu_ps((const float*)points);
+    __m128 second = _mm_loadu_ps((const float*)(points + 2));
+    *out_x = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+    *out_y = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+static inline float collision_simd_hmin4(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float collision_simd_hmax4(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+#endif
+
+// Projects every point onto the axis and returns the smallest and largest projections.
+static inline void collision_project_points(Vector axis, const Vector* points, int points_count, float* out_min, float* out_max) {
+    int i = 0;
+    float min = FLT_MAX;
+    float max = -FLT_MAX;
+
+#if defined(SOREN_SIMD_AVX2)
+    if (points_count >= 8) {
+        __m256 axis_x = _mm256_set1_ps(axis.x);
+        __m256 axis_y = _mm256_set1_ps(axis.y);
+        __m256 mins = _mm256_set1_ps(FLT_MAX);
+        __m256 maxs = _mm256_set1_ps(-FLT_MAX);
+
+        for (; i + 8 <= points_count; i += 8) {
+            // The shuffle works within each 128 bit lane, so the components come out
+            // in a different order than the points. The order doesn't matter here.
+            __m256 first = _mm256_loadu_ps((const float*)(points + i));
+            __m256 second = _mm256_loadu_ps((const float*)(points + i + 4));
+            __m256 xs = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 ys = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+            __m256 dots = _mm256_add_ps(_mm256_mul_ps(xs, axis_x), _mm256_mul_ps(ys, axis_y));
+
+            mins = _mm256_min_ps(mins, dots);
+            maxs = _mm256_max_ps(maxs, dots);
+        }
+
+        min = collision_simd_hmin4(_mm_min_ps(_mm256_castps256_ps128(mins), _mm256_extractf128_ps(mins, 1)));
+        max = collision_simd_hmax4(_mm_max_ps(_mm256_castps256_ps128(maxs), _mm256_extractf128_ps(maxs, 1)));
+    }
+#endif
+
+#if defined(SOREN_SIMD_AVX2) || defined(SOREN_SIMD_SSE2)
+    if (i + 4 <= points_count) {
+        __m128 axis_x = _mm_set1_ps(axis.x);
+        __m128 axis_y = _mm_set1_ps(axis.y);
+        __m128 mins = _mm_set1_ps(min);
+        __m128 maxs = _mm_set1_ps(max);
+
+        for (; i + 4 <= points_count; i += 4) {
+            __m128 xs;
+            __m128 ys;
+            collision_simd_load_points4(points + i, &xs, &ys);
+
+            __m128 dots = _mm_add_ps(_mm_mul_ps(xs, axis_x), _mm_mul_ps(ys, axis_y));
+            mins = _mm_min_ps(mins, dots);
+            maxs = _mm_max_ps(maxs, dots);
+        }
+
+        min = collision_simd_hmin4(mins);
+        max = collision_simd_hmax4(maxs);
+    }
+#elif defined(SOREN_SIMD_NEON)
+    if (i + 4 <= points_count) {
+        float32x4_t mins = vdupq_n_f32(min);
+        float32x4_t maxs = vdupq_n_f32(max);
+
+        for (; i + 4 <= points_count; i += 4) {
+            // Loads four points with the x and y components split into separate registers.
+            float32x4x2_t xy = vld2q_f32((const float*)(points + i));
+            float32x4_t dots = vmlaq_n_f32(vmulq_n_f32(xy.val[0], axis.x), xy.val[1], axis.y);
+
+            mins = vminq_f32(mins, dots);
+            maxs = vmaxq_f32(maxs, dots);
+        }
+
+        float32x2_t min_pair = vpmin_f32(vget_low_f32(mins), vget_high_f32(mins));
+        float32x2_t max_pair = vpmax_f32(vget_low_f32(maxs), vget_high_f32(maxs));
+        min = vget_lane_f32(vpmin_f32(min_pair, min_pair), 0);
+        max = vget_lane_f32(vpmax_f32(max_pair, max_pair), 0);
+    }
+#endif
+
+    for (; i < points_count; i++) {
+        float dot = vector_dot(points[i], axis);
+        if (dot < min)
+            min = dot;
+
+        if (dot > max)
+            max = dot;
+    }
+
+    *out_min = min;
+    *out_max = max;
+}
+
+// Transforms every point by the matrix and returns the bounds of the transformed points.
+// The points and the transformed points can't overlap unless they're the same array.
+static inline RectF collision_transform_points(const Vector* points, Vector* out_points, int points_count, const Matrix* matrix) {
+    int i = 0;
+    float min_x = FLT_MAX;
+    float min_y = FLT_MAX;
+    float max_x = -FLT_MAX;
+    float max_y = -FLT_MAX;
+
+#if defined(SOREN_SIMD_AVX2) || defined(SOREN_SIMD_SSE2)
+    if (points_count >= 4) {
+        __m128 m11 = _mm_set1_ps(matrix->m11);
+        __m128 m12 = _mm_set1_ps(matrix->m12);
+        __m128 m21 = _mm_set1_ps(matrix->m21);
+        __m128 m22 = _mm_set1_ps(matrix->m22);
+        __m128 m31 = _mm_set1_ps(matrix->m31);
+        __m128 m32 = _mm_set1_ps(matrix->m32);
+        __m128 mins_x = _mm_set1_ps(FLT_MAX);
+        __m128 mins_y = _mm_set1_ps(FLT_MAX);
+        __m128 maxs_x = _mm_set1_ps(-FLT_MAX);
+        __m128 maxs_y = _mm_set1_ps(-FLT_MAX);
+
+        for (; i + 4 <= points_count; i += 4) {
+            __m128 xs;
+            __m128 ys;
+            collision_simd_load_points4(points + i, &xs, &ys);
+
+            __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, m11), _mm_mul_ps(ys, m21)), m31);
+            __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, m12), _mm_mul_ps(ys, m22)), m32);
+
+            // Interleaving the components puts the points back in their original order.
+            _mm_storeu_ps((float*)(out_points + i), _mm_unpacklo_ps(x, y));
+            _mm_storeu_ps((float*)(out_points + i + 2), _mm_unpackhi_ps(x, y));
+
+            mins_x = _mm_min_ps(mins_x, x);
+            mins_y = _mm_min_ps(mins_y, y);
+            maxs_x = _mm_max_ps(maxs_x, x);
+            maxs_y = _mm_max_ps(maxs_y, y);
+        }
+
+        min_x = collision_simd_hmin4(mins_x);
+        min_y = collision_simd_hmin4(mins_y);
+        max_x = collision_simd_hmax4(maxs_x);
+        max_y = collision_simd_hmax4(maxs_y);
+    }
+#elif defined(SOREN_SIMD_NEON)
+    if (points_count >= 4) {
+        float32x4_t mins_x = vdupq_n_f32(FLT_MAX);
+        float32x4_t mins_y = vdupq_n_f32(FLT_MAX);
+        float32x4_t maxs_x = vdupq_n_f32(-FLT_MAX);
+        float32x4_t maxs_y = vdupq_n_f32(-FLT_MAX);
+
+        for (; i + 4 <= points_count; i += 4) {
+            float32x4x2_t xy = vld2q_f32((const float*)(points + i));
+            float32x4x2_t result;
+            result.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(matrix->m31), xy.val[0], matrix->m11), xy.val[1], matrix->m21);
+            result.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(matrix->m32), xy.val[0], matrix->m12), xy.val[1], matrix->m22);
+            vst2q_f32((float*)(out_points + i), result);
+
+            mins_x = vminq_f32(mins_x, result.val[0]);
+            mins_y = vminq_f32(mins_y, result.val[1]);
+            maxs_x = vmaxq_f32(maxs_x, result.val[0]);
+            maxs_y = vmaxq_f32(maxs_y, result.val[1]);
+        }
+
+        float32x2_t pair = vpmin_f32(vget_low_f32(mins_x), vget_high_f32(mins_x));
+        min_x = vget_lane_f32(vpmin_f32(pair, pair), 0);
+        pair = vpmin_f32(vget_low_f32(mins_y), vget_high_f32(mins_y));
+        min_y = vget_lane_f32(vpmin_f32(pair, pair), 0);
+        pair = vpmax_f32(vget_low_f32(maxs_x), vget_high_f32(maxs_x));
+        max_x = vget_lane_f32(vpmax_f32(pair, pair), 0);
+        pair = vpmax_f32(vget_low_f32(maxs_y), vget_high_f32(maxs_y));
+        max_y = vget_lane_f32(vpmax_f32(pair, pair), 0);
+    }
+#endif
+
+    for (; i < points_count; i++) {
+        Vector p = points[i];
+        p = (Vector){
+            .x = p.x * matrix->m11 + p.y * matrix->m21 + matrix->m31,
+            .y = p.x * matrix->m12 + p.y * matrix->m22 + matrix->m32
+        };
+
+        if (p.x < min_x)
+            min_x = p.x;
+        if (p.x > max_x)
+            max_x = p.x;
+        if (p.y < min_y)
+            min_y = p.y;
+        if (p.y > max_y)
+            max_y = p.y;
+
+        out_points[i] = p;
+    }
+
+    return (RectF){ min_x, min_y, max_x - min_x, max_y - min_y };
+}
+
+// Returns the squared distance from the origin of the points to the furthest point.
+static inline float collision_points_radius_squared(const Vector* points, int points_count) {
+    int i = 0;
+    float max = 0;
+
+#if defined(SOREN_SIMD_AVX2) || defined(SOREN_SIMD_SSE2)
+    if (points_count >= 4) {
+        __m128 maxs = _mm_setzero_ps();
+
+        for (; i + 4 <= points_count; i += 4) {
+            __m128 xs;
+            __m128 ys;
+            collision_simd_load_points4(points + i, &xs, &ys);
+            maxs = _mm_max_ps(maxs, _mm_add_ps(_mm_mul_ps(xs, xs), _mm_mul_ps(ys, ys)));
+        }
+
+        max = collision_simd_hmax4(maxs);
+    }
+#elif defined(SOREN_SIMD_NEON)
+    if (points_count >= 4) {
+        float32x4_t maxs = vdupq_n_f32(0);
+
+        for (; i + 4 <= points_count; i += 4) {
+            float32x4x2_t xy = vld2q_f32((const float*)(points + i));
+            maxs = vmaxq_f32(maxs, vmlaq_f32(vmulq_f32(xy.val[0], xy.val[0]), xy.val[1], xy.val[1]));
+        }
+
+        float32x2_t max_pair = vpmax_f32(vget_low_f32(maxs), vget_high_f32(maxs));
+        max = vget_lane_f32(vpmax_f32(max_pair, max_pair), 0);
+    }
+#endif
+
+    for (; i < points_count; i++) {
+        float length_squared = vector_length_squared(points[i]);
+        if (length_squared > max)
+            max = length_squared;
+    }
+
+    return max;
+}
+
+#endif
@@ -0,0 +1,613 @@
+#include <collisions/soren_gjk.h>
+
+#include <float.h>
+
+#include "soren_collisions_shared.h"
+
+#define GJK_MAX_ITERATIONS 32
+#define GJK_EPSILON 0.00001f
+
+// Must be a power of two.
+#define GJK_CACHE_SIZE 256
+
+#define EPA_MAX_POINTS 32
+#define EPA_TOLERANCE 0.001f
+
+// A collider reduced to a convex set of points and a radius.
+// Points and lines use the internal storage, since they don't keep their points in an array.
+typedef struct GjkShape {
+    Vector* points;
+    Vector position;
+    int points_count;
+    float radius;
+    Vector point_storage[2];
+} GjkShape;
+
+typedef struct GjkVertex {
+    Vector first;
+    Vector second;
+    // The point on the Minkowski difference of the shapes, second - first.
+    Vector point;
+    float weight;
+    int first_index;
+    int second_index;
+} GjkVertex;
+
+typedef struct GjkSimplex {
+    GjkVertex vertices[3];
+    int count;
+} GjkSimplex;
+
+// Only the support indices are cached, so the simplex is rebuilt from where
+// the colliders are now. Indices that are out of range are discarded, which
+// covers colliders that were freed and had their address reused.
+typedef struct GjkCacheEntry {
+    Collider* first;
+    Collider* second;
+    int first_indices[3];
+    int second_indices[3];
+    int count;
+} GjkCacheEntry;
+
+// Read by the narrowphase pool workers, so it's atomic in case another thread sets it.
+static SDL_AtomicInt collision_current_backend = { COLLISION_BACKEND_SAT };
+static soren_thread_local GjkCacheEntry gjk_cache[GJK_CACHE_SIZE];
+
+SOREN_EXPORT CollisionBackend collision_backend(void) {
+    return (CollisionBackend)SDL_GetAtomicInt(&collision_current_backend);
+}
+
+SOREN_EXPORT void collision_set_backend(CollisionBackend backend) {
+    SDL_SetAtomicInt(&collision_current_backend, backend);
+}
+
+SOREN_EXPORT void collision_gjk_clear_cache(void) {
+    SDL_memset(gjk_cache, 0, sizeof(gjk_cache));
+}
+
+static void gjk_shape_init(GjkShape* shape, Collider* collider) {
+    *shape = (GjkShape){0};
+
+    switch (collider->collider_type) {
+        case COLLIDER_CIRCLE:
+            CircleCollider* circle = (CircleCollider*)collider;
+            shape->points = shape->point_storage;
+            shape->points_count = 1;
+            shape->position = circle_collider_position(circle);
+            shape->radius = circle_collider_radius(circle);
+            break;
+        case COLLIDER_CAPSULE:
+            CapsuleCollider* capsule = (CapsuleCollider*)collider;
+            shape->point_storage[0] = capsule_collider_start(capsule);
+            shape->point_storage[1] = capsule_collider_end(capsule);
+            shape->points = shape->point_storage;
+            shape->points_count = 2;
+            shape->radius = capsule_collider_radius(capsule);
+            break;
+        case COLLIDER_POINT:
+            PointCollider* point = (PointCollider*)collider;
+            if (point_collider_using_internal_collider(point)) {
+                gjk_shape_init(shape, (Collider*)point->box);
+            } else {
+                shape->points = shape->point_storage;
+                shape->points_count = 1;
+                shape->position = point_collider_position(point);
+            }
+            break;
+        case COLLIDER_LINE:
+            LineCollider* line = (LineCollider*)collider;
+            shape->point_storage[0] = line_collider_adjusted_start(line);
+            shape->point_storage[1] = line_collider_adjusted_end(line);
+            shape->points = shape->point_storage;
+            shape->points_count = 2;
+            break;
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            PolygonCollider* polygon = (PolygonCollider*)collider;
+            shape->points = polygon_collider_points(polygon, &shape->points_count);
+            shape->position = vector_subtract(polygon_collider_position(polygon), polygon_collider_center(polygon));
+            break;
+        default:
+            throw(InvalidColliderType, "Invalid collider type");
+            break;
+    }
+}
+
+static int gjk_shape_support(GjkShape* shape, Vector direction) {
+    int best = 0;
+    float best_distance = vector_dot(shape->points[0], direction);
+
+    for (int i = 1; i < shape->points_count; i++) {
+        float distance = vector_dot(shape->points[i], direction);
+        if (distance > best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+
+    return best;
+}
+
+static inline Vector gjk_shape_point(GjkShape* shape, int index) {
+    return vector_add(shape->points[index], shape->position);
+}
+
+static void gjk_vertex_set(GjkVertex* vertex, GjkShape* first, int first_index, GjkShape* second, int second_index) {
+    vertex->first = gjk_shape_point(first, first_index);
+    vertex->second = gjk_shape_point(second, second_index);
+    vertex->point = vector_subtract(vertex->second, vertex->first);
+    vertex->weight = 1;
+    vertex->first_index = first_index;
+    vertex->second_index = second_index;
+}
+
+static inline GjkCacheEntry* gjk_cache_entry(Collider* first, Collider* second) {
+    uintptr_t hash = ((uintptr_t)first >> 4) * 31 + ((uintptr_t)second >> 4);
+    return gjk_cache + (hash & (GJK_CACHE_SIZE - 1));
+}
+
+static void gjk_simplex_read_cache(GjkSimplex* simplex, GjkCacheEntry* entry, Collider* first_collider, Collider* second_collider, GjkShape* first, GjkShape* second) {
+    simplex->count = 0;
+
+    if (entry->first == first_collider && entry->second == second_collider) {
+        for (int i = 0; i < entry->count; i++) {
+            if (entry->first_indices[i] >= first->points_count || entry->second_indices[i] >= second->points_count) {
+                simplex->count = 0;
+                break;
+            }
+
+            gjk_vertex_set(simplex->vertices + simplex->count++, first, entry->first_indices[i], second, entry->second_indices[i]);
+        }
+
+        // The triangle can flatten out if the colliders rotated since the last test.
+        if (simplex->count == 3) {
+            Vector a = simplex->vertices[0].point;
+            Vector b = simplex->vertices[1].point;
+            Vector c = simplex->vertices[2].point;
+
+            if (SDL_fabsf(vector_cross(vector_subtract(b, a), vector_subtract(c, a))) <= GJK_EPSILON) {
+                simplex->count = 1;
+            }
+        }
+    }
+
+    if (simplex->count == 0) {
+        gjk_vertex_set(simplex->vertices, first, 0, second, 0);
+        simplex->count = 1;
+    }
+}
+
+static void gjk_simplex_write_cache(GjkSimplex* simplex, GjkCacheEntry* entry, Collider* first_collider, Collider* second_collider) {
+    entry->first = first_collider;
+    entry->second = second_collider;
+    entry->count = simplex->count;
+
+    for (int i = 0; i < simplex->count; i++) {
+        entry->first_indices[i] = simplex->vertices[i].first_index;
+        entry->second_indices[i] = simplex->vertices[i].second_index;
+    }
+}
+
+// Reduces a segment to the closest feature to the origin and finds the
+// barycentric weights of the closest point.
+static void gjk_simplex_solve2(GjkSimplex* simplex) {
+    Vector w1 = simplex->vertices[0].point;
+    Vector w2 = simplex->vertices[1].point;
+    Vector e12 = vector_subtract(w2, w1);
+
+    float d12_2 = -vector_dot(w1, e12);
+    if (d12_2 <= 0) {
+        simplex->vertices[0].weight = 1;
+        simplex->count = 1;
+        return;
+    }
+
+    float d12_1 = vector_dot(w2, e12);
+    if (d12_1 <= 0) {
+        simplex->vertices[0] = simplex->vertices[1];
+        simplex->vertices[0].weight = 1;
+        simplex->count = 1;
+        return;
+    }
+
+    float inverse = 1 / (d12_1 + d12_2);
+    simplex->vertices[0].weight = d12_1 * inverse;
+    simplex->vertices[1].weight = d12_2 * inverse;
+    simplex->count = 2;
+}
+
+// Reduces a triangle to the closest feature to the origin using the voronoi
+// regions of its points and edges.
+static void gjk_simplex_solve3(GjkSimplex* simplex) {
+    Vector w1 = simplex->vertices[0].point;
+    Vector w2 = simplex->vertices[1].point;
+    Vector w3 = simplex->vertices[2].point;
+
+    Vector e12 = vector_subtract(w2, w1);
+    float d12_1 = vector_dot(w2, e12);
+    float d12_2 = -vector_dot(w1, e12);
+
+    Vector e13 = vector_subtract(w3, w1);
+    float d13_1 = vector_dot(w3, e13);
+    float d13_2 = -vector_dot(w1, e13);
+
+    Vector e23 = vector_subtract(w3, w2);
+    float d23_1 = vector_dot(w3, e23);
+    float d23_2 = -vector_dot(w2, e23);
+
+    float n123 = vector_cross(e12, e13);
+    float d123_1 = n123 * vector_cross(w2, w3);
+    float d123_2 = n123 * vector_cross(w3, w1);
+    float d123_3 = n123 * vector_cross(w1, w2);
+
+    if (d12_2 <= 0 && d13_2 <= 0) {
+        simplex->vertices[0].weight = 1;
+        simplex->count = 1;
+        return;
+    }
+
+    if (d12_1 > 0 && d12_2 > 0 && d123_3 <= 0) {
+        float inverse = 1 / (d12_1 + d12_2);
+        simplex->vertices[0].weight = d12_1 * inverse;
+        simplex->vertices[1].weight = d12_2 * inverse;
+        simplex->count = 2;
+        return;
+    }
+
+    if (d13_1 > 0 && d13_2 > 0 && d123_2 <= 0) {
+        float inverse = 1 / (d13_1 + d13_2);
+        simplex->vertices[0].weight = d13_1 * inverse;
+        simplex->vertices[2].weight = d13_2 * inverse;
+        simplex->vertices[1] = simplex->vertices[2];
+        simplex->count = 2;
+        return;
+    }
+
+    if (d12_1 <= 0 && d23_2 <= 0) {
+        simplex->vertices[0] = simplex->vertices[1];
+        simplex->vertices[0].weight = 1;
+        simplex->count = 1;
+        return;
+    }
+
+    if (d13_1 <= 0 && d23_1 <= 0) {
+        simplex->vertices[0] = simplex->vertices[2];
+        simplex->vertices[0].weight = 1;
+        simplex->count = 1;
+        return;
+    }
+
+    if (d23_1 > 0 && d23_2 > 0 && d123_1 <= 0) {
+        float inverse = 1 / (d23_1 + d23_2);
+        simplex->vertices[1].weight = d23_1 * inverse;
+        simplex->vertices[2].weight = d23_2 * inverse;
+        simplex->vertices[0] = simplex->vertices[2];
+        simplex->count = 2;
+        return;
+    }
+
+    // The origin is inside of the triangle.
+    float inverse = 1 / (d123_1 + d123_2 + d123_3);
+    simplex->vertices[0].weight = d123_1 * inverse;
+    simplex->vertices[1].weight = d123_2 * inverse;
+    simplex->vertices[2].weight = d123_3 * inverse;
+    simplex->count = 3;
+}
+
+static void gjk_simplex_solve(GjkSimplex* simplex) {
+    switch (simplex->count) {
+        case 2:
+            gjk_simplex_solve2(simplex);
+            break;
+        case 3:
+            gjk_simplex_solve3(simplex);
+            break;
+    }
+}
+
+static Vector gjk_simplex_search_direction(GjkSimplex* simplex) {
+    if (simplex->count == 1) {
+        return vector_negate(simplex->vertices[0].point);
+    }
+
+    // Search away from the segment on the side of the origin.
+    Vector edge = vector_subtract(simplex->vertices[1].point, simplex->vertices[0].point);
+    if (vector_cross(edge, vector_negate(simplex->vertices[0].point)) > 0) {
+        return vector_create(-edge.y, edge.x);
+    }
+
+    return vector_create(edge.y, -edge.x);
+}
+
+static void gjk_simplex_witness_points(GjkSimplex* simplex, Vector* out_first, Vector* out_second) {
+    Vector first = VECTOR_ZERO;
+    Vector second = VECTOR_ZERO;
+
+    for (int i = 0; i < simplex->count; i++) {
+        GjkVertex* vertex = simplex->vertices + i;
+        first = vector_add(first, vector_multiply_scalar(vertex->first, vertex->weight));
+        second = vector_add(second, vector_multiply_scalar(vertex->second, vertex->weight));
+    }
+
+    // The origin is inside of the triangle, so the closest points are the same.
+    if (simplex->count == 3) {
+        second = first;
+    }
+
+    *out_first = first;
+    *out_second = second;
+}
+
+// Finds the closest points between the shapes, ignoring their radii, starting from the
+// pair's cached simplex. Returns the distance between the points, which is 0 if the
+// shapes overlap.
+static float gjk_run(Collider* first_collider, Collider* second_collider, GjkShape* first, GjkShape* second, GjkSimplex* simplex, Vector* out_first_point, Vector* out_second_point) {
+    GjkCacheEntry* entry = gjk_cache_entry(first_collider, second_collider);
+    gjk_simplex_read_cache(simplex, entry, first_collider, second_collider, first, second);
+
+    int saved_first[3];
+    int saved_second[3];
+
+    for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++) {
+        int saved_count = simplex->count;
+        for (int i = 0; i < saved_count; i++) {
+            saved_first[i] = simplex->vertices[i].first_index;
+            saved_second[i] = simplex->vertices[i].second_index;
+        }
+
+        gjk_simplex_solve(simplex);
+
+        if (simplex->count == 3) {
+            break;
+        }
+
+        // The origin is on the simplex, so the shapes are touching.
+        Vector direction = gjk_simplex_search_direction(simplex);
+        if (vector_length_squared(direction) < GJK_EPSILON * GJK_EPSILON) {
+            break;
+        }
+
+        int first_index = gjk_shape_support(first, vector_negate(direction));
+        int second_index = gjk_shape_support(second, direction);
+
+        // If the support point is already in the simplex, it can't get any closer.
+        bool duplicate = false;
+        for (int i = 0; i < saved_count; i++) {
+            if (saved_first[i] == first_index && saved_second[i] == second_index) {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (duplicate) {
+            break;
+        }
+
+        gjk_vertex_set(simplex->vertices + simplex->count, first, first_index, second, second_index);
+        simplex->count++;
+    }
+
+    // Makes sure the weights are valid if the iterations ran out after adding a point.
+    gjk_simplex_solve(simplex);
+    gjk_simplex_write_cache(simplex, entry, first_collider, second_collider);
+
+    gjk_simplex_witness_points(simplex, out_first_point, out_second_point);
+    return simplex->count == 3 ? 0 : vector_distance(*out_first_point, *out_second_point);
+}
+
+static void epa_support(GjkShape* first, GjkShape* second, Vector direction, Vector* out_point, Vector* out_second) {
+    Vector second_point = gjk_shape_point(second, gjk_shape_support(second, direction));
+    Vector first_point = gjk_shape_point(first, gjk_shape_support(first, vector_negate(direction)));
+
+    *out_point = vector_subtract(second_point, first_point);
+    *out_second = second_point;
+}
+
+// Expands the final GJK simplex into a polygon around the origin, then keeps pushing out
+// the edge closest to the origin until it's on the boundary of the Minkowski difference.
+// Returns the penetration depth of the shapes, ignoring their radii. Moving the first
+// shape along the normal by the depth separates the shapes.
+static float epa_run(GjkShape* first, GjkShape* second, GjkSimplex* simplex, Vector* out_normal, Vector* out_second_point) {
+    Vector points[EPA_MAX_POINTS];
+    Vector seconds[EPA_MAX_POINTS];
+    int count = simplex->count;
+
+    for (int i = 0; i < count; i++) {
+        points[i] = simplex->vertices[i].point;
+        seconds[i] = simplex->vertices[i].second;
+    }
+
+    // GJK stops as soon as the origin touches the simplex, which can be before it has three points.
+    if (count == 1) {
+        static const Vector directions[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        for (int i = 0; i < 4 && count == 1; i++) {
+            epa_support(first, second, directions[i], points + 1, seconds + 1);
+            if (vector_distance_squared(points[0], points[1]) > GJK_EPSILON * GJK_EPSILON) {
+                count = 2;
+            }
+        }
+    }
+
+    if (count == 2) {
+        Vector edge = vector_subtract(points[1], points[0]);
+        Vector normal = vector_create(-edge.y, edge.x);
+
+        for (int i = 0; i < 2 && count == 2; i++) {
+            epa_support(first, second, i == 0 ? normal : vector_negate(normal), points + 2, seconds + 2);
+            if (SDL_fabsf(vector_cross(edge, vector_subtract(points[2], points[0]))) > GJK_EPSILON) {
+                count = 3;
+            }
+        }
+    }
+
+    // The shapes only touch, so there's nothing to push out of.
+    if (count < 3) {
+        *out_normal = count == 2
+            ? vector_normalize(vector_create(points[0].y - points[1].y, points[1].x - points[0].x))
+            : VECTOR_ZERO;
+        *out_second_point = seconds[0];
+        return 0;
+    }
+
+    // Keep the polygon wound counter clockwise so every edge normal faces outwards.
+    if (vector_cross(vector_subtract(points[1], points[0]), vector_subtract(points[2], points[0])) < 0) {
+        Vector temp = points[1];
+        points[1] = points[2];
+        points[2] = temp;
+
+        temp = seconds[1];
+        seconds[1] = seconds[2];
+        seconds[2] = temp;
+    }
+
+    for (;;) {
+        int closest = 0;
+        float closest_distance = FLT_MAX;
+        Vector closest_normal = VECTOR_ZERO;
+
+        for (int i = 0; i < count; i++) {
+            int j = (i + 1) % count;
+            Vector edge = vector_subtract(points[j], points[i]);
+            Vector normal = vector_normalize(vector_create(edge.y, -edge.x));
+            float distance = vector_dot(normal, points[i]);
+
+            if (distance < closest_distance) {
+                closest = i;
+                closest_distance = distance;
+                closest_normal = normal;
+            }
+        }
+
+        Vector support;
+        Vector support_second;
+        epa_support(first, second, closest_normal, &support, &support_second);
+
+        if (vector_dot(support, closest_normal) - closest_distance <= EPA_TOLERANCE || count == EPA_MAX_POINTS) {
+            // Find where the origin projects onto the closest edge to get the matching point on the second shape.
+            int next = (closest + 1) % count;
+            Vector edge = vector_subtract(points[next], points[closest]);
+            Vector projection = vector_multiply_scalar(closest_normal, closest_distance);
+            float fraction = SDL_clamp(vector_dot(vector_subtract(projection, points[closest]), edge) / vector_length_squared(edge), 0, 1);
+
+            *out_normal = closest_normal;
+            *out_second_point = vector_add(seconds[closest], vector_multiply_scalar(vector_subtract(seconds[next], seconds[closest]), fraction));
+            return closest_distance;
+        }
+
+        for (int i = count; i > closest + 1; i--) {
+            points[i] = points[i - 1];
+            seconds[i] = seconds[i - 1];
+        }
+
+        points[closest + 1] = support;
+        seconds[closest + 1] = support_second;
+        count++;
+    }
+}
+
+// EPA can't find a normal when the cores of the shapes sit on top of each other, such as
+// two circles with the same center. Push the first collider away from the center of the
+// second instead, or straight up when those match too, the same as the SAT tests.
+static Vector gjk_fallback_normal(Collider* first, Collider* second) {
+    Vector offset = vector_subtract(rectf_center(collider_bounds(first)), rectf_center(collider_bounds(second)));
+    float length_squared = vector_length_squared(offset);
+
+    return length_squared > GJK_EPSILON
+        ? vector_divide_scalar(offset, SDL_sqrtf(length_squared))
+        : vector_create(0, -1);
+}
+
+SOREN_EXPORT bool collision_gjk(Collider* first, Collider* second) {
+    GjkShape first_shape;
+    GjkShape second_shape;
+    gjk_shape_init(&first_shape, first);
+    gjk_shape_init(&second_shape, second);
+
+    GjkSimplex simplex;
+    Vector first_point;
+    Vector second_point;
+    float distance = gjk_run(first, second, &first_shape, &second_shape, &simplex, &first_point, &second_point);
+
+    return distance <= GJK_EPSILON || distance < first_shape.radius + second_shape.radius;
+}
+
+SOREN_EXPORT bool collision_gjk_ext(Collider* first, Collider* second, CollisionResult* out_result) {
+    CollisionResult result = (CollisionResult){0};
+    bool collides = false;
+
+    GjkShape first_shape;
+    GjkShape second_shape;
+    gjk_shape_init(&first_shape, first);
+    gjk_shape_init(&second_shape, second);
+
+    GjkSimplex simplex;
+    Vector first_point;
+    Vector second_point;
+    float distance = gjk_run(first, second, &first_shape, &second_shape, &simplex, &first_point, &second_point);
+    float radius = first_shape.radius + second_shape.radius;
+
+    if (distance <= GJK_EPSILON) {
+        Vector normal;
+        float depth = epa_run(&first_shape, &second_shape, &simplex, &normal, &second_point) + radius;
+
+        // Also catches the NaN from normalizing a degenerate edge.
+        if (!(vector_length_squared(normal) > GJK_EPSILON)) {
+            normal = gjk_fallback_normal(first, second);
+        }
+
+        if (depth > 0) {
+            collides = true;
+            result.normal = normal;
+            result.minimum_translation_vector = vector_multiply_scalar(normal, -depth);
+            result.point = vector_add(second_point, vector_multiply_scalar(normal, second_shape.radius));
+        }
+    } else if (distance < radius) {
+        // Only the radii overlap, so the closest points give the normal directly.
+        collides = true;
+        result.normal = vector_divide_scalar(vector_subtract(first_point, second_point), distance);
+        result.minimum_translation_vector = vector_multiply_scalar(result.normal, distance - radius);
+        result.point = vector_add(second_point, vector_multiply_scalar(result.normal, second_shape.radius));
+    }
+
+    if (out_result) {
+        *out_result = result;
+    }
+
+    return collides;
+}
+
+SOREN_EXPORT float collision_gjk_distance(Collider* first, Collider* second, Vector* out_first_point, Vector* out_second_point) {
+    GjkShape first_shape;
+    GjkShape second_shape;
+    gjk_shape_init(&first_shape, first);
+    gjk_shape_init(&second_shape, second);
+
+    GjkSimplex simplex;
+    Vector first_point;
+    Vector second_point;
+    float distance = gjk_run(first, second, &first_shape, &second_shape, &simplex, &first_point, &second_point);
+
+    // Move the closest points from the cores out to the surfaces of the shapes.
+    if (distance > GJK_EPSILON) {
+        Vector normal = vector_divide_scalar(vector_subtract(second_point, first_point), distance);
+        first_point = vector_add(first_point, vector_multiply_scalar(normal, first_shape.radius));
+        second_point = vector_subtract(second_point, vector_multiply_scalar(normal, second_shape.radius));
+        distance -= first_shape.radius + second_shape.radius;
+    }
+
+    if (distance <= GJK_EPSILON) {
+        first_point = vector_multiply_scalar(vector_add(first_point, second_point), 0.5f);
+        second_point = first_point;
+        distance = 0;
+    }
+
+    if (out_first_point) {
+        *out_first_point = first_point;
+    }
+
+    if (out_second_point) {
+        *out_second_point = second_point;
+    }
+
+    return distance;
+}
@@ -0,0 +1,510 @@
+#include <collisions/soren_hierarchical_grid.h>
+
+#include "soren_collisions_shared.h"
+
+#include <generic_map.h>
+#include <generic_iterators/map_iterator.h>
+#include <generic_iterators/set_iterator.h>
+#include <generic_iterators/list_iterator.h>
+
+// The level of colliders that are too large for the top level.
+#define HIERARCHICAL_GRID_OVERSIZED -1
+
+// The maximum number of empty cells kept around to be reused instead of being freed.
+#define HIERARCHICAL_GRID_CELL_POOL_CAPACITY 64
+
+typedef struct GridLocation {
+    int level;
+    Point cell;
+} GridLocation;
+
+MAP_DEFINE_H(GridCellMap, grid_cell_map, Point, ColliderCollection*)
+MAP_DEFINE_C(GridCellMap, grid_cell_map, Point, ColliderCollection*, point_hash, point_compare)
+
+MAP_DEFINE_H(ColliderLocationMap, collider_location_map, Collider*, GridLocation)
+MAP_DEFINE_C(ColliderLocationMap, collider_location_map, Collider*, GridLocation, gds_pointer_hash, gds_pointer_compare)
+
+typedef struct GridLevel {
+    float cell_size;
+    float inverse_cell_size;
+    GridCellMap* cells;
+    // The number of colliders stored in the level.
+    int count;
+} GridLevel;
+
+struct HierarchicalGrid {
+    GridLevel* levels;
+    int levels_count;
+    ColliderCollection* oversized;
+    ColliderLocationMap* locations;
+    ColliderCollection** cell_pool;
+    int cell_pool_count;
+    ColliderCollection* cache;
+};
+
+typedef struct GridQuery GridQuery;
+
+typedef bool (*GridFilter)(Collider* collider, GridQuery* query);
+
+struct GridQuery {
+    ColliderVisitor visitor;
+    void* ctx;
+    GridFilter filter;
+    // Only colliders whose bounds overlap the rect are passed to the filter.
+    RectF rect;
+    Collider* collider;
+    Vector position;
+    // The level that's currently being visited.
+    int level;
+};
+
+typedef struct GridPairs {
+    GridQuery query;
+    ColliderPairList* pairs;
+    Collider* collider;
+    int level;
+    bool narrowphase;
+} GridPairs;
+
+static ColliderCollection* hierarchical_grid_cell_create(HierarchicalGrid* grid) {
+    if (grid->cell_pool_count > 0) {
+        return grid->cell_pool[--grid->cell_pool_count];
+    }
+
+    return collider_collection_create();
+}
+
+static void hierarchical_grid_cell_recycle(HierarchicalGrid* grid, ColliderCollection* set) {
+    if (grid->cell_pool_count < HIERARCHICAL_GRID_CELL_POOL_CAPACITY) {
+        collider_collection_clear(set);
+        grid->cell_pool[grid->cell_pool_count++] = set;
+    } else {
+        collider_collection_free(set);
+    }
+}
+
+static GridLocation hierarchical_grid_locate(HierarchicalGrid* grid, RectF bounds) {
+    float size = SDL_max(bounds.w, bounds.h);
+    float center_x = bounds.x + bounds.w / 2;
+    float center_y = bounds.y + bounds.h / 2;
+
+    for (int i = 0; i < grid->levels_count; i++) {
+        GridLevel* level = grid->levels + i;
+        if (size <= level->cell_size) {
+            return (GridLocation){
+                i,
+                { fast_floor(center_x * level->inverse_cell_size), fast_floor(center_y * level->inverse_cell_size) }
+            };
+        }
+    }
+
+    return (GridLocation){ HIERARCHICAL_GRID_OVERSIZED, { 0, 0 } };
+}
+
+static void hierarchical_grid_insert(HierarchicalGrid* grid, Collider* collider, GridLocation location) {
+    if (location.level == HIERARCHICAL_GRID_OVERSIZED) {
+        collider_collection_add(grid->oversized, collider);
+        return;
+    }
+
+    GridLevel* level = grid->levels + location.level;
+    ColliderCollection* set;
+
+    if (!grid_cell_map_try_get(level->cells, location.cell, &set)) {
+        set = hierarchical_grid_cell_create(grid);
+        grid_cell_map_add(level->cells, location.cell, set);
+    }
+
+    collider_collection_add(set, collider);
+    level->count++;
+}
+
+static void hierarchical_grid_erase(HierarchicalGrid* grid, Collider* collider, GridLocation location) {
+    if (location.level == HIERARCHICAL_GRID_OVERSIZED) {
+        collider_collection_remove(grid->oversized, collider);
+        return;
+    }
+
+    GridLevel* level = grid->levels + location.level;
+    ColliderCollection* set;
+
+    if (!grid_cell_map_try_get(level->cells, location.cell, &set) || !collider_collection_remove(set, collider)) {
+        return;
+    }
+
+    level->count--;
+
+    if (collider_collection_count(set) == 0) {
+        grid_cell_map_remove(level->cells, location.cell);
+        hierarchical_grid_cell_recycle(grid, set);
+    }
+}
+
+SOREN_EXPORT HierarchicalGrid* hierarchical_grid_create(float cell_size, int levels_count) {
+    soren_assert(cell_size > 0);
+    soren_assert(levels_count > 0);
+
+    HierarchicalGrid* grid = soren_malloc(sizeof(*grid));
+    grid->levels = soren_malloc(levels_count * sizeof(*grid->levels));
+    grid->levels_count = levels_count;
+    grid->oversized = collider_collection_create();
+    grid->locations = collider_location_map_create();
+    grid->cell_pool = soren_malloc(HIERARCHICAL_GRID_CELL_POOL_CAPACITY * sizeof(*grid->cell_pool));
+    grid->cell_pool_count = 0;
+    grid->cache = collider_collection_create();
+
+    for (int i = 0; i < levels_count; i++) {
+        GridLevel* level = grid->levels + i;
+        level->cell_size = cell_size;
+        level->inverse_cell_size = 1.f / cell_size;
+        level->cells = grid_cell_map_create();
+        level->count = 0;
+
+        cell_size *= 2;
+    }
+
+    return grid;
+}
+
+SOREN_EXPORT void hierarchical_grid_free(HierarchicalGrid* grid) {
+    ColliderCollection* set;
+
+    for (int i = 0; i < grid->levels_count; i++) {
+        map_iter_value_start(grid->levels[i].cells, set) {
+            collider_collection_free(set);
+        }
+        map_iter_end
+
+        grid_cell_map_free(grid->levels[i].cells);
+    }
+
+    for (int i = 0; i < grid->cell_pool_count; i++) {
+        collider_collection_free(grid->cell_pool[i]);
+    }
+
+    soren_free(grid->levels);
+    soren_free(grid->cell_pool);
+    collider_collection_free(grid->oversized);
+    collider_location_map_free(grid->locations);
+    collider_collection_free(grid->cache);
+    soren_free(grid);
+}
+
+SOREN_EXPORT void hierarchical_grid_add(HierarchicalGrid* grid, Collider* collider) {
+    GridLocation location;
+    if (collider_location_map_try_get(grid->locations, collider, &location)) {
+        return;
+    }
+
+    location = hierarchical_grid_locate(grid, collider_bounds(collider));
+    hierarchical_grid_insert(grid, collider, location);
+    collider_location_map_set(grid->locations, collider, location);
+}
+
+SOREN_EXPORT void hierarchical_grid_remove(HierarchicalGrid* grid, Collider* collider) {
+    GridLocation location;
+    if (!collider_location_map_try_get(grid->locations, collider, &location)) {
+        return;
+    }
+
+    hierarchical_grid_erase(grid, collider, location);
+    collider_location_map_remove(grid->locations, collider);
+}
+
+SOREN_EXPORT void hierarchical_grid_clear(HierarchicalGrid* grid) {
+    ColliderCollection* set;
+
+    for (int i = 0; i < grid->levels_count; i++) {
+        GridLevel* level = grid->levels + i;
+
+        map_iter_value_start(level->cells, set) {
+            hierarchical_grid_cell_recycle(grid, set);
+        }
+        map_iter_end
+
+        grid_cell_map_clear(level->cells, true);
+        level->count = 0;
+    }
+
+    collider_collection_clear(grid->oversized);
+    collider_location_map_clear(grid->locations, true);
+}
+
+SOREN_EXPORT int hierarchical_grid_count(HierarchicalGrid* grid) {
+    return collider_location_map_count(grid->locations);
+}
+
+SOREN_EXPORT int hierarchical_grid_levels_count(HierarchicalGrid* grid) {
+    return grid->levels_count;
+}
+
+SOREN_EXPORT int hierarchical_grid_collider_level(HierarchicalGrid* grid, Collider* collider) {
+    GridLocation location;
+    if (!collider_location_map_try_get(grid->locations, collider, &location)) {
+        throw(IllegalArgumentException, "Collider is not in the grid");
+    }
+
+    return location.level;
+}
+
+SOREN_EXPORT void hierarchical_grid_update(HierarchicalGrid* grid, Collider* collider) {
+    GridLocation old_location;
+    if (!collider_location_map_try_get(grid->locations, collider, &old_location)) {
+        return;
+    }
+
+    GridLocation location = hierarchical_grid_locate(grid, collider_bounds(collider));
+    if (location.level == old_location.level && location.cell.x == old_location.cell.x && location.cell.y == old_location.cell.y) {
+        return;
+    }
+
+    hierarchical_grid_erase(grid, collider, old_location);
+    hierarchical_grid_insert(grid, collider, location);
+    collider_location_map_set(grid->locations, collider, location);
+}
+
+SOREN_EXPORT void hierarchical_grid_move(HierarchicalGrid* grid, Collider* collider, Vector delta) {
+    collider_set_position(collider, vector_add(delta, collider_position(collider)));
+    hierarchical_grid_update(grid, collider);
+}
+
+SOREN_EXPORT void hierarchical_grid_set_position(HierarchicalGrid* grid, Collider* collider, Vector position) {
+    collider_set_position(collider, position);
+    hierarchical_grid_update(grid, collider);
+}
+
+static inline bool hierarchical_grid_visit(Collider* collider, GridQuery* query) {
+    return !rectf_intersects(collider_bounds(collider), query->rect)
+        || (query->filter && !query->filter(collider, query))
+        || query->visitor(collider, query->ctx);
+}
+
+static bool hierarchical_grid_visit_cell(ColliderCollection* set, GridQuery* query) {
+    Collider* collider;
+
+    if (set->using_set) {
+        set_iter_start(set->set, collider) {
+            if (!hierarchical_grid_visit(collider, query)) {
+                return false;
+            }
+        }
+        set_iter_end
+    } else {
+        list_iter_start(set->list, collider) {
+            if (!hierarchical_grid_visit(collider, query)) {
+                return false;
+            }
+        }
+        list_iter_end
+    }
+
+    return true;
+}
+
+// Visits every collider that overlaps the query rect on the levels from first_level up,
+// followed by the oversized colliders. Returns false if the visitor stopped the query early.
+static bool hierarchical_grid_for_each_impl(HierarchicalGrid* grid, GridQuery* query, int first_level) {
+    RectF rect = query->rect;
+    ColliderCollection* set;
+    Point p;
+
+    for (int i = first_level; i < grid->levels_count; i++) {
+        GridLevel* level = grid->levels + i;
+        if (level->count == 0) {
+            continue;
+        }
+
+        query->level = i;
+
+        // A collider is stored in the cell that holds its center, and is never larger
+        // than a cell, so it can stick out of its cell by up to half a cell on each side.
+        int minx = fast_floor(rectf_left(rect) * level->inverse_cell_size - 0.5f);
+        int miny = fast_floor(rectf_top(rect) * level->inverse_cell_size - 0.5f);
+        int maxx = fast_floor(rectf_right(rect) * level->inverse_cell_size + 0.5f);
+        int maxy = fast_floor(rectf_bottom(rect) * level->inverse_cell_size + 0.5f);
+
+        // Large queries on the lower levels can cover far more cells than are occupied.
+        // Walk the occupied cells instead in that case.
+        int64_t range_count = (int64_t)(maxx - minx + 1) * (maxy - miny + 1);
+
+        if (range_count > grid_cell_map_count(level->cells)) {
+            map_iter_start(level->cells, p, set) {
+                if (p.x >= minx && p.x <= maxx && p.y >= miny && p.y <= maxy && !hierarchical_grid_visit_cell(set, query)) {
+                    return false;
+                }
+            }
+            map_iter_end
+        } else {
+            for (p.x = minx; p.x <= maxx; p.x++) {
+                for (p.y = miny; p.y <= maxy; p.y++) {
+                    if (grid_cell_map_try_get(level->cells, p, &set) && !hierarchical_grid_visit_cell(set, query)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    query->level = HIERARCHICAL_GRID_OVERSIZED;
+    return hierarchical_grid_visit_cell(grid->oversized, query);
+}
+
+static bool hierarchical_grid_filter_vector(Collider* collider, GridQuery* query) {
+    return collider_overlaps(collider, query->position);
+}
+
+static bool hierarchical_grid_filter_rectf(Collider* collider, GridQuery* query) {
+    return collider_overlaps(collider, query->rect);
+}
+
+static bool hierarchical_grid_filter_collider(Collider* collider, GridQuery* query) {
+    return collider != query->collider
+        && collider_should_collide(query->collider, collider)
+        && collider_overlaps(query->collider, collider);
+}
+
+SOREN_EXPORT bool hierarchical_grid_for_each_broadphase_rectf(HierarchicalGrid* grid, RectF rect, void* ctx, ColliderVisitor visitor) {
+    GridQuery query = { .visitor = visitor, .ctx = ctx, .rect = rect };
+    return hierarchical_grid_for_each_impl(grid, &query, 0);
+}
+
+SOREN_EXPORT bool hierarchical_grid_for_each_vector(HierarchicalGrid* grid, Vector position, void* ctx, ColliderVisitor visitor) {
+    GridQuery query = {
+        .visitor = visitor,
+        .ctx = ctx,
+        .filter = hierarchical_grid_filter_vector,
+        .rect = (RectF){ position.x, position.y, 0, 0 },
+        .position = position
+    };
+
+    return hierarchical_grid_for_each_impl(grid, &query, 0);
+}
+
+SOREN_EXPORT bool hierarchical_grid_for_each_rectf(HierarchicalGrid* grid, RectF bounds, void* ctx, ColliderVisitor visitor) {
+    GridQuery query = { .visitor = visitor, .ctx = ctx, .filter = hierarchical_grid_filter_rectf, .rect = bounds };
+    return hierarchical_grid_for_each_impl(grid, &query, 0);
+}
+
+SOREN_EXPORT bool hierarchical_grid_for_each_collider(HierarchicalGrid* grid, Collider* collider, void* ctx, ColliderVisitor visitor) {
+    GridQuery query = {
+        .visitor = visitor,
+        .ctx = ctx,
+        .filter = hierarchical_grid_filter_collider,
+        .rect = collider_bounds(collider),
+        .collider = collider
+    };
+
+    return hierarchical_grid_for_each_impl(grid, &query, 0);
+}
+
+static inline ColliderCollection* hierarchical_grid_results(HierarchicalGrid* grid, ColliderCollection* results) {
+    if (!results) {
+        collider_collection_clear(grid->cache);
+        results = grid->cache;
+    }
+
+    return results;
+}
+
+static bool hierarchical_grid_collect(Collider* collider, void* ctx) {
+    collider_collection_add(ctx, collider);
+    return true;
+}
+
+typedef struct GridCollectCollider {
+    ColliderCollection* results;
+    Collider* collider;
+} GridCollectCollider;
+
+static bool hierarchical_grid_collect_broadphase_collider(Collider* other, void* ctx) {
+    GridCollectCollider* collect = ctx;
+    if (other == collect->collider || collider_should_collide(collect->collider, other)) {
+        collider_collection_add(collect->results, other);
+    }
+
+    return true;
+}
+
+SOREN_EXPORT ColliderCollection* hierarchical_grid_broadphase_rectf(HierarchicalGrid* grid, RectF rect, ColliderCollection* results) {
+    results = hierarchical_grid_results(grid, results);
+    hierarchical_grid_for_each_broadphase_rectf(grid, rect, results, hierarchical_grid_collect);
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* hierarchical_grid_broadphase_collider(HierarchicalGrid* grid, Collider* collider, ColliderCollection* results) {
+    results = hierarchical_grid_results(grid, results);
+
+    GridCollectCollider collect = { results, collider };
+    hierarchical_grid_for_each_broadphase_rectf(grid, collider_bounds(collider), &collect, hierarchical_grid_collect_broadphase_collider);
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* hierarchical_grid_collisions_vector(HierarchicalGrid* grid, ColliderCollection* results, Vector position) {
+    results = hierarchical_grid_results(grid, results);
+    hierarchical_grid_for_each_vector(grid, position, results, hierarchical_grid_collect);
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* hierarchical_grid_collisions_rectf(HierarchicalGrid* grid, ColliderCollection* results, RectF bounds) {
+    results = hierarchical_grid_results(grid, results);
+    hierarchical_grid_for_each_rectf(grid, bounds, results, hierarchical_grid_collect);
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* hierarchical_grid_collisions_collider(HierarchicalGrid* grid, ColliderCollection* results, Collider* collider) {
+    results = hierarchical_grid_results(grid, results);
+    hierarchical_grid_for_each_collider(grid, collider, results, hierarchical_grid_collect);
+    return results;
+}
+
+static bool hierarchical_grid_visit_pair(Collider* other, void* ctx) {
+    GridPairs* pairs = ctx;
+    Collider* collider = pairs->collider;
+
+    if (other == collider) {
+        return true;
+    }
+
+    // Colliders on the same level find each other, so the pair is only
+    // reported from one side. Colliders on higher levels never search
+    // the lower levels, so those pairs are only found once already.
+    if (pairs->query.level == pairs->level && (uintptr_t)other < (uintptr_t)collider) {
+        return true;
+    }
+
+    if (!collider_should_collide(collider, other)) {
+        return true;
+    }
+
+    if (pairs->narrowphase && !collider_overlaps_collider_impl(collider, other)) {
+        return true;
+    }
+
+    collider_pair_list_add(pairs->pairs, (ColliderPair){ collider, other });
+    return true;
+}
+
+SOREN_EXPORT void hierarchical_grid_find_pairs(HierarchicalGrid* grid, ColliderPairList* pairs, bool narrowphase) {
+    GridPairs query = {
+        .query = { .visitor = hierarchical_grid_visit_pair },
+        .pairs = pairs,
+        .narrowphase = narrowphase
+    };
+
+    query.query.ctx = &query;
+
+    Collider* collider;
+    GridLocation location;
+
+    map_iter_start(grid->locations, collider, location) {
+        query.collider = collider;
+        query.level = location.level;
+        query.query.rect = collider_bounds(collider);
+
+        // Each collider only searches its own level and the ones above it.
+        int first_level = location.level == HIERARCHICAL_GRID_OVERSIZED ? grid->levels_count : location.level;
+        hierarchical_grid_for_each_impl(grid, &query.query, first_level);
+    }
+    map_iter_end
+}
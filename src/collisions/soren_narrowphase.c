@@ -0,0 +1,234 @@
+#ifndef SOREN_MANUAL_MEMORY
+// Required for the thread registration functions in gc.h
+#define GC_THREADS
+#endif
+
+#include <collisions/soren_narrowphase.h>
+
+#include <SDL3/SDL.h>
+
+LIST_DEFINE_C(ContactList, contact_list, Contact)
+
+// Chunks smaller than this aren't worth waking a thread for.
+#define NARROWPHASE_MIN_CHUNK_SIZE 64
+
+typedef struct NarrowphaseWorker {
+    NarrowphasePool* pool;
+    SDL_Thread* thread;
+    SDL_Semaphore* start;
+    Contact* contacts;
+    int contacts_count;
+    int contacts_capacity;
+    // The range of pairs or colliders handled by the worker.
+    int first_pair;
+    int last_pair;
+} NarrowphaseWorker;
+
+struct NarrowphasePool {
+    // The first worker is run on the calling thread and doesn't have an SDL thread.
+    NarrowphaseWorker* workers;
+    int workers_count;
+    SDL_Semaphore* done;
+    ColliderPairList* pairs;
+    // Set instead of the pairs by narrowphase_pool_clean.
+    Collider** colliders;
+    bool quit;
+};
+
+static void narrowphase_worker_process(NarrowphaseWorker* worker) {
+    if (worker->pool->colliders) {
+        collider_clean_batch(worker->pool->colliders + worker->first_pair, worker->last_pair - worker->first_pair);
+        return;
+    }
+
+    ColliderPairList* pairs = worker->pool->pairs;
+    worker->contacts_count = 0;
+
+    for (int i = worker->first_pair; i < worker->last_pair; i++) {
+        ColliderPair pair = collider_pair_list_get(pairs, i);
+        Contact* contact = worker->contacts + worker->contacts_count;
+
+        if (collider_collides_collider_impl(pair.first, pair.second, &contact->result, &contact->hit)) {
+            contact->first = pair.first;
+            contact->second = pair.second;
+            worker->contacts_count++;
+        }
+    }
+}
+
+static int narrowphase_worker_run(void* data) {
+    NarrowphaseWorker* worker = data;
+
+#ifndef SOREN_MANUAL_MEMORY
+    struct GC_stack_base stack_base;
+    GC_get_stack_base(&stack_base);
+    GC_register_my_thread(&stack_base);
+#endif
+
+    while (true) {
+        SDL_WaitSemaphore(worker->start);
+
+        if (worker->pool->quit) {
+            break;
+        }
+
+        narrowphase_worker_process(worker);
+        SDL_SignalSemaphore(worker->pool->done);
+    }
+
+#ifndef SOREN_MANUAL_MEMORY
+    GC_unregister_my_thread();
+#endif
+
+    return 0;
+}
+
+SOREN_EXPORT NarrowphasePool* narrowphase_pool_create(int thread_count) {
+#ifdef SOREN_NO_THREADS
+    // The shared collision state isn't thread local without thread support.
+    thread_count = 1;
+#else
+    if (thread_count <= 0) {
+        thread_count = SDL_max(1, SDL_GetNumLogicalCPUCores());
+    }
+#endif
+
+#ifndef SOREN_MANUAL_MEMORY
+    GC_allow_register_threads();
+#endif
+
+    NarrowphasePool* pool = soren_malloc(sizeof(*pool));
+    pool->workers = soren_calloc(thread_count, sizeof(*pool->workers));
+    pool->workers_count = thread_count;
+    pool->pairs = NULL;
+    pool->colliders = NULL;
+    pool->quit = false;
+    pool->done = SDL_CreateSemaphore(0);
+    SOREN_SDL_ASSERT(pool->done);
+
+    for (int i = 0; i < thread_count; i++) {
+        NarrowphaseWorker* worker = pool->workers + i;
+        worker->pool = pool;
+
+        if (i == 0) {
+            continue;
+        }
+
+        worker->start = SDL_CreateSemaphore(0);
+        SOREN_SDL_ASSERT(worker->start);
+
+        worker->thread = SDL_CreateThread(narrowphase_worker_run, "soren_narrowphase", worker);
+        SOREN_SDL_ASSERT(worker->thread);
+    }
+
+    return pool;
+}
+
+SOREN_EXPORT void narrowphase_pool_free(NarrowphasePool* pool) {
+    pool->quit = true;
+
+    for (int i = 1; i < pool->workers_count; i++) {
+        SDL_SignalSemaphore(pool->workers[i].start);
+    }
+
+    for (int i = 0; i < pool->workers_count; i++) {
+        NarrowphaseWorker* worker = pool->workers + i;
+
+        if (worker->thread) {
+            SDL_WaitThread(worker->thread, NULL);
+            SDL_DestroySemaphore(worker->start);
+        }
+
+        soren_free(worker->contacts);
+    }
+
+    SDL_DestroySemaphore(pool->done);
+    soren_free(pool->workers);
+    soren_free(pool);
+}
+
+SOREN_EXPORT int narrowphase_pool_thread_count(NarrowphasePool* pool) {
+    return pool->workers_count;
+}
+
+SOREN_EXPORT void narrowphase_pool_run(NarrowphasePool* pool, ColliderPairList* pairs, ContactList* contacts) {
+    int pairs_count = collider_pair_list_count(pairs);
+    if (pairs_count == 0) {
+        return;
+    }
+
+    // Polygons and lines update their points lazily, which isn't safe to do from
+    // several threads at once. Colliders that were already cleaned with
+    // narrowphase_pool_clean or collider_clean_batch are skipped quickly.
+    for (int i = 0; i < pairs_count; i++) {
+        ColliderPair pair = collider_pair_list_get(pairs, i);
+        collider_clean_impl(pair.first);
+        collider_clean_impl(pair.second);
+    }
+
+    int workers_count = SDL_min(pool->workers_count, (pairs_count + NARROWPHASE_MIN_CHUNK_SIZE - 1) / NARROWPHASE_MIN_CHUNK_SIZE);
+    int chunk_size = (pairs_count + workers_count - 1) / workers_count;
+
+    pool->pairs = pairs;
+
+    // All of the allocations happen up front so the workers never allocate.
+    for (int i = 0; i < workers_count; i++) {
+        NarrowphaseWorker* worker = pool->workers + i;
+        worker->first_pair = i * chunk_size;
+        worker->last_pair = SDL_min(pairs_count, worker->first_pair + chunk_size);
+
+        int capacity = worker->last_pair - worker->first_pair;
+        if (capacity > worker->contacts_capacity) {
+            worker->contacts = soren_realloc(worker->contacts, capacity * sizeof(*worker->contacts));
+            worker->contacts_capacity = capacity;
+        }
+    }
+
+    for (int i = 1; i < workers_count; i++) {
+        SDL_SignalSemaphore(pool->workers[i].start);
+    }
+
+    narrowphase_worker_process(pool->workers);
+
+    for (int i = 1; i < workers_count; i++) {
+        SDL_WaitSemaphore(pool->done);
+    }
+
+    for (int i = 0; i < workers_count; i++) {
+        NarrowphaseWorker* worker = pool->workers + i;
+        for (int j = 0; j < worker->contacts_count; j++) {
+            contact_list_add(contacts, worker->contacts[j]);
+        }
+    }
+
+    pool->pairs = NULL;
+}
+
+SOREN_EXPORT void narrowphase_pool_clean(NarrowphasePool* pool, Collider** colliders, int count) {
+    if (count == 0) {
+        return;
+    }
+
+    int workers_count = SDL_min(pool->workers_count, (count + NARROWPHASE_MIN_CHUNK_SIZE - 1) / NARROWPHASE_MIN_CHUNK_SIZE);
+    int chunk_size = (count + workers_count - 1) / workers_count;
+
+    pool->colliders = colliders;
+
+    for (int i = 0; i < workers_count; i++) {
+        NarrowphaseWorker* worker = pool->workers + i;
+        worker->first_pair = i * chunk_size;
+        worker->last_pair = SDL_min(count, worker->first_pair + chunk_size);
+    }
+
+    for (int i = 1; i < workers_count; i++) {
+        SDL_SignalSemaphore(pool->workers[i].start);
+    }
+
+    narrowphase_worker_process(pool->workers);
+
+    for (int i = 1; i < workers_count; i++) {
+        SDL_WaitSemaphore(pool->done);
+    }
+
+    pool->colliders = NULL;
+}
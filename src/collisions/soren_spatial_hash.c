@@ -1,564 +1,2743 @@
 #include <collisions/soren_spatial_hash.h>
+#include <collisions/soren_aabb_tree.h>
+#include <collisions/soren_collisions.h>
+
+#include "soren_collisions_shared.h"
 
 #include <generic_map.h>
 #include <generic_iterators/map_iterator.h>
 #include <generic_iterators/set_iterator.h>
 #include <generic_iterators/list_iterator.h>
+#include <soren_generics.h>
+
+#include <float.h>
 
 HYBRID_SET_DEFINE_C(ColliderCollection, collider_collection, Collider*, gds_pointer_hash, gds_pointer_compare)
+LIST_DEFINE_C(ColliderPairList, collider_pair_list, ColliderPair)
 
 MAP_DEFINE_H(SpatialStore, spatial_store, Point, ColliderCollection*)
 MAP_DEFINE_C(SpatialStore, spatial_store, Point, ColliderCollection*, point_hash, point_compare)
 
+// Maps each collider to the range of cells it currently occupies, stored as
+// a half-open rect of cell coordinates.
+MAP_DEFINE_H(ColliderCellMap, collider_cell_map, Collider*, Rect)
+MAP_DEFINE_C(ColliderCellMap, collider_cell_map, Collider*, Rect, gds_pointer_hash, gds_pointer_compare)
+
+LIST_DEFINE_H(ColliderCollectionList, collider_collection_list, ColliderCollection*)
+LIST_DEFINE_C(ColliderCollectionList, collider_collection_list, ColliderCollection*)
+
+// A collider gathered from a cell by spatial_hash_find_pairs along
+// with the range of cells it occupies.
+typedef struct SpatialPairEntry {
+    Collider* collider;
+    Rect range;
+} SpatialPairEntry;
+
+// The maximum number of empty cells kept around to be reused by spatial_hash_add
+// instead of being freed when they are evicted.
+#define SPATIAL_HASH_CELL_POOL_CAPACITY 64
+
 struct SpatialHash {
     float inverse_cell_size;
+    // Only used by bounded hashes. Stores the cells inside of grid_bounds in a
+    // flat array indexed directly by cell coordinates. Cells outside of the
+    // bounds fall back to the cells map.
+    ColliderCollection** grid;
+    Rect grid_bounds;
     SpatialStore* cells;
+    ColliderCellMap* collider_cells;
+    ColliderCollectionList* cell_pool;
+    PointList* empty_cells;
+    ColliderCollection* cache;
+    // The epoch of the query that's currently running. Every hash reserves its own block
+    // of epochs, so queries on different hashes never share the same epoch.
+    uint64_t query_epoch;
+    bool query_running;
+    SpatialPairEntry* pair_scratch;
+    int pair_scratch_capacity;
+    float* nearest_scratch;
+    int nearest_scratch_capacity;
+    // The smallest and largest cell that have held a collider since the hash was last
+    // cleared. Only ever grows until then, so it's an upper bound that limits how far
+    // the nearest neighbour search needs to look. Empty when min is greater than max.
+    Point occupied_min;
+    Point occupied_max;
+    // The static tier. Every static collider and the cells it covers are stored in
+    // static_colliders and static_ranges. When baked, every occupied cell is stored in
+    // static_cells sorted by row then column, and the colliders in static_cells[i] are
+    // static_colliders[static_entries[static_offsets[i]..static_offsets[i + 1]]].
+    Collider** static_colliders;
+    Rect* static_ranges;
+    int static_count;
+    int static_capacity;
+    Point* static_cells;
+    int* static_offsets;
+    int* static_entries;
+    int static_cells_count;
+    bool static_dirty;
+    // Set for hashes loaded with spatial_hash_load_static. The blob holds the static
+    // colliders, and the static arrays above point into it while static_borrowed is set.
+    uint8_t* static_blob;
+    bool static_borrowed;
+    // Only used by hashes created with spatial_hash_create_dynamic_tree.
+    // When set, every operation is forwarded to the tree and the cell
+    // storage above is left unallocated.
+    AabbTree* tree;
+};
+
+typedef struct SpatialHashVisit SpatialHashVisit;
+
+// Narrows the candidates of a for_each query down to the colliders that actually match.
+typedef bool (*SpatialHashFilter)(Collider* collider, SpatialHashVisit* visit);
+
+struct SpatialHashVisit {
+    ColliderVisitor visitor;
+    void* ctx;
+    SpatialHashFilter filter;
+    Collider* collider;
+    Vector position;
+    RectF bounds;
+    // Set for queries made through a SpatialQueryContext, which can't write to the colliders.
+    bool concurrent;
+};
+
+struct SpatialQueryContext {
     ColliderCollection* cache;
-    ColliderCollection* secondary_cache;
+    float* nearest_scratch;
+    int nearest_scratch_capacity;
 };
 
-static inline int fast_floor(float x) {
-    return (int)(x + 32768) - 32768;
+// The context of the visitors used to implement the collisions functions.
+typedef struct SpatialHashCollect {
+    ColliderCollection* results;
+    Collider* collider;
+    Vector position;
+    RectF bounds;
+    void* ctx;
+    ColliderVectorTest vector_test;
+    ColliderRectFTest rectf_test;
+    ColliderColliderTest collider_test;
+} SpatialHashCollect;
+
+static inline ColliderCollection** spatial_hash_grid_slot(SpatialHash* hash, Point p) {
+    if (!hash->grid) {
+        return NULL;
+    }
+
+    int x = p.x - hash->grid_bounds.x;
+    int y = p.y - hash->grid_bounds.y;
+
+    if ((unsigned)x >= (unsigned)hash->grid_bounds.w || (unsigned)y >= (unsigned)hash->grid_bounds.h) {
+        return NULL;
+    }
+
+    return hash->grid + (y * hash->grid_bounds.w + x);
+}
+
+static inline bool spatial_hash_cell_try_get(SpatialHash* hash, Point p, ColliderCollection** out_set) {
+    ColliderCollection** slot = spatial_hash_grid_slot(hash, p);
+    if (slot) {
+        *out_set = *slot;
+        return *slot != NULL;
+    }
+
+    return spatial_store_try_get(hash->cells, p, out_set);
 }
 
-#define GET_OVERLAPPING_SET_START(rect, spatial_hash) \
+#define GET_CELL_RANGE(rect, spatial_hash) \
     int minx = fast_floor(rectf_left(rect) * spatial_hash->inverse_cell_size); \
     int miny = fast_floor(rectf_top(rect) * spatial_hash->inverse_cell_size); \
     int maxx = fast_floor(rectf_right(rect) * spatial_hash->inverse_cell_size) + 1; \
-    int maxy = fast_floor(rectf_bottom(rect) * spatial_hash->inverse_cell_size) + 1; \
+    int maxy = fast_floor(rectf_bottom(rect) * spatial_hash->inverse_cell_size) + 1;
+
+// Iterates the cells overlapping the rect that already exist.
+// Never allocates, so it's safe to use for queries over empty space.
+#define GET_EXISTING_SET_START(rect, spatial_hash) \
+    GET_CELL_RANGE(rect, spatial_hash) \
     Point p; \
     ColliderCollection* set; \
     for (int w = minx; w < maxx; w++) { \
         for (int h = miny; h < maxy; h++) { \
             p.x = w; \
             p.y = h; \
-            if(!spatial_store_try_get(spatial_hash->cells, p, &set)) { \
-                set = collider_collection_create(); \
-                spatial_store_add(spatial_hash->cells, p, set); \
+            if(!spatial_hash_cell_try_get(spatial_hash, p, &set)) { \
+                continue; \
             } \
 
-#define GET_OVERLAPPING_SET_END } }
+#define GET_EXISTING_SET_END } }
 
-static inline RectF vector_to_rectf(Vector v) {
-    return (RectF){ v.x, v.y, 0, 0 };
+static ColliderCollection* spatial_hash_cell_create(SpatialHash* hash) {
+    if (collider_collection_list_count(hash->cell_pool) > 0) {
+        return collider_collection_list_pop(hash->cell_pool);
+    }
+
+    return collider_collection_create();
 }
 
-static inline Point vector_to_cell_point(SpatialHash* hash, Vector v) {
-    return (Point){ fast_floor(v.x * hash->inverse_cell_size), fast_floor(v.y * hash->inverse_cell_size) };
+static void spatial_hash_cell_recycle(SpatialHash* hash, ColliderCollection* set) {
+    if (collider_collection_list_count(hash->cell_pool) < SPATIAL_HASH_CELL_POOL_CAPACITY) {
+        collider_collection_clear(set);
+        collider_collection_list_add(hash->cell_pool, set);
+    } else {
+        collider_collection_free(set);
+    }
 }
 
-SOREN_EXPORT SpatialHash* spatial_hash_create(float cell_size) {
-    SpatialHash* result = soren_malloc(sizeof(*result));
-    result->inverse_cell_size = 1.f / cell_size;
-    result->cells = spatial_store_create();
-    result->cache = collider_collection_create();
-    result->secondary_cache = collider_collection_create();
+static inline void spatial_hash_cell_evict(SpatialHash* hash, Point p, ColliderCollection* set) {
+    ColliderCollection** slot = spatial_hash_grid_slot(hash, p);
+    if (slot) {
+        *slot = NULL;
+    } else {
+        spatial_store_remove(hash->cells, p);
+    }
 
-    return result;
+    spatial_hash_cell_recycle(hash, set);
 }
 
-SOREN_EXPORT void spatial_hash_free(SpatialHash* hash) {
-    ColliderCollection* collection;
-    map_iter_value_start(hash->cells, collection) {
-        collider_collection_free(collection);
-    }
-    map_iter_end
+static inline Rect spatial_hash_cell_range(SpatialHash* hash, RectF bounds) {
+    GET_CELL_RANGE(bounds, hash)
 
-    collider_collection_free(hash->cache);
-    collider_collection_free(hash->secondary_cache);
-    spatial_store_free(hash->cells);
+    return (Rect){ minx, miny, maxx - minx, maxy - miny };
+}
 
-    soren_free(hash);
+static inline bool cell_range_contains(Rect range, int x, int y) {
+    return x >= range.x
+        && x < range.x + range.w
+        && y >= range.y
+        && y < range.y + range.h;
 }
 
-SOREN_EXPORT void spatial_hash_add(SpatialHash* hash, Collider* collider) {
-    RectF bounds = collider_bounds(collider);
+static void spatial_hash_cell_add(SpatialHash* hash, Point p, Collider* collider) {
+    ColliderCollection* set;
+    ColliderCollection** slot = spatial_hash_grid_slot(hash, p);
 
-    GET_OVERLAPPING_SET_START(bounds, hash) {
-        collider_collection_add(set, collider);
+    if (slot) {
+        if (!*slot) {
+            *slot = spatial_hash_cell_create(hash);
+        }
+
+        set = *slot;
+    } else if (!spatial_store_try_get(hash->cells, p, &set)) {
+        set = spatial_hash_cell_create(hash);
+        spatial_store_add(hash->cells, p, set);
     }
-    GET_OVERLAPPING_SET_END
+
+    collider_collection_add(set, collider);
 }
 
-SOREN_EXPORT void spatial_hash_clear(SpatialHash* hash) {
+static void spatial_hash_cell_remove(SpatialHash* hash, Point p, Collider* collider) {
     ColliderCollection* set;
+    if (!spatial_hash_cell_try_get(hash, p, &set)) {
+        return;
+    }
 
-    map_iter_value_start(hash->cells, set) {
-        collider_collection_free(set);
+    if (collider_collection_remove(set, collider) && collider_collection_count(set) == 0) {
+        spatial_hash_cell_evict(hash, p, set);
     }
-    map_iter_end
+}
 
-    spatial_store_clear(hash->cells, true);
+static void spatial_hash_extend_occupied(SpatialHash* hash, Rect range) {
+    hash->occupied_min.x = SDL_min(hash->occupied_min.x, range.x);
+    hash->occupied_min.y = SDL_min(hash->occupied_min.y, range.y);
+    hash->occupied_max.x = SDL_max(hash->occupied_max.x, range.x + range.w - 1);
+    hash->occupied_max.y = SDL_max(hash->occupied_max.y, range.y + range.h - 1);
 }
 
-SOREN_EXPORT void spatial_hash_remove(SpatialHash* hash, Collider* collider) {
-    RectF bounds = collider_bounds(collider);
+// Forgets the dynamic colliders, so only the static colliders are counted as occupying cells.
+static void spatial_hash_reset_occupied(SpatialHash* hash) {
+    hash->occupied_min = (Point){ SDL_MAX_SINT32, SDL_MAX_SINT32 };
+    hash->occupied_max = (Point){ SDL_MIN_SINT32, SDL_MIN_SINT32 };
 
-    GET_OVERLAPPING_SET_START(bounds, hash)
+    for (int i = 0; i < hash->static_count; i++) {
+        spatial_hash_extend_occupied(hash, hash->static_ranges[i]);
+    }
+}
 
-    collider_collection_remove(set, collider);
+static void spatial_hash_add_range(SpatialHash* hash, Collider* collider, Rect range) {
+    for (int w = range.x; w < range.x + range.w; w++) {
+        for (int h = range.y; h < range.y + range.h; h++) {
+            spatial_hash_cell_add(hash, (Point){ w, h }, collider);
+        }
+    }
+}
 
-    GET_OVERLAPPING_SET_END
+static void spatial_hash_remove_range(SpatialHash* hash, Collider* collider, Rect range) {
+    for (int w = range.x; w < range.x + range.w; w++) {
+        for (int h = range.y; h < range.y + range.h; h++) {
+            spatial_hash_cell_remove(hash, (Point){ w, h }, collider);
+        }
+    }
 }
 
-SOREN_EXPORT void spatial_hash_remove_with_brute_force(SpatialHash* hash, Collider* collider) {
-    ColliderCollection* set;
+// Moves a collider from one range of cells to another, only touching
+// the cells that are entering or leaving its coverage.
+static void spatial_hash_move_range(SpatialHash* hash, Collider* collider, Rect old_range, Rect new_range) {
+    for (int w = old_range.x; w < old_range.x + old_range.w; w++) {
+        for (int h = old_range.y; h < old_range.y + old_range.h; h++) {
+            if (!cell_range_contains(new_range, w, h)) {
+                spatial_hash_cell_remove(hash, (Point){ w, h }, collider);
+            }
+        }
+    }
 
-    map_iter_value_start(hash->cells, set) {
-        collider_collection_remove(set, collider);
+    for (int w = new_range.x; w < new_range.x + new_range.w; w++) {
+        for (int h = new_range.y; h < new_range.y + new_range.h; h++) {
+            if (!cell_range_contains(old_range, w, h)) {
+                spatial_hash_cell_add(hash, (Point){ w, h }, collider);
+            }
+        }
     }
-    map_iter_end
 }
 
-SOREN_EXPORT void spatial_hash_move(SpatialHash* hash, Collider* collider, Vector delta) {
-    spatial_hash_remove(hash, collider);
-    collider_set_position(collider, vector_add(delta, collider_position(collider)));
-    spatial_hash_add(hash, collider);
+static inline RectF vector_to_rectf(Vector v) {
+    return (RectF){ v.x, v.y, 0, 0 };
 }
 
-SOREN_EXPORT void spatial_hash_set_position(SpatialHash* hash, Collider* collider, Vector position) {
-    spatial_hash_remove(hash, collider);
-    collider_set_position(collider, position);
-    spatial_hash_add(hash, collider);
+static inline Point vector_to_cell_point(SpatialHash* hash, Vector v) {
+    return (Point){ fast_floor(v.x * hash->inverse_cell_size), fast_floor(v.y * hash->inverse_cell_size) };
 }
 
-SOREN_EXPORT void spatial_hash_rotate(SpatialHash* hash, Collider* collider, float delta_rotation) {
-    spatial_hash_remove(hash, collider);
-    collider_set_rotation(collider, delta_rotation + collider_rotation(collider));
-    spatial_hash_add(hash, collider);
+// Colliders that cover several cells are deduplicated by stamping them with
+// the epoch of the current query instead of gathering them into a set. A query
+// started from a visitor would restamp the colliders of the outer query, so
+// queries on the same hash can't be nested.
+static inline void spatial_hash_begin_query(SpatialHash* hash) {
+    soren_assert(!hash->query_running);
+    hash->query_running = true;
+    hash->query_epoch++;
 }
 
-SOREN_EXPORT void spatial_hash_set_rotation(SpatialHash* hash, Collider* collider, float rotation) {
-    spatial_hash_remove(hash, collider);
-    collider_set_rotation(collider, rotation);
-    spatial_hash_add(hash, collider);
+static inline void spatial_hash_end_query(SpatialHash* hash) {
+    hash->query_running = false;
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_all(SpatialHash* hash, ColliderCollection* results) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+static inline bool spatial_hash_query_visit(SpatialHash* hash, Collider* collider) {
+    return collider_query_visit(collider, hash->query_epoch);
+}
+
+// Concurrent queries can't stamp the colliders, so instead a collider is only visited
+// in the first cell of the query that it covers. Returns true if the cell at (x, y) is
+// that cell for a collider that covers the range of cells.
+static inline bool cell_range_first_in_query(Rect range, int x, int y, int minx, int miny) {
+    return x == SDL_max(range.x, minx) && y == SDL_max(range.y, miny);
+}
+
+static inline bool spatial_hash_visit_once(SpatialHash* hash, SpatialHashVisit* visit, Collider* collider, int x, int y, int minx, int miny) {
+    if (!visit->concurrent) {
+        return spatial_hash_query_visit(hash, collider);
     }
 
-    ColliderCollection* set;
+    Rect range;
+    return !collider_cell_map_try_get(hash->collider_cells, collider, &range)
+        || cell_range_first_in_query(range, x, y, minx, miny);
+}
 
-    map_iter_value_start(hash->cells, set) {
-        collider_collection_union(results, set, results);
+static inline int static_cell_compare(Point left, Point right) {
+    if (left.y != right.y) {
+        return left.y < right.y ? -1 : 1;
     }
-    map_iter_end
 
-    return results;
+    if (left.x != right.x) {
+        return left.x < right.x ? -1 : 1;
+    }
+
+    return 0;
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_all_ext(SpatialHash* hash, ColliderCollection* results, void* ctx, ColliderPredicate predicate) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+typedef struct StaticCellEntry {
+    Point cell;
+    int index;
+} StaticCellEntry;
+
+static int static_cell_entry_compare(const void* left, const void* right) {
+    const StaticCellEntry* a = left;
+    const StaticCellEntry* b = right;
+
+    int result = static_cell_compare(a->cell, b->cell);
+    if (result != 0) {
+        return result;
     }
 
-    ColliderCollection* set;
-    Collider* collider;
+    return a->index - b->index;
+}
 
-    map_iter_value_start(hash->cells, set) {
-        if (set->using_set) {
-            set_iter_start(set->set, collider) {
-                if (predicate(collider, ctx)) {
-                    collider_collection_add(results, collider);
-                }
-            }
-            set_iter_end
-        } else {
-            list_iter_start(set->list, collider) {
-                collider_collection_add(results, collider);
+static void spatial_hash_bake_static_impl(SpatialHash* hash) {
+    int entries_count = 0;
+    for (int i = 0; i < hash->static_count; i++) {
+        entries_count += hash->static_ranges[i].w * hash->static_ranges[i].h;
+    }
+
+    StaticCellEntry* entries = soren_malloc(SDL_max(1, entries_count) * sizeof(*entries));
+    int index = 0;
+
+    for (int i = 0; i < hash->static_count; i++) {
+        Rect range = hash->static_ranges[i];
+        for (int h = range.y; h < range.y + range.h; h++) {
+            for (int w = range.x; w < range.x + range.w; w++) {
+                entries[index++] = (StaticCellEntry){ { w, h }, i };
             }
-            list_iter_end
         }
     }
-    map_iter_end
-
-    return results;
-}
 
-SOREN_EXPORT ColliderCollection* spatial_hash_broadphase_vector(SpatialHash* hash, Vector position, ColliderCollection* results) {
-    return spatial_hash_broadphase_rectf(hash, vector_to_rectf(position), results);
-}
+    SDL_qsort(entries, entries_count, sizeof(*entries), static_cell_entry_compare);
 
-SOREN_EXPORT ColliderCollection* spatial_hash_broadphase_rectf(SpatialHash* hash, RectF rect, ColliderCollection* results) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+    int cells_count = 0;
+    for (int i = 0; i < entries_count; i++) {
+        if (i == 0 || static_cell_compare(entries[i].cell, entries[i - 1].cell) != 0) {
+            cells_count++;
+        }
     }
 
-    GET_OVERLAPPING_SET_START(rect, hash)
+    hash->static_cells = soren_realloc(hash->static_cells, SDL_max(1, cells_count) * sizeof(*hash->static_cells));
+    hash->static_offsets = soren_realloc(hash->static_offsets, (cells_count + 1) * sizeof(*hash->static_offsets));
+    hash->static_entries = soren_realloc(hash->static_entries, SDL_max(1, entries_count) * sizeof(*hash->static_entries));
 
-    collider_collection_union(set, results, results);
+    int cell = -1;
+    for (int i = 0; i < entries_count; i++) {
+        if (i == 0 || static_cell_compare(entries[i].cell, entries[i - 1].cell) != 0) {
+            cell++;
+            hash->static_cells[cell] = entries[i].cell;
+            hash->static_offsets[cell] = i;
+        }
 
-    GET_OVERLAPPING_SET_END
+        hash->static_entries[i] = entries[i].index;
+    }
 
-    return results;
-}
+    hash->static_offsets[cells_count] = entries_count;
+    hash->static_cells_count = cells_count;
+    hash->static_dirty = false;
 
-SOREN_EXPORT ColliderCollection* spatial_hash_broadphase_collider(SpatialHash* hash, Collider* collider, ColliderCollection* results) {
-    return spatial_hash_broadphase_rectf(hash, collider_bounds(collider), results);
-}
-SOREN_EXPORT bool spatial_hash_collides_vector(SpatialHash* hash, Vector position) {
-    return spatial_hash_first_vector(hash, position) != NULL;
+    soren_free(entries);
 }
 
-SOREN_EXPORT bool spatial_hash_collides_vector_ext(SpatialHash* hash, Vector position, void* ctx, ColliderVectorTest test) {
-    return spatial_hash_first_vector_ext(hash, position, ctx, test) != NULL;
+// The regular queries rebuild the static tier when it has changed since it was last baked.
+// The spatial_query_* functions can run concurrently, so they can't, and they require the
+// tier to be baked with spatial_hash_bake_static or spatial_hash_prepare_queries first.
+static inline void spatial_hash_ensure_static_baked(SpatialHash* hash) {
+    if (hash->static_dirty) {
+        spatial_hash_bake_static_impl(hash);
+    }
 }
 
-SOREN_EXPORT bool spatial_hash_collides_rectf(SpatialHash* hash, RectF bounds) {
-    return spatial_hash_first_rectf(hash, bounds) != NULL;
+// Finds the range of static_entries that belong to a cell using a binary search.
+static inline bool spatial_hash_static_cell_try_get(SpatialHash* hash, Point p, int* out_start, int* out_end) {
+    int low = 0;
+    int high = hash->static_cells_count - 1;
+
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        int compare = static_cell_compare(hash->static_cells[middle], p);
+
+        if (compare == 0) {
+            *out_start = hash->static_offsets[middle];
+            *out_end = hash->static_offsets[middle + 1];
+            return true;
+        }
+
+        if (compare < 0) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    return false;
 }
 
-SOREN_EXPORT bool spatial_hash_collides_rectf_ext(SpatialHash* hash, RectF bounds, void* ctx, ColliderRectFTest test) {
-    return spatial_hash_first_rectf_ext(hash, bounds, ctx, test) != NULL;
+// Iterates the static colliders in the cells overlapping the rect as static_collider.
+// Colliders that cover several of the cells are visited once per cell. The tier must
+// already be baked, see spatial_hash_ensure_static_baked.
+#define GET_STATIC_START(rect, spatial_hash) \
+    if (spatial_hash->static_cells_count > 0) { \
+        GET_CELL_RANGE(rect, spatial_hash) \
+        int static_start; \
+        int static_end; \
+        for (int w = minx; w < maxx; w++) { \
+            for (int h = miny; h < maxy; h++) { \
+                if (!spatial_hash_static_cell_try_get(spatial_hash, (Point){ w, h }, &static_start, &static_end)) { \
+                    continue; \
+                } \
+                for (int static_index = static_start; static_index < static_end; static_index++) { \
+                    Collider* static_collider = spatial_hash->static_colliders[spatial_hash->static_entries[static_index]];
+
+#define GET_STATIC_END } } } }
+
+SOREN_EXPORT SpatialHash* spatial_hash_create(float cell_size) {
+    SpatialHash* result = soren_malloc(sizeof(*result));
+    result->inverse_cell_size = 1.f / cell_size;
+    result->grid = NULL;
+    result->grid_bounds = RECT_EMPTY;
+    result->cells = spatial_store_create();
+    result->collider_cells = collider_cell_map_create();
+    result->cell_pool = collider_collection_list_create();
+    result->empty_cells = point_list_create();
+    result->cache = collider_collection_create();
+    result->query_epoch = collider_reserve_query_epochs();
+    result->query_running = false;
+    result->pair_scratch = NULL;
+    result->pair_scratch_capacity = 0;
+    result->nearest_scratch = NULL;
+    result->nearest_scratch_capacity = 0;
+    result->occupied_min = (Point){ SDL_MAX_SINT32, SDL_MAX_SINT32 };
+    result->occupied_max = (Point){ SDL_MIN_SINT32, SDL_MIN_SINT32 };
+    result->static_colliders = NULL;
+    result->static_ranges = NULL;
+    result->static_count = 0;
+    result->static_capacity = 0;
+    result->static_cells = NULL;
+    result->static_offsets = NULL;
+    result->static_entries = NULL;
+    result->static_cells_count = 0;
+    result->static_dirty = false;
+    result->static_blob = NULL;
+    result->static_borrowed = false;
+    result->tree = NULL;
+
+    return result;
 }
 
-SOREN_EXPORT bool spatial_hash_collides_collider(SpatialHash* hash, Collider* collider) {
-    return spatial_hash_first_collider(hash, collider) != NULL;
+SOREN_EXPORT SpatialHash* spatial_hash_create_bounded(float cell_size, RectF world) {
+    SpatialHash* result = spatial_hash_create(cell_size);
+    result->grid_bounds = spatial_hash_cell_range(result, world);
+    result->grid = soren_calloc(result->grid_bounds.w * result->grid_bounds.h, sizeof(*result->grid));
+
+    return result;
 }
 
-SOREN_EXPORT bool spatial_hash_collides_collider_ext(SpatialHash* hash, Collider* collider, void* ctx, ColliderColliderTest test) {
-    return spatial_hash_first_collider_ext(hash, collider, ctx, test) != NULL;
+SOREN_EXPORT SpatialHash* spatial_hash_create_dynamic_tree(float margin) {
+    SpatialHash* result = soren_calloc(1, sizeof(*result));
+    result->tree = aabb_tree_create(margin);
+
+    return result;
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_collisions_vector(SpatialHash* hash, ColliderCollection* results, Vector position) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+SOREN_EXPORT void spatial_hash_free(SpatialHash* hash) {
+    if (hash->tree) {
+        aabb_tree_free(hash->tree);
+        soren_free(hash);
+        return;
     }
 
-    collider_collection_clear(hash->secondary_cache);
-    spatial_hash_broadphase_vector(hash, position, hash->secondary_cache);
-
-    Collider* collider;
+    ColliderCollection* collection;
+    map_iter_value_start(hash->cells, collection) {
+        collider_collection_free(collection);
+    }
+    map_iter_end
 
-    if (hash->secondary_cache->using_set) {
-        set_iter_start(hash->secondary_cache->set, collider) {
-            if (collider_overlaps(collider, position)) {
-                collider_collection_add(results, collider);
-            }
-        } 
-        set_iter_end
-    } else {
-        list_iter_start(hash->secondary_cache->list, collider) {
-            if (collider_overlaps(collider, position)) {
-                collider_collection_add(results, collider);
+    if (hash->grid) {
+        for (int i = 0; i < hash->grid_bounds.w * hash->grid_bounds.h; i++) {
+            if (hash->grid[i]) {
+                collider_collection_free(hash->grid[i]);
             }
         }
-        list_iter_end
+
+        soren_free(hash->grid);
     }
 
-    return results;
-}
+    list_iter_start(hash->cell_pool, collection) {
+        collider_collection_free(collection);
+    }
+    list_iter_end
 
-SOREN_EXPORT ColliderCollection* spatial_hash_collisions_vector_ext(SpatialHash* hash, ColliderCollection* results, Vector position, void* ctx, ColliderVectorTest test) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+    collider_collection_list_free(hash->cell_pool);
+    point_list_free(hash->empty_cells);
+    collider_collection_free(hash->cache);
+    soren_free(hash->pair_scratch);
+    soren_free(hash->nearest_scratch);
+    if (!hash->static_borrowed) {
+        soren_free(hash->static_colliders);
+        soren_free(hash->static_ranges);
+        soren_free(hash->static_cells);
+        soren_free(hash->static_offsets);
+        soren_free(hash->static_entries);
     }
 
-    collider_collection_clear(hash->secondary_cache);
-    spatial_hash_broadphase_vector(hash, position, hash->secondary_cache);
+    soren_free(hash->static_blob);
+    spatial_store_free(hash->cells);
+    collider_cell_map_free(hash->collider_cells);
 
-    Collider* collider;
+    soren_free(hash);
+}
 
-    if (hash->secondary_cache->using_set) {
-        set_iter_start(hash->secondary_cache->set, collider) {
-            if (collider_overlaps(collider, position) && test(collider, position, ctx)) {
-                collider_collection_add(results, collider);
-            }
-        } 
-        set_iter_end
-    } else {
-        list_iter_start(hash->secondary_cache->list, collider) {
-            if (collider_overlaps(collider, position) && test(collider, position, ctx)) {
-                collider_collection_add(results, collider);
-            }
+SOREN_EXPORT void spatial_hash_add(SpatialHash* hash, Collider* collider) {
+    if (hash->tree) {
+        aabb_tree_add(hash->tree, collider);
+        return;
+    }
+
+    Rect range = spatial_hash_cell_range(hash, collider_bounds(collider));
+    Rect old_range;
+
+    if (collider_cell_map_try_get(hash->collider_cells, collider, &old_range)) {
+        if (!rect_equals(old_range, range)) {
+            spatial_hash_move_range(hash, collider, old_range, range);
         }
-        list_iter_end
+    } else {
+        spatial_hash_add_range(hash, collider, range);
     }
 
-    return results;
+    spatial_hash_extend_occupied(hash, range);
+    collider_cell_map_set(hash->collider_cells, collider, range);
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_collisions_rectf(SpatialHash* hash, ColliderCollection* results, RectF bounds) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+// Copies the static arrays out of a loaded blob so they can be resized.
+// The colliders themselves stay in the blob.
+static void spatial_hash_static_detach(SpatialHash* hash) {
+    if (!hash->static_borrowed) {
+        return;
     }
 
-    collider_collection_clear(hash->secondary_cache);
-    spatial_hash_broadphase_rectf(hash, bounds, hash->secondary_cache);
+    Collider** colliders = hash->static_colliders;
+    Rect* ranges = hash->static_ranges;
+
+    hash->static_capacity = SDL_max(16, hash->static_count);
+    hash->static_colliders = soren_malloc(hash->static_capacity * sizeof(*hash->static_colliders));
+    hash->static_ranges = soren_malloc(hash->static_capacity * sizeof(*hash->static_ranges));
+    SDL_memcpy(hash->static_colliders, colliders, hash->static_count * sizeof(*colliders));
+    SDL_memcpy(hash->static_ranges, ranges, hash->static_count * sizeof(*ranges));
+
+    hash->static_cells = NULL;
+    hash->static_offsets = NULL;
+    hash->static_entries = NULL;
+    hash->static_cells_count = 0;
+    hash->static_dirty = true;
+    hash->static_borrowed = false;
+}
 
-    Collider* collider;
+SOREN_EXPORT void spatial_hash_add_static(SpatialHash* hash, Collider* collider) {
+    if (hash->tree) {
+        aabb_tree_add(hash->tree, collider);
+        return;
+    }
 
-    if (hash->secondary_cache->using_set) {
-        set_iter_start(hash->secondary_cache->set, collider) {
-            if (collider_overlaps(collider, bounds)) {
-                collider_collection_add(results, collider);
-            }
-        } 
-        set_iter_end
-    } else {
-        list_iter_start(hash->secondary_cache->list, collider) {
-            if (collider_overlaps(collider, bounds)) {
-                collider_collection_add(results, collider);
-            }
+    spatial_hash_static_detach(hash);
+
+    if (hash->static_count == hash->static_capacity) {
+        hash->static_capacity = hash->static_capacity == 0 ? 16 : hash->static_capacity * 2;
+        hash->static_colliders = soren_realloc(hash->static_colliders, hash->static_capacity * sizeof(*hash->static_colliders));
+        hash->static_ranges = soren_realloc(hash->static_ranges, hash->static_capacity * sizeof(*hash->static_ranges));
+    }
+
+    hash->static_colliders[hash->static_count] = collider;
+    hash->static_ranges[hash->static_count] = spatial_hash_cell_range(hash, collider_bounds(collider));
+    spatial_hash_extend_occupied(hash, hash->static_ranges[hash->static_count]);
+    hash->static_count++;
+    hash->static_dirty = true;
+}
+
+static int spatial_hash_static_index(SpatialHash* hash, Collider* collider) {
+    for (int i = 0; i < hash->static_count; i++) {
+        if (hash->static_colliders[i] == collider) {
+            return i;
         }
-        list_iter_end
     }
 
-    return results;
+    return -1;
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_collisions_rectf_ext(SpatialHash* hash, ColliderCollection* results, RectF bounds, void* ctx, ColliderRectFTest test) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+SOREN_EXPORT void spatial_hash_remove_static(SpatialHash* hash, Collider* collider) {
+    if (hash->tree) {
+        aabb_tree_remove(hash->tree, collider);
+        return;
     }
 
-    collider_collection_clear(hash->secondary_cache);
-    spatial_hash_broadphase_rectf(hash, bounds, hash->secondary_cache);
+    int index = spatial_hash_static_index(hash, collider);
+    if (index == -1) {
+        return;
+    }
 
-    Collider* collider;
+    spatial_hash_static_detach(hash);
 
-    if (hash->secondary_cache->using_set) {
-        set_iter_start(hash->secondary_cache->set, collider) {
-            if (collider_overlaps(collider, bounds) && test(collider, bounds, ctx)) {
-                collider_collection_add(results, collider);
-            }
-        } 
-        set_iter_end
-    } else {
-        list_iter_start(hash->secondary_cache->list, collider) {
-            if (collider_overlaps(collider, bounds) && test(collider, bounds, ctx)) {
-                collider_collection_add(results, collider);
-            }
-        }
-        list_iter_end
+    hash->static_count--;
+    hash->static_colliders[index] = hash->static_colliders[hash->static_count];
+    hash->static_ranges[index] = hash->static_ranges[hash->static_count];
+    hash->static_dirty = true;
+}
+
+SOREN_EXPORT void spatial_hash_clear_static(SpatialHash* hash) {
+    if (hash->tree) {
+        return;
     }
 
-    return results;
+    spatial_hash_static_detach(hash);
+
+    hash->static_count = 0;
+    hash->static_cells_count = 0;
+    hash->static_dirty = false;
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_collisions_collider(SpatialHash* hash, ColliderCollection* results, Collider* collider) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+SOREN_EXPORT void spatial_hash_bake_static(SpatialHash* hash) {
+    if (hash->tree || !hash->static_dirty) {
+        return;
     }
 
-    collider_collection_clear(hash->secondary_cache);
-    spatial_hash_broadphase_collider(hash, collider, hash->secondary_cache);
+    spatial_hash_bake_static_impl(hash);
+}
 
-    Collider* other;
+SOREN_EXPORT void spatial_hash_clear(SpatialHash* hash) {
+    if (hash->tree) {
+        aabb_tree_clear(hash->tree);
+        return;
+    }
 
-    if (hash->secondary_cache->using_set) {
-        set_iter_start(hash->secondary_cache->set, other) {
-            if (collider != other && collider_overlaps(collider, other)) {
-                collider_collection_add(results, other);
-            }
-        } 
-        set_iter_end
-    } else {
-        list_iter_start(hash->secondary_cache->list, other) {
-            if (collider != other && collider_overlaps(collider, other)) {
-                collider_collection_add(results, other);
+    ColliderCollection* set;
+
+    map_iter_value_start(hash->cells, set) {
+        spatial_hash_cell_recycle(hash, set);
+    }
+    map_iter_end
+
+    if (hash->grid) {
+        for (int i = 0; i < hash->grid_bounds.w * hash->grid_bounds.h; i++) {
+            if (hash->grid[i]) {
+                spatial_hash_cell_recycle(hash, hash->grid[i]);
+                hash->grid[i] = NULL;
             }
         }
-        list_iter_end
     }
 
-    return results;
+    spatial_store_clear(hash->cells, true);
+    collider_cell_map_clear(hash->collider_cells, true);
+    spatial_hash_reset_occupied(hash);
 }
 
-SOREN_EXPORT ColliderCollection* spatial_hash_collisions_collider_ext(SpatialHash* hash, ColliderCollection* results, Collider* collider, void* ctx, ColliderColliderTest test) {
-    if (!results) {
-        collider_collection_clear(hash->cache);
-        results = hash->cache;
+SOREN_EXPORT void spatial_hash_remove(SpatialHash* hash, Collider* collider) {
+    if (hash->tree) {
+        aabb_tree_remove(hash->tree, collider);
+        return;
     }
 
-    collider_collection_clear(hash->secondary_cache);
-    spatial_hash_broadphase_collider(hash, collider, hash->secondary_cache);
+    Rect range;
 
-    Collider* other;
-
-    if (hash->secondary_cache->using_set) {
-        set_iter_start(hash->secondary_cache->set, other) {
-            if (collider != other && collider_overlaps(collider, other) && test(collider, other, ctx)) {
-                collider_collection_add(results, other);
-            }
-        } 
-        set_iter_end
+    // Prefer the range the collider was inserted with in case it was moved
+    // without going through the spatial hash.
+    if (collider_cell_map_try_get(hash->collider_cells, collider, &range)) {
+        collider_cell_map_remove(hash->collider_cells, collider);
+    } else if (spatial_hash_static_index(hash, collider) != -1) {
+        spatial_hash_remove_static(hash, collider);
+        return;
     } else {
-        list_iter_start(hash->secondary_cache->list, other) {
-            if (collider != other && collider_overlaps(collider, other) && test(collider, other, ctx)) {
-                collider_collection_add(results, other);
-            }
-        }
-        list_iter_end
+        range = spatial_hash_cell_range(hash, collider_bounds(collider));
     }
 
-    return results;
+    spatial_hash_remove_range(hash, collider, range);
 }
 
-SOREN_EXPORT Collider* spatial_hash_first_vector(SpatialHash* hash, Vector position) {
-    Point p = vector_to_cell_point(hash, position);
+SOREN_EXPORT void spatial_hash_remove_with_brute_force(SpatialHash* hash, Collider* collider) {
+    // The tree tracks the leaf of every collider, so it never needs the bounds to remove one.
+    if (hash->tree) {
+        aabb_tree_remove(hash->tree, collider);
+        return;
+    }
+
+    if (spatial_hash_static_index(hash, collider) != -1) {
+        spatial_hash_remove_static(hash, collider);
+        return;
+    }
+
+    Point p;
     ColliderCollection* set;
-    Collider* collider;
 
-    if (spatial_store_try_get(hash->cells, p, &set)) {
-        if (set->using_set) {
-            set_iter_start(set->set, collider) {
-                if (collider_contains_point_impl(collider, position)) {
-                    return collider;
-                }
-            }
-            set_iter_end
-        } else {
-            list_iter_start(set->list, collider) {
-                if (collider_contains_point_impl(collider, position)) {
-                    return collider;
-                }
+    // Cells can't be evicted while iterating the map, so keep track
+    // of the ones that were emptied and remove them afterwards.
+    point_list_clear(hash->empty_cells);
+    collider_cell_map_remove(hash->collider_cells, collider);
+
+    map_iter_start(hash->cells, p, set) {
+        if (collider_collection_remove(set, collider) && collider_collection_count(set) == 0) {
+            point_list_add(hash->empty_cells, p);
+        }
+    }
+    map_iter_end
+
+    list_iter_start(hash->empty_cells, p) {
+        if (spatial_store_try_get(hash->cells, p, &set)) {
+            spatial_hash_cell_evict(hash, p, set);
+        }
+    }
+    list_iter_end
+
+    if (hash->grid) {
+        for (int i = 0; i < hash->grid_bounds.w * hash->grid_bounds.h; i++) {
+            set = hash->grid[i];
+            if (set && collider_collection_remove(set, collider) && collider_collection_count(set) == 0) {
+                spatial_hash_cell_recycle(hash, set);
+                hash->grid[i] = NULL;
             }
-            list_iter_end
         }
     }
+}
 
-    return NULL;
+SOREN_EXPORT void spatial_hash_update(SpatialHash* hash, Collider* collider) {
+    if (hash->tree) {
+        aabb_tree_update(hash->tree, collider);
+        return;
+    }
+
+    spatial_hash_add(hash, collider);
 }
 
-SOREN_EXPORT Collider* spatial_hash_first_vector_ext(SpatialHash* hash, Vector position, void* ctx, ColliderVectorTest test) {
-    Point p = vector_to_cell_point(hash, position);
-    ColliderCollection* set;
+SOREN_EXPORT void spatial_hash_move(SpatialHash* hash, Collider* collider, Vector delta) {
+    if (hash->tree) {
+        aabb_tree_move(hash->tree, collider, delta);
+        return;
+    }
+
+    collider_set_position(collider, vector_add(delta, collider_position(collider)));
+    spatial_hash_update(hash, collider);
+}
+
+SOREN_EXPORT void spatial_hash_set_position(SpatialHash* hash, Collider* collider, Vector position) {
+    if (hash->tree) {
+        aabb_tree_set_position(hash->tree, collider, position);
+        return;
+    }
+
+    collider_set_position(collider, position);
+    spatial_hash_update(hash, collider);
+}
+
+SOREN_EXPORT void spatial_hash_rotate(SpatialHash* hash, Collider* collider, float delta_rotation) {
+    collider_set_rotation(collider, delta_rotation + collider_rotation(collider));
+    spatial_hash_update(hash, collider);
+}
+
+SOREN_EXPORT void spatial_hash_set_rotation(SpatialHash* hash, Collider* collider, float rotation) {
+    collider_set_rotation(collider, rotation);
+    spatial_hash_update(hash, collider);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_all(SpatialHash* hash, ColliderCollection* results) {
+    if (hash->tree) {
+        return aabb_tree_all(hash->tree, results);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
+    // Every collider in the hash has exactly one entry in the cell map,
+    // so there's no need to union every cell together.
     Collider* collider;
 
-    if (spatial_store_try_get(hash->cells, p, &set)) {
-        if (set->using_set) {
-            set_iter_start(set->set, collider) {
-                if (collider_contains_point_impl(collider, position) && test(collider, position, ctx)) {
-                    return collider;
-                }
-            }
-            set_iter_end
-        } else {
-            list_iter_start(set->list, collider) {
-                if (collider_contains_point_impl(collider, position) && test(collider, position, ctx)) {
-                    return collider;
-                }
-            }
-            list_iter_end
-        }
+    map_iter_key_start(hash->collider_cells, collider) {
+        collider_collection_add(results, collider);
+    }
+    map_iter_end
+
+    for (int i = 0; i < hash->static_count; i++) {
+        collider_collection_add(results, hash->static_colliders[i]);
     }
 
-    return NULL;
+    return results;
 }
 
-SOREN_EXPORT Collider* spatial_hash_first_rectf(SpatialHash* hash, RectF bounds) {
+SOREN_EXPORT ColliderCollection* spatial_hash_all_ext(SpatialHash* hash, ColliderCollection* results, void* ctx, ColliderPredicate predicate) {
+    if (hash->tree) {
+        return aabb_tree_all_ext(hash->tree, results, ctx, predicate);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
     Collider* collider;
 
-    GET_OVERLAPPING_SET_START(bounds, hash)
+    map_iter_key_start(hash->collider_cells, collider) {
+        if (predicate(collider, ctx)) {
+            collider_collection_add(results, collider);
+        }
+    }
+    map_iter_end
 
-    if (set->using_set) {
-            set_iter_start(set->set, collider) {
-                if (collider_overlaps(collider, bounds)) {
-                    return collider;
-                }
-            }
-            set_iter_end
-        } else {
-            list_iter_start(set->list, collider) {
-                if (collider_overlaps(collider, bounds)) {
-                    return collider;
-                }
-            }
-            list_iter_end
+    for (int i = 0; i < hash->static_count; i++) {
+        if (predicate(hash->static_colliders[i], ctx)) {
+            collider_collection_add(results, hash->static_colliders[i]);
         }
+    }
 
-    GET_OVERLAPPING_SET_END
+    return results;
+}
 
-    return NULL;
+SOREN_EXPORT ColliderCollection* spatial_hash_broadphase_vector(SpatialHash* hash, Vector position, ColliderCollection* results) {
+    return spatial_hash_broadphase_rectf(hash, vector_to_rectf(position), results);
 }
 
-SOREN_EXPORT Collider* spatial_hash_first_rectf_ext(SpatialHash* hash, RectF bounds, void* ctx, ColliderRectFTest test) {
-    Collider* collider;
+SOREN_EXPORT ColliderCollection* spatial_hash_broadphase_rectf(SpatialHash* hash, RectF rect, ColliderCollection* results) {
+    if (hash->tree) {
+        return aabb_tree_broadphase_rectf(hash->tree, rect, results);
+    }
 
-    GET_OVERLAPPING_SET_START(bounds, hash)
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
 
-    if (set->using_set) {
-            set_iter_start(set->set, collider) {
-                if (collider_overlaps(collider, bounds) && test(collider, bounds, ctx)) {
-                    return collider;
-                }
-            }
-            set_iter_end
-        } else {
-            list_iter_start(set->list, collider) {
-                if (collider_overlaps(collider, bounds) && test(collider, bounds, ctx)) {
-                    return collider;
-                }
-            }
-            list_iter_end
-        }
+    GET_EXISTING_SET_START(rect, hash)
+
+    collider_collection_union(set, results, results);
 
-    GET_OVERLAPPING_SET_END
+    GET_EXISTING_SET_END
 
-    return NULL;
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(rect, hash)
+
+    collider_collection_add(results, static_collider);
+
+    GET_STATIC_END
+
+    return results;
 }
 
-SOREN_EXPORT Collider* spatial_hash_first_collider(SpatialHash* hash, Collider* collider) {
+SOREN_EXPORT ColliderCollection* spatial_hash_broadphase_collider(SpatialHash* hash, Collider* collider, ColliderCollection* results) {
+    if (hash->tree) {
+        return aabb_tree_broadphase_collider(hash->tree, collider, results);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
     Collider* other;
     RectF bounds = collider_bounds(collider);
 
-    GET_OVERLAPPING_SET_START(bounds, hash)
+    GET_EXISTING_SET_START(bounds, hash)
 
     if (set->using_set) {
             set_iter_start(set->set, other) {
-                if (other != collider && collider_overlaps(collider, other)) {
-                    return other;
+                if (other == collider || collider_should_collide(collider, other)) {
+                    collider_collection_add(results, other);
                 }
             }
             set_iter_end
         } else {
             list_iter_start(set->list, other) {
-                if (other != collider && collider_overlaps(collider, other)) {
-                    return other;
+                if (other == collider || collider_should_collide(collider, other)) {
+                    collider_collection_add(results, other);
                 }
             }
             list_iter_end
         }
 
-    GET_OVERLAPPING_SET_END
+    GET_EXISTING_SET_END
 
-    return NULL;
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(bounds, hash)
+
+    if (static_collider == collider || collider_should_collide(collider, static_collider)) {
+        collider_collection_add(results, static_collider);
+    }
+
+    GET_STATIC_END
+
+    return results;
+}
+SOREN_EXPORT bool spatial_hash_collides_vector(SpatialHash* hash, Vector position) {
+    return spatial_hash_first_vector(hash, position) != NULL;
 }
 
-SOREN_EXPORT Collider* spatial_hash_first_collider_ext(SpatialHash* hash, Collider* collider, void* ctx, ColliderColliderTest test) {
-    Collider* other;
-    RectF bounds = collider_bounds(collider);
+SOREN_EXPORT bool spatial_hash_collides_vector_ext(SpatialHash* hash, Vector position, void* ctx, ColliderVectorTest test) {
+    return spatial_hash_first_vector_ext(hash, position, ctx, test) != NULL;
+}
+
+SOREN_EXPORT bool spatial_hash_collides_rectf(SpatialHash* hash, RectF bounds) {
+    return spatial_hash_first_rectf(hash, bounds) != NULL;
+}
+
+SOREN_EXPORT bool spatial_hash_collides_rectf_ext(SpatialHash* hash, RectF bounds, void* ctx, ColliderRectFTest test) {
+    return spatial_hash_first_rectf_ext(hash, bounds, ctx, test) != NULL;
+}
+
+SOREN_EXPORT bool spatial_hash_collides_collider(SpatialHash* hash, Collider* collider) {
+    return spatial_hash_first_collider(hash, collider) != NULL;
+}
+
+SOREN_EXPORT bool spatial_hash_collides_collider_ext(SpatialHash* hash, Collider* collider, void* ctx, ColliderColliderTest test) {
+    return spatial_hash_first_collider_ext(hash, collider, ctx, test) != NULL;
+}
+
+static bool spatial_hash_for_each_cells(SpatialHash* hash, RectF rect, SpatialHashVisit* visit) {
+    Collider* collider;
 
-    GET_OVERLAPPING_SET_START(bounds, hash)
+    GET_EXISTING_SET_START(rect, hash)
 
     if (set->using_set) {
-            set_iter_start(set->set, other) {
-                if (other != collider && collider_overlaps(collider, other) && test(collider, other, ctx)) {
-                    return other;
+            set_iter_start(set->set, collider) {
+                if (spatial_hash_visit_once(hash, visit, collider, w, h, minx, miny)
+                    && (!visit->filter || visit->filter(collider, visit))
+                    && !visit->visitor(collider, visit->ctx))
+                {
+                    return false;
                 }
             }
             set_iter_end
         } else {
-            list_iter_start(set->list, other) {
-                if (other != collider && collider_overlaps(collider, other) && test(collider, other, ctx)) {
-                    return other;
+            list_iter_start(set->list, collider) {
+                if (spatial_hash_visit_once(hash, visit, collider, w, h, minx, miny)
+                    && (!visit->filter || visit->filter(collider, visit))
+                    && !visit->visitor(collider, visit->ctx))
+                {
+                    return false;
                 }
             }
             list_iter_end
         }
 
-    GET_OVERLAPPING_SET_END
+    GET_EXISTING_SET_END
 
-    return NULL;
-}
\ No newline at end of file
+    GET_STATIC_START(rect, hash)
+
+    bool first = visit->concurrent
+        ? cell_range_first_in_query(hash->static_ranges[hash->static_entries[static_index]], w, h, minx, miny)
+        : spatial_hash_query_visit(hash, static_collider);
+
+    if (first
+        && (!visit->filter || visit->filter(static_collider, visit))
+        && !visit->visitor(static_collider, visit->ctx))
+    {
+        return false;
+    }
+
+    GET_STATIC_END
+
+    return true;
+}
+
+// Calls the visitor for every unique collider in the cells overlapping the rect
+// that passes the filter. Returns false if the visitor stopped the query early.
+static bool spatial_hash_for_each_impl(SpatialHash* hash, RectF rect, SpatialHashVisit* visit) {
+    if (visit->concurrent) {
+        return spatial_hash_for_each_cells(hash, rect, visit);
+    }
+
+    spatial_hash_ensure_static_baked(hash);
+    spatial_hash_begin_query(hash);
+    bool result = spatial_hash_for_each_cells(hash, rect, visit);
+    spatial_hash_end_query(hash);
+
+    return result;
+}
+
+static bool spatial_hash_filter_vector(Collider* collider, SpatialHashVisit* visit) {
+    return collider_overlaps(collider, visit->position);
+}
+
+static bool spatial_hash_filter_rectf(Collider* collider, SpatialHashVisit* visit) {
+    return collider_overlaps(collider, visit->bounds);
+}
+
+static bool spatial_hash_filter_collider(Collider* collider, SpatialHashVisit* visit) {
+    return collider != visit->collider
+        && collider_should_collide(visit->collider, collider)
+        && collider_overlaps(visit->collider, collider);
+}
+
+SOREN_EXPORT bool spatial_hash_for_each_broadphase_rectf(SpatialHash* hash, RectF rect, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_broadphase_rectf(hash->tree, rect, ctx, visitor);
+    }
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx };
+    return spatial_hash_for_each_impl(hash, rect, &visit);
+}
+
+SOREN_EXPORT bool spatial_hash_for_each_vector(SpatialHash* hash, Vector position, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_vector(hash->tree, position, ctx, visitor);
+    }
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .filter = spatial_hash_filter_vector, .position = position };
+    return spatial_hash_for_each_impl(hash, vector_to_rectf(position), &visit);
+}
+
+SOREN_EXPORT bool spatial_hash_for_each_rectf(SpatialHash* hash, RectF bounds, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_rectf(hash->tree, bounds, ctx, visitor);
+    }
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .filter = spatial_hash_filter_rectf, .bounds = bounds };
+    return spatial_hash_for_each_impl(hash, bounds, &visit);
+}
+
+SOREN_EXPORT bool spatial_hash_for_each_collider(SpatialHash* hash, Collider* collider, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_collider(hash->tree, collider, ctx, visitor);
+    }
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .filter = spatial_hash_filter_collider, .collider = collider };
+    return spatial_hash_for_each_impl(hash, collider_bounds(collider), &visit);
+}
+
+// Adds each collider that passes the optional test of the collect query to its results.
+
+static bool spatial_hash_collect_vector(Collider* collider, void* ctx) {
+    SpatialHashCollect* collect = ctx;
+    if (!collect->vector_test || collect->vector_test(collider, collect->position, collect->ctx)) {
+        collider_collection_add(collect->results, collider);
+    }
+
+    return true;
+}
+
+static bool spatial_hash_collect_rectf(Collider* collider, void* ctx) {
+    SpatialHashCollect* collect = ctx;
+    if (!collect->rectf_test || collect->rectf_test(collider, collect->bounds, collect->ctx)) {
+        collider_collection_add(collect->results, collider);
+    }
+
+    return true;
+}
+
+static bool spatial_hash_collect_collider(Collider* other, void* ctx) {
+    SpatialHashCollect* collect = ctx;
+    if (!collect->collider_test || collect->collider_test(collect->collider, other, collect->ctx)) {
+        collider_collection_add(collect->results, other);
+    }
+
+    return true;
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_collisions_vector(SpatialHash* hash, ColliderCollection* results, Vector position) {
+    return spatial_hash_collisions_vector_ext(hash, results, position, NULL, NULL);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_collisions_vector_ext(SpatialHash* hash, ColliderCollection* results, Vector position, void* ctx, ColliderVectorTest test) {
+    if (hash->tree) {
+        return aabb_tree_collisions_vector_ext(hash->tree, results, position, ctx, test);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
+    SpatialHashCollect collect = { .results = results, .position = position, .ctx = ctx, .vector_test = test };
+    spatial_hash_for_each_vector(hash, position, &collect, spatial_hash_collect_vector);
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_collisions_rectf(SpatialHash* hash, ColliderCollection* results, RectF bounds) {
+    return spatial_hash_collisions_rectf_ext(hash, results, bounds, NULL, NULL);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_collisions_rectf_ext(SpatialHash* hash, ColliderCollection* results, RectF bounds, void* ctx, ColliderRectFTest test) {
+    if (hash->tree) {
+        return aabb_tree_collisions_rectf_ext(hash->tree, results, bounds, ctx, test);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
+    SpatialHashCollect collect = { .results = results, .bounds = bounds, .ctx = ctx, .rectf_test = test };
+    spatial_hash_for_each_rectf(hash, bounds, &collect, spatial_hash_collect_rectf);
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_collisions_collider(SpatialHash* hash, ColliderCollection* results, Collider* collider) {
+    return spatial_hash_collisions_collider_ext(hash, results, collider, NULL, NULL);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_collisions_collider_ext(SpatialHash* hash, ColliderCollection* results, Collider* collider, void* ctx, ColliderColliderTest test) {
+    if (hash->tree) {
+        return aabb_tree_collisions_collider_ext(hash->tree, results, collider, ctx, test);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
+    SpatialHashCollect collect = { .results = results, .collider = collider, .ctx = ctx, .collider_test = test };
+    spatial_hash_for_each_collider(hash, collider, &collect, spatial_hash_collect_collider);
+
+    return results;
+}
+
+SOREN_EXPORT Collider* spatial_hash_first_vector(SpatialHash* hash, Vector position) {
+    if (hash->tree) {
+        return aabb_tree_first_vector(hash->tree, position);
+    }
+
+    Point p = vector_to_cell_point(hash, position);
+    ColliderCollection* set;
+    Collider* collider;
+
+    if (spatial_hash_cell_try_get(hash, p, &set)) {
+        if (set->using_set) {
+            set_iter_start(set->set, collider) {
+                if (collider_contains_point_impl(collider, position)) {
+                    return collider;
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, collider) {
+                if (collider_contains_point_impl(collider, position)) {
+                    return collider;
+                }
+            }
+            list_iter_end
+        }
+    }
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(vector_to_rectf(position), hash)
+
+    if (collider_contains_point_impl(static_collider, position)) {
+        return static_collider;
+    }
+
+    GET_STATIC_END
+
+    return NULL;
+}
+
+SOREN_EXPORT Collider* spatial_hash_first_vector_ext(SpatialHash* hash, Vector position, void* ctx, ColliderVectorTest test) {
+    if (hash->tree) {
+        return aabb_tree_first_vector_ext(hash->tree, position, ctx, test);
+    }
+
+    Point p = vector_to_cell_point(hash, position);
+    ColliderCollection* set;
+    Collider* collider;
+
+    if (spatial_hash_cell_try_get(hash, p, &set)) {
+        if (set->using_set) {
+            set_iter_start(set->set, collider) {
+                if (collider_contains_point_impl(collider, position) && test(collider, position, ctx)) {
+                    return collider;
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, collider) {
+                if (collider_contains_point_impl(collider, position) && test(collider, position, ctx)) {
+                    return collider;
+                }
+            }
+            list_iter_end
+        }
+    }
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(vector_to_rectf(position), hash)
+
+    if (collider_contains_point_impl(static_collider, position) && test(static_collider, position, ctx)) {
+        return static_collider;
+    }
+
+    GET_STATIC_END
+
+    return NULL;
+}
+
+SOREN_EXPORT Collider* spatial_hash_first_rectf(SpatialHash* hash, RectF bounds) {
+    if (hash->tree) {
+        return aabb_tree_first_rectf(hash->tree, bounds);
+    }
+
+    Collider* collider;
+
+    GET_EXISTING_SET_START(bounds, hash)
+
+    if (set->using_set) {
+            set_iter_start(set->set, collider) {
+                if (collider_overlaps(collider, bounds)) {
+                    return collider;
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, collider) {
+                if (collider_overlaps(collider, bounds)) {
+                    return collider;
+                }
+            }
+            list_iter_end
+        }
+
+    GET_EXISTING_SET_END
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(bounds, hash)
+
+    if (collider_overlaps(static_collider, bounds)) {
+        return static_collider;
+    }
+
+    GET_STATIC_END
+
+    return NULL;
+}
+
+SOREN_EXPORT Collider* spatial_hash_first_rectf_ext(SpatialHash* hash, RectF bounds, void* ctx, ColliderRectFTest test) {
+    if (hash->tree) {
+        return aabb_tree_first_rectf_ext(hash->tree, bounds, ctx, test);
+    }
+
+    Collider* collider;
+
+    GET_EXISTING_SET_START(bounds, hash)
+
+    if (set->using_set) {
+            set_iter_start(set->set, collider) {
+                if (collider_overlaps(collider, bounds) && test(collider, bounds, ctx)) {
+                    return collider;
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, collider) {
+                if (collider_overlaps(collider, bounds) && test(collider, bounds, ctx)) {
+                    return collider;
+                }
+            }
+            list_iter_end
+        }
+
+    GET_EXISTING_SET_END
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(bounds, hash)
+
+    if (collider_overlaps(static_collider, bounds) && test(static_collider, bounds, ctx)) {
+        return static_collider;
+    }
+
+    GET_STATIC_END
+
+    return NULL;
+}
+
+SOREN_EXPORT Collider* spatial_hash_first_collider(SpatialHash* hash, Collider* collider) {
+    if (hash->tree) {
+        return aabb_tree_first_collider(hash->tree, collider);
+    }
+
+    Collider* other;
+    RectF bounds = collider_bounds(collider);
+
+    GET_EXISTING_SET_START(bounds, hash)
+
+    if (set->using_set) {
+            set_iter_start(set->set, other) {
+                if (other != collider && collider_should_collide(collider, other) && collider_overlaps(collider, other)) {
+                    return other;
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, other) {
+                if (other != collider && collider_should_collide(collider, other) && collider_overlaps(collider, other)) {
+                    return other;
+                }
+            }
+            list_iter_end
+        }
+
+    GET_EXISTING_SET_END
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(bounds, hash)
+
+    if (static_collider != collider && collider_should_collide(collider, static_collider) && collider_overlaps(collider, static_collider)) {
+        return static_collider;
+    }
+
+    GET_STATIC_END
+
+    return NULL;
+}
+
+SOREN_EXPORT Collider* spatial_hash_first_collider_ext(SpatialHash* hash, Collider* collider, void* ctx, ColliderColliderTest test) {
+    if (hash->tree) {
+        return aabb_tree_first_collider_ext(hash->tree, collider, ctx, test);
+    }
+
+    Collider* other;
+    RectF bounds = collider_bounds(collider);
+
+    GET_EXISTING_SET_START(bounds, hash)
+
+    if (set->using_set) {
+            set_iter_start(set->set, other) {
+                if (other != collider && collider_should_collide(collider, other) && collider_overlaps(collider, other) && test(collider, other, ctx)) {
+                    return other;
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, other) {
+                if (other != collider && collider_should_collide(collider, other) && collider_overlaps(collider, other) && test(collider, other, ctx)) {
+                    return other;
+                }
+            }
+            list_iter_end
+        }
+
+    GET_EXISTING_SET_END
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(bounds, hash)
+
+    if (static_collider != collider && collider_should_collide(collider, static_collider) && collider_overlaps(collider, static_collider) && test(collider, static_collider, ctx)) {
+        return static_collider;
+    }
+
+    GET_STATIC_END
+
+    return NULL;
+}
+
+static int spatial_hash_gather_pair_entries(SpatialHash* hash, ColliderCollection* set) {
+    int count = collider_collection_count(set);
+    if (count > hash->pair_scratch_capacity) {
+        hash->pair_scratch_capacity = count * 2;
+        hash->pair_scratch = soren_realloc(hash->pair_scratch, hash->pair_scratch_capacity * sizeof(*hash->pair_scratch));
+    }
+
+    Collider* collider;
+    int index = 0;
+
+    if (set->using_set) {
+        set_iter_start(set->set, collider) {
+            hash->pair_scratch[index].collider = collider;
+            if (!collider_cell_map_try_get(hash->collider_cells, collider, &hash->pair_scratch[index].range)) {
+                hash->pair_scratch[index].range = spatial_hash_cell_range(hash, collider_bounds(collider));
+            }
+            index++;
+        }
+        set_iter_end
+    } else {
+        list_iter_start(set->list, collider) {
+            hash->pair_scratch[index].collider = collider;
+            if (!collider_cell_map_try_get(hash->collider_cells, collider, &hash->pair_scratch[index].range)) {
+                hash->pair_scratch[index].range = spatial_hash_cell_range(hash, collider_bounds(collider));
+            }
+            index++;
+        }
+        list_iter_end
+    }
+
+    return index;
+}
+
+static void spatial_hash_find_cell_pairs(SpatialHash* hash, Point p, ColliderCollection* set, ColliderPairList* pairs, bool narrowphase) {
+    int static_start = 0;
+    int static_end = 0;
+    spatial_hash_static_cell_try_get(hash, p, &static_start, &static_end);
+
+    if (collider_collection_count(set) < 2 && static_start == static_end) {
+        return;
+    }
+
+    int count = spatial_hash_gather_pair_entries(hash, set);
+
+    for (int i = 0; i < count; i++) {
+        SpatialPairEntry* first = hash->pair_scratch + i;
+
+        for (int j = i + 1; j < count; j++) {
+            SpatialPairEntry* second = hash->pair_scratch + j;
+
+            // Colliders that share more than one cell would be found in each of them.
+            // Only report the pair from the first cell they share.
+            if (SDL_max(first->range.x, second->range.x) != p.x || SDL_max(first->range.y, second->range.y) != p.y) {
+                continue;
+            }
+
+            if (!collider_should_collide(first->collider, second->collider)) {
+                continue;
+            }
+
+            if (narrowphase && !collider_overlaps_collider_impl(first->collider, second->collider)) {
+                continue;
+            }
+
+            collider_pair_list_add(pairs, (ColliderPair){ first->collider, second->collider });
+        }
+
+        // Static colliders are only paired with dynamic ones, never with each other.
+        for (int j = static_start; j < static_end; j++) {
+            int index = hash->static_entries[j];
+            Rect range = hash->static_ranges[index];
+            Collider* other = hash->static_colliders[index];
+
+            if (SDL_max(first->range.x, range.x) != p.x || SDL_max(first->range.y, range.y) != p.y) {
+                continue;
+            }
+
+            if (!collider_should_collide(first->collider, other)) {
+                continue;
+            }
+
+            if (narrowphase && !collider_overlaps_collider_impl(first->collider, other)) {
+                continue;
+            }
+
+            collider_pair_list_add(pairs, (ColliderPair){ first->collider, other });
+        }
+    }
+}
+
+SOREN_EXPORT void spatial_hash_find_pairs(SpatialHash* hash, ColliderPairList* pairs, bool narrowphase) {
+    if (hash->tree) {
+        aabb_tree_find_pairs(hash->tree, pairs, narrowphase);
+        return;
+    }
+
+    spatial_hash_ensure_static_baked(hash);
+
+    Point p;
+    ColliderCollection* set;
+
+    map_iter_start(hash->cells, p, set) {
+        spatial_hash_find_cell_pairs(hash, p, set, pairs, narrowphase);
+    }
+    map_iter_end
+
+    if (hash->grid) {
+        for (int y = 0; y < hash->grid_bounds.h; y++) {
+            for (int x = 0; x < hash->grid_bounds.w; x++) {
+                set = hash->grid[y * hash->grid_bounds.w + x];
+                if (set) {
+                    p.x = x + hash->grid_bounds.x;
+                    p.y = y + hash->grid_bounds.y;
+                    spatial_hash_find_cell_pairs(hash, p, set, pairs, narrowphase);
+                }
+            }
+        }
+    }
+}
+
+static inline void spatial_hash_linecast_test(
+    SpatialHash* hash,
+    Collider* collider,
+    Vector start,
+    Vector end,
+    ColliderCollection* results,
+    Collider** nearest,
+    RaycastHit* nearest_hit,
+    bool concurrent)
+{
+    // Concurrent casts can't stamp the colliders, so colliders that cover several
+    // cells along the segment are tested more than once. The results are the same.
+    if (!concurrent && !spatial_hash_query_visit(hash, collider)) {
+        return;
+    }
+
+    RaycastHit hit = (RaycastHit){0};
+    if (collider_collides_line_impl(collider, start, end, &hit)) {
+        if (results) {
+            collider_collection_add(results, collider);
+        } else if (hit.fraction < nearest_hit->fraction) {
+            *nearest = collider;
+            *nearest_hit = hit;
+        }
+    }
+}
+
+// Tests every collider in the cell against the segment that hasn't already been
+// tested by this cast. If results is set, every collider that's hit is added to it.
+// Otherwise only the nearest hit is kept.
+static void spatial_hash_linecast_cell(
+    SpatialHash* hash,
+    Point p,
+    Vector start,
+    Vector end,
+    ColliderCollection* results,
+    Collider** nearest,
+    RaycastHit* nearest_hit,
+    bool concurrent)
+{
+    ColliderCollection* set;
+    Collider* collider;
+
+    if (spatial_hash_cell_try_get(hash, p, &set)) {
+        if (set->using_set) {
+            set_iter_start(set->set, collider) {
+                spatial_hash_linecast_test(hash, collider, start, end, results, nearest, nearest_hit, concurrent);
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, collider) {
+                spatial_hash_linecast_test(hash, collider, start, end, results, nearest, nearest_hit, concurrent);
+            }
+            list_iter_end
+        }
+    }
+
+    int static_start;
+    int static_end;
+
+    if (spatial_hash_static_cell_try_get(hash, p, &static_start, &static_end)) {
+        for (int i = static_start; i < static_end; i++) {
+            collider = hash->static_colliders[hash->static_entries[i]];
+            spatial_hash_linecast_test(hash, collider, start, end, results, nearest, nearest_hit, concurrent);
+        }
+    }
+}
+
+// Walks the cells along the segment in order using a DDA traversal
+// (Amanatides and Woo, "A Fast Voxel Traversal Algorithm for Ray Tracing").
+// When looking for the nearest hit, the walk stops as soon as the next cell
+// starts further along the segment than the nearest hit found so far.
+static Collider* spatial_hash_linecast_impl(SpatialHash* hash, Vector start, Vector end, ColliderCollection* results, RaycastHit* out_hit, bool concurrent) {
+    Collider* nearest = NULL;
+    RaycastHit nearest_hit = (RaycastHit){ .fraction = FLT_MAX };
+
+    if (concurrent) {
+        soren_assert(!hash->static_dirty);
+    } else {
+        spatial_hash_ensure_static_baked(hash);
+        spatial_hash_begin_query(hash);
+    }
+
+    Vector delta = vector_subtract(end, start);
+    float cell_size = 1.f / hash->inverse_cell_size;
+
+    Point cell = vector_to_cell_point(hash, start);
+    Point last = vector_to_cell_point(hash, end);
+
+    int step_x = delta.x > 0 ? 1 : (delta.x < 0 ? -1 : 0);
+    int step_y = delta.y > 0 ? 1 : (delta.y < 0 ? -1 : 0);
+
+    // How far along the segment (from 0 to 1) one cell is on each axis.
+    float t_delta_x = step_x != 0 ? cell_size / SDL_fabsf(delta.x) : FLT_MAX;
+    float t_delta_y = step_y != 0 ? cell_size / SDL_fabsf(delta.y) : FLT_MAX;
+
+    // How far along the segment the next cell boundary is on each axis.
+    float t_max_x = step_x != 0 ? ((cell.x + (step_x > 0)) * cell_size - start.x) / delta.x : FLT_MAX;
+    float t_max_y = step_y != 0 ? ((cell.y + (step_y > 0)) * cell_size - start.y) / delta.y : FLT_MAX;
+
+    while (true) {
+        spatial_hash_linecast_cell(hash, cell, start, end, results, &nearest, &nearest_hit, concurrent);
+
+        if (cell.x == last.x && cell.y == last.y) {
+            break;
+        }
+
+        float t_next = SDL_min(t_max_x, t_max_y);
+        if (t_next > 1 || (!results && nearest_hit.fraction <= t_next)) {
+            break;
+        }
+
+        if (t_max_x < t_max_y) {
+            cell.x += step_x;
+            t_max_x += t_delta_x;
+        } else {
+            cell.y += step_y;
+            t_max_y += t_delta_y;
+        }
+    }
+
+    if (!concurrent) {
+        spatial_hash_end_query(hash);
+    }
+
+    if (nearest && out_hit) {
+        *out_hit = nearest_hit;
+    }
+
+    return nearest;
+}
+
+SOREN_EXPORT Collider* spatial_hash_raycast(SpatialHash* hash, Vector origin, Vector direction, float distance, RaycastHit* out_hit) {
+    Vector end = vector_add(origin, vector_multiply_scalar(vector_normalize(direction), distance));
+    return spatial_hash_linecast_first(hash, origin, end, out_hit);
+}
+
+SOREN_EXPORT Collider* spatial_hash_linecast_first(SpatialHash* hash, Vector start, Vector end, RaycastHit* out_hit) {
+    if (hash->tree) {
+        return aabb_tree_linecast_first(hash->tree, start, end, out_hit);
+    }
+
+    if (vector_equals(start, end)) {
+        return NULL;
+    }
+
+    return spatial_hash_linecast_impl(hash, start, end, NULL, out_hit, false);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_hash_linecast_all(SpatialHash* hash, ColliderCollection* results, Vector start, Vector end) {
+    if (hash->tree) {
+        return aabb_tree_linecast_all(hash->tree, results, start, end);
+    }
+
+    if (!results) {
+        collider_collection_clear(hash->cache);
+        results = hash->cache;
+    }
+
+    if (vector_equals(start, end)) {
+        return results;
+    }
+
+    spatial_hash_linecast_impl(hash, start, end, results, NULL, false);
+    return results;
+}
+
+static inline RectF spatial_hash_swept_bounds(Collider* collider, Vector delta) {
+    RectF bounds = collider_bounds(collider);
+
+    if (delta.x < 0) {
+        bounds.x += delta.x;
+    }
+
+    if (delta.y < 0) {
+        bounds.y += delta.y;
+    }
+
+    bounds.w += SDL_fabsf(delta.x);
+    bounds.h += SDL_fabsf(delta.y);
+
+    return bounds;
+}
+
+SOREN_EXPORT Collider* spatial_hash_cast_collider(SpatialHash* hash, Collider* collider, Vector delta, RaycastHit* out_hit) {
+    if (hash->tree) {
+        return aabb_tree_cast_collider(hash->tree, collider, delta, out_hit);
+    }
+
+    Collider* nearest = NULL;
+    RaycastHit nearest_hit = (RaycastHit){ .fraction = FLT_MAX };
+    RaycastHit hit;
+    Collider* other;
+    RectF bounds = spatial_hash_swept_bounds(collider, delta);
+
+    spatial_hash_begin_query(hash);
+
+    GET_EXISTING_SET_START(bounds, hash)
+
+    if (set->using_set) {
+        set_iter_start(set->set, other) {
+            if (other != collider
+                && collider_should_collide(collider, other)
+                && spatial_hash_query_visit(hash, other)
+                && collision_cast_collider(collider, delta, other, &hit)
+                && hit.fraction < nearest_hit.fraction)
+            {
+                nearest = other;
+                nearest_hit = hit;
+            }
+        }
+        set_iter_end
+    } else {
+        list_iter_start(set->list, other) {
+            if (other != collider
+                && collider_should_collide(collider, other)
+                && spatial_hash_query_visit(hash, other)
+                && collision_cast_collider(collider, delta, other, &hit)
+                && hit.fraction < nearest_hit.fraction)
+            {
+                nearest = other;
+                nearest_hit = hit;
+            }
+        }
+        list_iter_end
+    }
+
+    GET_EXISTING_SET_END
+
+    spatial_hash_ensure_static_baked(hash);
+
+    GET_STATIC_START(bounds, hash)
+
+    if (collider_should_collide(collider, static_collider)
+        && spatial_hash_query_visit(hash, static_collider)
+        && collision_cast_collider(collider, delta, static_collider, &hit)
+        && hit.fraction < nearest_hit.fraction)
+    {
+        nearest = static_collider;
+        nearest_hit = hit;
+    }
+
+    GET_STATIC_END
+
+    spatial_hash_end_query(hash);
+
+    if (nearest && out_hit) {
+        *out_hit = nearest_hit;
+    }
+
+    return nearest;
+}
+
+// Concurrent queries can't stamp the colliders, but the nearest colliders are kept in a
+// short list that can be checked for duplicates instead.
+static inline bool spatial_hash_nearest_visit_once(SpatialHash* hash, NearestColliders* nearest, Collider* collider, bool concurrent) {
+    return concurrent ? !nearest_colliders_contains(nearest, collider) : spatial_hash_query_visit(hash, collider);
+}
+
+static void spatial_hash_nearest_visit_cell(
+    SpatialHash* hash,
+    Point p,
+    Vector point,
+    NearestColliders* nearest,
+    void* ctx,
+    ColliderPredicate predicate,
+    bool concurrent)
+{
+    ColliderCollection* set;
+    Collider* collider;
+
+    if (spatial_hash_cell_try_get(hash, p, &set)) {
+        if (set->using_set) {
+            set_iter_start(set->set, collider) {
+                if (spatial_hash_nearest_visit_once(hash, nearest, collider, concurrent) && (!predicate || predicate(collider, ctx))) {
+                    nearest_colliders_add(nearest, collider, collider_point_distance(collider, point));
+                }
+            }
+            set_iter_end
+        } else {
+            list_iter_start(set->list, collider) {
+                if (spatial_hash_nearest_visit_once(hash, nearest, collider, concurrent) && (!predicate || predicate(collider, ctx))) {
+                    nearest_colliders_add(nearest, collider, collider_point_distance(collider, point));
+                }
+            }
+            list_iter_end
+        }
+    }
+
+    int static_start;
+    int static_end;
+
+    if (spatial_hash_static_cell_try_get(hash, p, &static_start, &static_end)) {
+        for (int i = static_start; i < static_end; i++) {
+            collider = hash->static_colliders[hash->static_entries[i]];
+            if (spatial_hash_nearest_visit_once(hash, nearest, collider, concurrent) && (!predicate || predicate(collider, ctx))) {
+                nearest_colliders_add(nearest, collider, collider_point_distance(collider, point));
+            }
+        }
+    }
+}
+
+// Searches the cells in square rings of increasing size around the point. Every cell in
+// a ring is at least as far away as the inner edge of the ring, so the search stops once
+// that's further than the furthest collider that's been kept.
+static void spatial_hash_nearest_impl(SpatialHash* hash, Vector point, NearestColliders* nearest, void* ctx, ColliderPredicate predicate, bool concurrent) {
+    if (concurrent) {
+        soren_assert(!hash->static_dirty);
+    } else {
+        spatial_hash_ensure_static_baked(hash);
+        spatial_hash_begin_query(hash);
+    }
+
+    float cell_size = 1.f / hash->inverse_cell_size;
+    Point center = vector_to_cell_point(hash, point);
+
+    // Rings past the occupied cells are empty, so there's no need to search them no matter
+    // how large max_distance is. Checking this first also keeps huge distances, such as
+    // FLT_MAX, from overflowing the conversion to cells.
+    int occupied_ring = 0;
+    if (hash->occupied_min.x <= hash->occupied_max.x) {
+        occupied_ring = SDL_max(
+            SDL_max(center.x - hash->occupied_min.x, hash->occupied_max.x - center.x),
+            SDL_max(center.y - hash->occupied_min.y, hash->occupied_max.y - center.y));
+        occupied_ring = SDL_max(0, occupied_ring);
+    }
+
+    float distance_ring = nearest->max_distance * hash->inverse_cell_size;
+    int max_ring = distance_ring < occupied_ring ? fast_floor(SDL_max(0, distance_ring)) + 1 : occupied_ring;
+
+    spatial_hash_nearest_visit_cell(hash, center, point, nearest, ctx, predicate, concurrent);
+
+    for (int ring = 1; ring <= max_ring; ring++) {
+        float left = point.x - (center.x - ring + 1) * cell_size;
+        float right = (center.x + ring) * cell_size - point.x;
+        float top = point.y - (center.y - ring + 1) * cell_size;
+        float bottom = (center.y + ring) * cell_size - point.y;
+        float ring_distance = SDL_min(SDL_min(left, right), SDL_min(top, bottom));
+
+        if (ring_distance > nearest_colliders_threshold(nearest)) {
+            break;
+        }
+
+        for (int x = center.x - ring; x <= center.x + ring; x++) {
+            spatial_hash_nearest_visit_cell(hash, (Point){ x, center.y - ring }, point, nearest, ctx, predicate, concurrent);
+            spatial_hash_nearest_visit_cell(hash, (Point){ x, center.y + ring }, point, nearest, ctx, predicate, concurrent);
+        }
+
+        for (int y = center.y - ring + 1; y < center.y + ring; y++) {
+            spatial_hash_nearest_visit_cell(hash, (Point){ center.x - ring, y }, point, nearest, ctx, predicate, concurrent);
+            spatial_hash_nearest_visit_cell(hash, (Point){ center.x + ring, y }, point, nearest, ctx, predicate, concurrent);
+        }
+    }
+
+    if (!concurrent) {
+        spatial_hash_end_query(hash);
+    }
+}
+
+SOREN_EXPORT Collider* spatial_hash_nearest(SpatialHash* hash, Vector point, float max_distance, void* ctx, ColliderPredicate predicate) {
+    Collider* result = NULL;
+    spatial_hash_k_nearest(hash, point, max_distance, 1, &result, NULL, ctx, predicate);
+    return result;
+}
+
+SOREN_EXPORT int spatial_hash_k_nearest(
+    SpatialHash* hash,
+    Vector point,
+    float max_distance,
+    int k,
+    Collider** out_colliders,
+    float* out_distances,
+    void* ctx,
+    ColliderPredicate predicate)
+{
+    if (hash->tree) {
+        return aabb_tree_k_nearest(hash->tree, point, max_distance, k, out_colliders, out_distances, ctx, predicate);
+    }
+
+    if (k <= 0) {
+        return 0;
+    }
+
+    if (!out_distances) {
+        if (k > hash->nearest_scratch_capacity) {
+            hash->nearest_scratch_capacity = k;
+            hash->nearest_scratch = soren_realloc(hash->nearest_scratch, k * sizeof(*hash->nearest_scratch));
+        }
+
+        out_distances = hash->nearest_scratch;
+    }
+
+    NearestColliders nearest = {
+        .colliders = out_colliders,
+        .distances = out_distances,
+        .capacity = k,
+        .count = 0,
+        .max_distance = max_distance
+    };
+
+    spatial_hash_nearest_impl(hash, point, &nearest, ctx, predicate, false);
+    return nearest.count;
+}
+
+static void spatial_hash_stats_cell(SpatialHash* hash, ColliderCollection* set, SpatialHashStats* stats, int64_t* candidates, int64_t* misses) {
+    int count = spatial_hash_gather_pair_entries(hash, set);
+    if (count == 0) {
+        return;
+    }
+
+    stats->occupied_cells++;
+    stats->histogram[SDL_min(count, SPATIAL_HASH_STATS_HISTOGRAM_SIZE) - 1]++;
+    stats->max_colliders_per_cell = SDL_max(stats->max_colliders_per_cell, count);
+
+    for (int i = 0; i < count; i++) {
+        RectF bounds = collider_bounds(hash->pair_scratch[i].collider);
+        for (int j = i + 1; j < count; j++) {
+            (*candidates)++;
+            if (!rectf_intersects(bounds, collider_bounds(hash->pair_scratch[j].collider))) {
+                (*misses)++;
+            }
+        }
+    }
+}
+
+SOREN_EXPORT void spatial_hash_stats(SpatialHash* hash, SpatialHashStats* out_stats) {
+    SDL_zerop(out_stats);
+
+    if (hash->tree) {
+        out_stats->colliders_count = aabb_tree_count(hash->tree);
+        return;
+    }
+
+    spatial_hash_ensure_static_baked(hash);
+
+    out_stats->cell_size = 1.f / hash->inverse_cell_size;
+    out_stats->colliders_count = collider_cell_map_count(hash->collider_cells);
+    out_stats->static_colliders_count = hash->static_count;
+    out_stats->static_cells_count = hash->static_cells_count;
+
+    int64_t candidates = 0;
+    int64_t misses = 0;
+    int64_t cell_entries = 0;
+    ColliderCollection* set;
+    Rect range;
+
+    map_iter_value_start(hash->cells, set) {
+        spatial_hash_stats_cell(hash, set, out_stats, &candidates, &misses);
+    }
+    map_iter_end
+
+    if (hash->grid) {
+        for (int i = 0; i < hash->grid_bounds.w * hash->grid_bounds.h; i++) {
+            if (hash->grid[i]) {
+                spatial_hash_stats_cell(hash, hash->grid[i], out_stats, &candidates, &misses);
+            }
+        }
+    }
+
+    map_iter_value_start(hash->collider_cells, range) {
+        cell_entries += range.w * range.h;
+    }
+    map_iter_end
+
+    if (out_stats->occupied_cells > 0) {
+        out_stats->average_colliders_per_cell = (float)cell_entries / out_stats->occupied_cells;
+    }
+
+    if (out_stats->colliders_count > 0) {
+        out_stats->average_cells_per_collider = (float)cell_entries / out_stats->colliders_count;
+    }
+
+    if (candidates > 0) {
+        out_stats->false_positive_rate = (float)misses / candidates;
+    }
+}
+
+#define SPATIAL_HASH_CELL_SIZE_CANDIDATES 32
+
+// Estimates the cost of a cell size as the number of cell entries visited if every
+// collider queried its own bounds. Each collider covers (w / s + 1) * (h / s + 1)
+// cells on average, and each of those cells holds the total number of entries spread
+// evenly over the area covered by all of the colliders. Small cells make colliders
+// cover more cells, while large cells put more colliders in each one.
+static float spatial_hash_cell_size_cost(RectF* bounds, int count, float world_area, float cell_size) {
+    float entries = 0;
+    for (int i = 0; i < count; i++) {
+        entries += (bounds[i].w / cell_size + 1) * (bounds[i].h / cell_size + 1);
+    }
+
+    float cells = SDL_max(1.f, world_area / (cell_size * cell_size));
+    return entries * SDL_max(1.f, entries / cells);
+}
+
+SOREN_EXPORT float spatial_hash_suggest_cell_size(SpatialHash* hash) {
+    if (hash->tree) {
+        return 0;
+    }
+
+    int count = collider_cell_map_count(hash->collider_cells) + hash->static_count;
+    if (count == 0) {
+        return 1.f / hash->inverse_cell_size;
+    }
+
+    RectF* bounds = soren_malloc(count * sizeof(*bounds));
+    Collider* collider;
+    int index = 0;
+
+    map_iter_key_start(hash->collider_cells, collider) {
+        bounds[index++] = collider_bounds(collider);
+    }
+    map_iter_end
+
+    for (int i = 0; i < hash->static_count; i++) {
+        bounds[index++] = collider_bounds(hash->static_colliders[i]);
+    }
+
+    float min_size = FLT_MAX;
+    float max_size = 0;
+    float left = FLT_MAX;
+    float top = FLT_MAX;
+    float right = -FLT_MAX;
+    float bottom = -FLT_MAX;
+
+    for (int i = 0; i < count; i++) {
+        float size = SDL_max(bounds[i].w, bounds[i].h);
+        min_size = SDL_min(min_size, size);
+        max_size = SDL_max(max_size, size);
+        left = SDL_min(left, rectf_left(bounds[i]));
+        top = SDL_min(top, rectf_top(bounds[i]));
+        right = SDL_max(right, rectf_right(bounds[i]));
+        bottom = SDL_max(bottom, rectf_bottom(bounds[i]));
+    }
+
+    // Try sizes spread evenly on a log scale from half the smallest collider
+    // to twice the largest.
+    float low = SDL_max(min_size * 0.5f, 1.f);
+    float high = SDL_max(max_size * 2, low);
+    float step = SDL_powf(high / low, 1.f / (SPATIAL_HASH_CELL_SIZE_CANDIDATES - 1));
+    float world_area = SDL_max(1.f, (right - left) * (bottom - top));
+
+    float best_size = low;
+    float best_cost = FLT_MAX;
+    float cell_size = low;
+
+    for (int i = 0; i < SPATIAL_HASH_CELL_SIZE_CANDIDATES; i++) {
+        float cost = spatial_hash_cell_size_cost(bounds, count, world_area, cell_size);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_size = cell_size;
+        }
+
+        cell_size *= step;
+    }
+
+    soren_free(bounds);
+
+    return best_size;
+}
+
+SOREN_EXPORT void spatial_hash_rebuild(SpatialHash* hash, float cell_size) {
+    if (hash->tree) {
+        return;
+    }
+
+    if (cell_size <= 0) {
+        cell_size = spatial_hash_suggest_cell_size(hash);
+    }
+
+    int count = collider_cell_map_count(hash->collider_cells);
+    Collider** colliders = soren_malloc(SDL_max(1, count) * sizeof(*colliders));
+    Collider* collider;
+    int index = 0;
+
+    map_iter_key_start(hash->collider_cells, collider) {
+        colliders[index++] = collider;
+    }
+    map_iter_end
+
+    spatial_hash_clear(hash);
+
+    // Keep the bounded grid covering the same area of the world.
+    if (hash->grid) {
+        float old_cell_size = 1.f / hash->inverse_cell_size;
+        RectF world = (RectF){
+            hash->grid_bounds.x * old_cell_size,
+            hash->grid_bounds.y * old_cell_size,
+            hash->grid_bounds.w * old_cell_size,
+            hash->grid_bounds.h * old_cell_size
+        };
+
+        hash->inverse_cell_size = 1.f / cell_size;
+        hash->grid_bounds = spatial_hash_cell_range(hash, world);
+
+        soren_free(hash->grid);
+        hash->grid = soren_calloc(hash->grid_bounds.w * hash->grid_bounds.h, sizeof(*hash->grid));
+    } else {
+        hash->inverse_cell_size = 1.f / cell_size;
+    }
+
+    spatial_hash_static_detach(hash);
+
+    for (int i = 0; i < hash->static_count; i++) {
+        hash->static_ranges[i] = spatial_hash_cell_range(hash, collider_bounds(hash->static_colliders[i]));
+    }
+
+    // The occupied cells were measured with the old cell size.
+    spatial_hash_reset_occupied(hash);
+
+    for (int i = 0; i < count; i++) {
+        spatial_hash_add(hash, colliders[i]);
+    }
+
+    // The baked cells depend on the cell size, so rebuild them here rather than
+    // leaving the hash unqueryable until the next explicit bake.
+    spatial_hash_bake_static_impl(hash);
+
+    soren_free(colliders);
+}
+
+SOREN_EXPORT int spatial_hash_static_count(SpatialHash* hash) {
+    return hash->tree ? 0 : hash->static_count;
+}
+
+SOREN_EXPORT Collider* spatial_hash_static_get(SpatialHash* hash, int index) {
+    soren_assert(!hash->tree && index >= 0 && index < hash->static_count);
+    return hash->static_colliders[index];
+}
+
+// The layout of a baked static tier. Every offset is in bytes from the start of the blob,
+// and every section is aligned to 8 bytes. The colliders are stored as copies of their
+// structs, with each pointer replaced by the offset of the data it pointed to.
+typedef struct SpatialHashStaticHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pointer_size;
+    float cell_size;
+    int32_t colliders_count;
+    int32_t cells_count;
+    int32_t entries_count;
+    uint64_t size;
+    uint64_t colliders;
+    uint64_t ranges;
+    uint64_t cells;
+    uint64_t offsets;
+    uint64_t entries;
+} SpatialHashStaticHeader;
+
+#define SPATIAL_HASH_STATIC_MAGIC 0x48535253 // SRSH
+#define SPATIAL_HASH_STATIC_VERSION 2
+
+#define SPATIAL_HASH_BLOB_OFFSET(offset) ((void*)(uintptr_t)(offset))
+#define SPATIAL_HASH_BLOB_POINTER(blob, pointer) ((void*)((blob) + (uintptr_t)(pointer)))
+
+// Appends the data to the blob and returns its offset. When blob is NULL,
+// only the size is updated so the same code can measure and fill the blob.
+static uint64_t spatial_hash_blob_write(uint8_t* blob, size_t* size, const void* data, size_t bytes) {
+    size_t offset = (*size + 7) & ~(size_t)7;
+    if (blob && bytes > 0) {
+        SDL_memcpy(blob + offset, data, bytes);
+    }
+
+    *size = offset + bytes;
+    return offset;
+}
+
+static uint64_t spatial_hash_blob_write_collider(uint8_t* blob, size_t* size, Collider* collider) {
+    uint64_t offset;
+
+    // Makes sure the cached bounds and the polygon points are current before they're copied.
+    collider_bounds(collider);
+
+    switch (collider->collider_type) {
+        case COLLIDER_POINT:
+            PointCollider* point = (PointCollider*)collider;
+            offset = spatial_hash_blob_write(blob, size, point, sizeof(*point));
+            if (point->box) {
+                uint64_t box = spatial_hash_blob_write_collider(blob, size, (Collider*)point->box);
+                if (blob) {
+                    ((PointCollider*)(blob + offset))->box = SPATIAL_HASH_BLOB_OFFSET(box);
+                }
+            }
+            break;
+        case COLLIDER_LINE:
+            offset = spatial_hash_blob_write(blob, size, collider, sizeof(LineCollider));
+            break;
+        case COLLIDER_CIRCLE:
+            offset = spatial_hash_blob_write(blob, size, collider, sizeof(CircleCollider));
+            break;
+        case COLLIDER_CAPSULE:
+            offset = spatial_hash_blob_write(blob, size, collider, sizeof(CapsuleCollider));
+            break;
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            PolygonCollider* polygon = (PolygonCollider*)collider;
+            size_t vectors = polygon->points_count * sizeof(Vector);
+
+            // Build the axes now so loaded colliders don't need to.
+            polygon_collider_axes(polygon, NULL);
+
+            offset = spatial_hash_blob_write(
+                blob,
+                size,
+                polygon,
+                collider->collider_type == COLLIDER_BOX ? sizeof(BoxCollider) : sizeof(PolygonCollider));
+
+            uint64_t edge_normals = spatial_hash_blob_write(blob, size, polygon->edge_normals, vectors);
+            uint64_t points = spatial_hash_blob_write(blob, size, polygon->points, vectors);
+            uint64_t original_points = spatial_hash_blob_write(blob, size, polygon->original_points, vectors);
+            uint64_t axes = spatial_hash_blob_write(blob, size, polygon->axes, vectors);
+            uint64_t original_axes = spatial_hash_blob_write(blob, size, polygon->original_axes, vectors);
+
+            if (blob) {
+                PolygonCollider* copy = (PolygonCollider*)(blob + offset);
+                copy->edge_normals = SPATIAL_HASH_BLOB_OFFSET(edge_normals);
+                copy->points = SPATIAL_HASH_BLOB_OFFSET(points);
+                copy->original_points = SPATIAL_HASH_BLOB_OFFSET(original_points);
+                copy->axes = SPATIAL_HASH_BLOB_OFFSET(axes);
+                copy->original_axes = SPATIAL_HASH_BLOB_OFFSET(original_axes);
+            }
+            break;
+        default:
+            throw(InvalidColliderType, "Invalid collider type");
+            break;
+    }
+
+    if (blob) {
+        // Tags can't be stored, so they're left for the game to fill in by id.
+        Collider* copy = (Collider*)(blob + offset);
+        copy->tag = NULL;
+        copy->query_epoch = 0;
+    }
+
+    return offset;
+}
+
+// Checks that count elements of the given size starting at offset fit inside the blob.
+// The offsets come from the file, so the checks are written to avoid overflowing.
+static bool spatial_hash_blob_contains(size_t size, uint64_t offset, uint64_t count, size_t element_size) {
+    if (offset > size || (offset & 7) != 0) {
+        return false;
+    }
+
+    return count <= (size - offset) / element_size;
+}
+
+// Turns the offsets stored in a collider back into pointers. Returns false if the
+// collider or any of the data it points to lies outside of the blob.
+static bool spatial_hash_blob_fix_collider(uint8_t* blob, size_t size, uint64_t offset, bool internal) {
+    if (!spatial_hash_blob_contains(size, offset, 1, sizeof(Collider))) {
+        return false;
+    }
+
+    Collider* collider = (Collider*)(blob + offset);
+
+    switch (collider->collider_type) {
+        case COLLIDER_POINT:
+            if (internal || !spatial_hash_blob_contains(size, offset, 1, sizeof(PointCollider))) {
+                return false;
+            }
+
+            PointCollider* point = (PointCollider*)collider;
+            if (point->box) {
+                uint64_t box = (uintptr_t)point->box;
+
+                // The internal collider of a point is always a box, which also
+                // keeps a corrupt blob from making points reference each other.
+                if (!spatial_hash_blob_fix_collider(blob, size, box, true)
+                    || ((Collider*)(blob + box))->collider_type != COLLIDER_BOX)
+                {
+                    return false;
+                }
+
+                point->box = SPATIAL_HASH_BLOB_POINTER(blob, box);
+            }
+            return true;
+        case COLLIDER_LINE:
+            return !internal && spatial_hash_blob_contains(size, offset, 1, sizeof(LineCollider));
+        case COLLIDER_CIRCLE:
+            return !internal && spatial_hash_blob_contains(size, offset, 1, sizeof(CircleCollider));
+        case COLLIDER_CAPSULE:
+            return !internal && spatial_hash_blob_contains(size, offset, 1, sizeof(CapsuleCollider));
+        case COLLIDER_BOX:
+        case COLLIDER_POLYGON:
+            size_t polygon_size = collider->collider_type == COLLIDER_BOX ? sizeof(BoxCollider) : sizeof(PolygonCollider);
+            if (!spatial_hash_blob_contains(size, offset, 1, polygon_size)) {
+                return false;
+            }
+
+            PolygonCollider* polygon = (PolygonCollider*)collider;
+            if (polygon->points_count < 0) {
+                return false;
+            }
+
+            uint64_t count = polygon->points_count;
+            if (!spatial_hash_blob_contains(size, (uintptr_t)polygon->edge_normals, count, sizeof(Vector))
+                || !spatial_hash_blob_contains(size, (uintptr_t)polygon->points, count, sizeof(Vector))
+                || !spatial_hash_blob_contains(size, (uintptr_t)polygon->original_points, count, sizeof(Vector))
+                || !spatial_hash_blob_contains(size, (uintptr_t)polygon->axes, count, sizeof(Vector))
+                || !spatial_hash_blob_contains(size, (uintptr_t)polygon->original_axes, count, sizeof(Vector)))
+            {
+                return false;
+            }
+
+            polygon->edge_normals = SPATIAL_HASH_BLOB_POINTER(blob, polygon->edge_normals);
+            polygon->points = SPATIAL_HASH_BLOB_POINTER(blob, polygon->points);
+            polygon->original_points = SPATIAL_HASH_BLOB_POINTER(blob, polygon->original_points);
+            polygon->axes = SPATIAL_HASH_BLOB_POINTER(blob, polygon->axes);
+            polygon->original_axes = SPATIAL_HASH_BLOB_POINTER(blob, polygon->original_axes);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Checks every section of the blob against its size before anything in it is dereferenced,
+// then turns the collider offsets into pointers.
+static bool spatial_hash_blob_validate(uint8_t* blob, size_t size) {
+    SpatialHashStaticHeader* header = (SpatialHashStaticHeader*)blob;
+
+    if (size < sizeof(*header)
+        || header->magic != SPATIAL_HASH_STATIC_MAGIC
+        || header->version != SPATIAL_HASH_STATIC_VERSION
+        || header->pointer_size != sizeof(void*)
+        || header->size != size
+        || !(header->cell_size > 0)
+        || header->colliders_count < 0
+        || header->cells_count < 0
+        || header->entries_count < 0)
+    {
+        return false;
+    }
+
+    uint64_t offsets_count = header->cells_count > 0 ? (uint64_t)header->cells_count + 1 : 0;
+
+    if (!spatial_hash_blob_contains(size, header->colliders, header->colliders_count, sizeof(Collider*))
+        || !spatial_hash_blob_contains(size, header->ranges, header->colliders_count, sizeof(Rect))
+        || !spatial_hash_blob_contains(size, header->cells, header->cells_count, sizeof(Point))
+        || !spatial_hash_blob_contains(size, header->offsets, offsets_count, sizeof(int))
+        || !spatial_hash_blob_contains(size, header->entries, header->entries_count, sizeof(int)))
+    {
+        return false;
+    }
+
+    // The queries index the entries through the offsets and the colliders through the
+    // entries, so both have to stay in range.
+    int* offsets = (int*)(blob + header->offsets);
+    for (uint64_t i = 0; i < offsets_count; i++) {
+        if (offsets[i] < (i == 0 ? 0 : offsets[i - 1]) || offsets[i] > header->entries_count) {
+            return false;
+        }
+    }
+
+    if (offsets_count > 0 && offsets[header->cells_count] != header->entries_count) {
+        return false;
+    }
+
+    int* entries = (int*)(blob + header->entries);
+    for (int i = 0; i < header->entries_count; i++) {
+        if (entries[i] < 0 || entries[i] >= header->colliders_count) {
+            return false;
+        }
+    }
+
+    Collider** colliders = (Collider**)(blob + header->colliders);
+    for (int i = 0; i < header->colliders_count; i++) {
+        uint64_t offset = (uintptr_t)colliders[i];
+        if (!spatial_hash_blob_fix_collider(blob, size, offset, false)) {
+            return false;
+        }
+
+        colliders[i] = SPATIAL_HASH_BLOB_POINTER(blob, offset);
+    }
+
+    return true;
+}
+
+SOREN_EXPORT void* spatial_hash_write_static(SpatialHash* hash, size_t* out_size) {
+    if (hash->tree) {
+        throw(IllegalArgumentException, "Hashes backed by a dynamic tree don't have a static tier");
+    }
+
+    spatial_hash_ensure_static_baked(hash);
+
+    int cells_count = hash->static_cells_count;
+    int entries_count = cells_count > 0 ? hash->static_offsets[cells_count] : 0;
+
+    uint8_t* blob = NULL;
+    size_t size = 0;
+
+    // The first pass measures the blob, and the second fills it in.
+    for (int pass = 0; pass < 2; pass++) {
+        SpatialHashStaticHeader header = {
+            .magic = SPATIAL_HASH_STATIC_MAGIC,
+            .version = SPATIAL_HASH_STATIC_VERSION,
+            .pointer_size = sizeof(void*),
+            .cell_size = 1.f / hash->inverse_cell_size,
+            .colliders_count = hash->static_count,
+            .cells_count = cells_count,
+            .entries_count = entries_count
+        };
+
+        size = sizeof(header);
+        header.colliders = spatial_hash_blob_write(blob, &size, hash->static_colliders, hash->static_count * sizeof(Collider*));
+        header.ranges = spatial_hash_blob_write(blob, &size, hash->static_ranges, hash->static_count * sizeof(Rect));
+        header.cells = spatial_hash_blob_write(blob, &size, hash->static_cells, cells_count * sizeof(Point));
+        header.offsets = spatial_hash_blob_write(blob, &size, hash->static_offsets, (cells_count > 0 ? cells_count + 1 : 0) * sizeof(int));
+        header.entries = spatial_hash_blob_write(blob, &size, hash->static_entries, entries_count * sizeof(int));
+
+        for (int i = 0; i < hash->static_count; i++) {
+            uint64_t offset = spatial_hash_blob_write_collider(blob, &size, hash->static_colliders[i]);
+            if (blob) {
+                ((Collider**)(blob + header.colliders))[i] = SPATIAL_HASH_BLOB_OFFSET(offset);
+            }
+        }
+
+        header.size = size;
+
+        if (blob) {
+            SDL_memcpy(blob, &header, sizeof(header));
+        } else {
+            blob = soren_calloc(1, size);
+        }
+    }
+
+    *out_size = size;
+    return blob;
+}
+
+SOREN_EXPORT void spatial_hash_save_static(SpatialHash* hash, const char* file) {
+    size_t size;
+    void* blob = spatial_hash_write_static(hash, &size);
+    bool saved = SDL_SaveFile(file, blob, size);
+    soren_free(blob);
+
+    SOREN_SDL_ASSERT(saved);
+}
+
+// Takes ownership of the blob.
+static SpatialHash* spatial_hash_load_static_impl(uint8_t* blob, size_t size) {
+    if (!spatial_hash_blob_validate(blob, size)) {
+        soren_free(blob);
+        throw(IllegalArgumentException, "Invalid baked spatial hash");
+    }
+
+    SpatialHashStaticHeader* header = (SpatialHashStaticHeader*)blob;
+
+    SpatialHash* hash = spatial_hash_create(header->cell_size);
+    hash->static_blob = blob;
+    hash->static_borrowed = true;
+    hash->static_colliders = (Collider**)(blob + header->colliders);
+    hash->static_ranges = (Rect*)(blob + header->ranges);
+    hash->static_cells = (Point*)(blob + header->cells);
+    hash->static_offsets = (int*)(blob + header->offsets);
+    hash->static_entries = (int*)(blob + header->entries);
+    hash->static_count = header->colliders_count;
+    hash->static_capacity = header->colliders_count;
+    hash->static_cells_count = header->cells_count;
+    hash->static_dirty = false;
+    spatial_hash_reset_occupied(hash);
+
+    return hash;
+}
+
+SOREN_EXPORT SpatialHash* spatial_hash_load_static(const char* file) {
+    SDL_IOStream* stream = SDL_IOFromFile(file, "rb");
+    SOREN_SDL_ASSERT(stream);
+
+    Sint64 size = SDL_GetIOSize(stream);
+    if (size < 0) {
+        SDL_CloseIO(stream);
+        throw(SdlException, SDL_GetError());
+    }
+
+    // The blob is read straight into the allocation that the hash keeps,
+    // so loading only needs the one allocation for every collider.
+    uint8_t* blob = soren_malloc(SDL_max(1, size));
+    size_t read = SDL_ReadIO(stream, blob, size);
+    SDL_CloseIO(stream);
+
+    if (read != (size_t)size) {
+        soren_free(blob);
+        throw(SdlException, SDL_GetError());
+    }
+
+    return spatial_hash_load_static_impl(blob, size);
+}
+
+SOREN_EXPORT SpatialHash* spatial_hash_load_static_from_memory(const void* data, size_t size) {
+    uint8_t* blob = soren_malloc(SDL_max(1, size));
+    SDL_memcpy(blob, data, size);
+
+    return spatial_hash_load_static_impl(blob, size);
+}
+
+SOREN_EXPORT SpatialQueryContext* spatial_query_context_create(void) {
+    SpatialQueryContext* query = soren_malloc(sizeof(*query));
+    query->cache = collider_collection_create();
+    query->nearest_scratch = NULL;
+    query->nearest_scratch_capacity = 0;
+
+    return query;
+}
+
+SOREN_EXPORT void spatial_query_context_free(SpatialQueryContext* query) {
+    collider_collection_free(query->cache);
+    soren_free(query->nearest_scratch);
+    soren_free(query);
+}
+
+static inline ColliderCollection* spatial_query_results(SpatialQueryContext* query, ColliderCollection* results) {
+    if (!results) {
+        collider_collection_clear(query->cache);
+        results = query->cache;
+    }
+
+    return results;
+}
+
+SOREN_EXPORT void spatial_hash_prepare_queries(SpatialHash* hash) {
+    if (!hash->tree && hash->static_dirty) {
+        spatial_hash_bake_static_impl(hash);
+    }
+
+    // Polygons and lines update their points and axes lazily, which isn't safe to do
+    // from several threads at once. Cleaning them forces them to update here instead.
+    ColliderCollection* colliders = spatial_hash_all(hash, NULL);
+    Collider* collider;
+
+    if (colliders->using_set) {
+        set_iter_start(colliders->set, collider) {
+            collider_clean(collider);
+        }
+        set_iter_end
+    } else {
+        list_iter_start(colliders->list, collider) {
+            collider_clean(collider);
+        }
+        list_iter_end
+    }
+}
+
+SOREN_EXPORT bool spatial_query_for_each_broadphase_rectf(SpatialQueryContext* query, SpatialHash* hash, RectF rect, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_broadphase_rectf(hash->tree, rect, ctx, visitor);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .concurrent = true };
+    return spatial_hash_for_each_impl(hash, rect, &visit);
+}
+
+SOREN_EXPORT bool spatial_query_for_each_vector(SpatialQueryContext* query, SpatialHash* hash, Vector position, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_vector(hash->tree, position, ctx, visitor);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .filter = spatial_hash_filter_vector, .position = position, .concurrent = true };
+    return spatial_hash_for_each_impl(hash, vector_to_rectf(position), &visit);
+}
+
+SOREN_EXPORT bool spatial_query_for_each_rectf(SpatialQueryContext* query, SpatialHash* hash, RectF bounds, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_rectf(hash->tree, bounds, ctx, visitor);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .filter = spatial_hash_filter_rectf, .bounds = bounds, .concurrent = true };
+    return spatial_hash_for_each_impl(hash, bounds, &visit);
+}
+
+SOREN_EXPORT bool spatial_query_for_each_collider(SpatialQueryContext* query, SpatialHash* hash, Collider* collider, void* ctx, ColliderVisitor visitor) {
+    if (hash->tree) {
+        return aabb_tree_for_each_collider(hash->tree, collider, ctx, visitor);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    SpatialHashVisit visit = { .visitor = visitor, .ctx = ctx, .filter = spatial_hash_filter_collider, .collider = collider, .concurrent = true };
+    return spatial_hash_for_each_impl(hash, collider_bounds(collider), &visit);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_query_collisions_vector(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    ColliderCollection* results,
+    Vector position,
+    void* ctx,
+    ColliderVectorTest test)
+{
+    results = spatial_query_results(query, results);
+
+    if (hash->tree) {
+        return aabb_tree_collisions_vector_ext(hash->tree, results, position, ctx, test);
+    }
+
+    SpatialHashCollect collect = { .results = results, .position = position, .ctx = ctx, .vector_test = test };
+    spatial_query_for_each_vector(query, hash, position, &collect, spatial_hash_collect_vector);
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* spatial_query_collisions_rectf(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    ColliderCollection* results,
+    RectF bounds,
+    void* ctx,
+    ColliderRectFTest test)
+{
+    results = spatial_query_results(query, results);
+
+    if (hash->tree) {
+        return aabb_tree_collisions_rectf_ext(hash->tree, results, bounds, ctx, test);
+    }
+
+    SpatialHashCollect collect = { .results = results, .bounds = bounds, .ctx = ctx, .rectf_test = test };
+    spatial_query_for_each_rectf(query, hash, bounds, &collect, spatial_hash_collect_rectf);
+
+    return results;
+}
+
+SOREN_EXPORT ColliderCollection* spatial_query_collisions_collider(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    ColliderCollection* results,
+    Collider* collider,
+    void* ctx,
+    ColliderColliderTest test)
+{
+    results = spatial_query_results(query, results);
+
+    if (hash->tree) {
+        return aabb_tree_collisions_collider_ext(hash->tree, results, collider, ctx, test);
+    }
+
+    SpatialHashCollect collect = { .results = results, .collider = collider, .ctx = ctx, .collider_test = test };
+    spatial_query_for_each_collider(query, hash, collider, &collect, spatial_hash_collect_collider);
+
+    return results;
+}
+
+SOREN_EXPORT Collider* spatial_query_linecast_first(SpatialQueryContext* query, SpatialHash* hash, Vector start, Vector end, RaycastHit* out_hit) {
+    if (hash->tree) {
+        return aabb_tree_linecast_first(hash->tree, start, end, out_hit);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    if (vector_equals(start, end)) {
+        return NULL;
+    }
+
+    return spatial_hash_linecast_impl(hash, start, end, NULL, out_hit, true);
+}
+
+SOREN_EXPORT ColliderCollection* spatial_query_linecast_all(SpatialQueryContext* query, SpatialHash* hash, ColliderCollection* results, Vector start, Vector end) {
+    results = spatial_query_results(query, results);
+
+    if (hash->tree) {
+        return aabb_tree_linecast_all(hash->tree, results, start, end);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    if (!vector_equals(start, end)) {
+        spatial_hash_linecast_impl(hash, start, end, results, NULL, true);
+    }
+
+    return results;
+}
+
+SOREN_EXPORT int spatial_query_k_nearest(
+    SpatialQueryContext* query,
+    SpatialHash* hash,
+    Vector point,
+    float max_distance,
+    int k,
+    Collider** out_colliders,
+    float* out_distances,
+    void* ctx,
+    ColliderPredicate predicate)
+{
+    if (k <= 0) {
+        return 0;
+    }
+
+    if (!out_distances) {
+        if (k > query->nearest_scratch_capacity) {
+            query->nearest_scratch_capacity = k;
+            query->nearest_scratch = soren_realloc(query->nearest_scratch, k * sizeof(*query->nearest_scratch));
+        }
+
+        out_distances = query->nearest_scratch;
+    }
+
+    if (hash->tree) {
+        return aabb_tree_k_nearest(hash->tree, point, max_distance, k, out_colliders, out_distances, ctx, predicate);
+    }
+
+    soren_assert(!hash->static_dirty);
+
+    NearestColliders nearest = {
+        .colliders = out_colliders,
+        .distances = out_distances,
+        .capacity = k,
+        .count = 0,
+        .max_distance = max_distance
+    };
+
+    spatial_hash_nearest_impl(hash, point, &nearest, ctx, predicate, true);
+    return nearest.count;
+}
@@ -0,0 +1,119 @@
+#include <collisions/soren_spatial_hash.h>
+
+#include <generic_list.h>
+
+typedef enum SpatialHashChangeType {
+    SPATIAL_HASH_CHANGE_ADD,
+    SPATIAL_HASH_CHANGE_REMOVE,
+    SPATIAL_HASH_CHANGE_UPDATE,
+    SPATIAL_HASH_CHANGE_ADD_STATIC,
+    SPATIAL_HASH_CHANGE_REMOVE_STATIC,
+    SPATIAL_HASH_CHANGE_CLEAR
+} SpatialHashChangeType;
+
+typedef struct SpatialHashChange {
+    Collider* collider;
+    SpatialHashChangeType type;
+} SpatialHashChange;
+
+LIST_DEFINE_H(SpatialHashChangeList, spatial_hash_change_list, SpatialHashChange)
+LIST_DEFINE_C(SpatialHashChangeList, spatial_hash_change_list, SpatialHashChange)
+
+struct SpatialHashDoubleBuffer {
+    SpatialHash* front;
+    SpatialHash* back;
+    // The changes made to the back hash since the last swap.
+    SpatialHashChangeList* changes;
+};
+
+static void spatial_hash_change_apply(SpatialHash* hash, SpatialHashChange change) {
+    switch (change.type) {
+        case SPATIAL_HASH_CHANGE_ADD:
+            spatial_hash_add(hash, change.collider);
+            break;
+        case SPATIAL_HASH_CHANGE_REMOVE:
+            spatial_hash_remove(hash, change.collider);
+            break;
+        case SPATIAL_HASH_CHANGE_UPDATE:
+            spatial_hash_update(hash, change.collider);
+            break;
+        case SPATIAL_HASH_CHANGE_ADD_STATIC:
+            spatial_hash_add_static(hash, change.collider);
+            break;
+        case SPATIAL_HASH_CHANGE_REMOVE_STATIC:
+            spatial_hash_remove_static(hash, change.collider);
+            break;
+        case SPATIAL_HASH_CHANGE_CLEAR:
+            spatial_hash_clear(hash);
+            break;
+    }
+}
+
+static void spatial_hash_double_buffer_record(SpatialHashDoubleBuffer* buffer, Collider* collider, SpatialHashChangeType type) {
+    SpatialHashChange change = (SpatialHashChange){ collider, type };
+    spatial_hash_change_apply(buffer->back, change);
+    spatial_hash_change_list_add(buffer->changes, change);
+}
+
+SOREN_EXPORT SpatialHashDoubleBuffer* spatial_hash_double_buffer_create(SpatialHash* first, SpatialHash* second) {
+    SpatialHashDoubleBuffer* buffer = soren_malloc(sizeof(*buffer));
+    buffer->front = first;
+    buffer->back = second;
+    buffer->changes = spatial_hash_change_list_create();
+
+    return buffer;
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_free(SpatialHashDoubleBuffer* buffer) {
+    spatial_hash_free(buffer->front);
+    spatial_hash_free(buffer->back);
+    spatial_hash_change_list_free(buffer->changes);
+    soren_free(buffer);
+}
+
+SOREN_EXPORT SpatialHash* spatial_hash_double_buffer_front(SpatialHashDoubleBuffer* buffer) {
+    return buffer->front;
+}
+
+SOREN_EXPORT SpatialHash* spatial_hash_double_buffer_back(SpatialHashDoubleBuffer* buffer) {
+    return buffer->back;
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_add(SpatialHashDoubleBuffer* buffer, Collider* collider) {
+    spatial_hash_double_buffer_record(buffer, collider, SPATIAL_HASH_CHANGE_ADD);
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_remove(SpatialHashDoubleBuffer* buffer, Collider* collider) {
+    spatial_hash_double_buffer_record(buffer, collider, SPATIAL_HASH_CHANGE_REMOVE);
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_update(SpatialHashDoubleBuffer* buffer, Collider* collider) {
+    spatial_hash_double_buffer_record(buffer, collider, SPATIAL_HASH_CHANGE_UPDATE);
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_add_static(SpatialHashDoubleBuffer* buffer, Collider* collider) {
+    spatial_hash_double_buffer_record(buffer, collider, SPATIAL_HASH_CHANGE_ADD_STATIC);
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_remove_static(SpatialHashDoubleBuffer* buffer, Collider* collider) {
+    spatial_hash_double_buffer_record(buffer, collider, SPATIAL_HASH_CHANGE_REMOVE_STATIC);
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_clear(SpatialHashDoubleBuffer* buffer) {
+    spatial_hash_double_buffer_record(buffer, NULL, SPATIAL_HASH_CHANGE_CLEAR);
+}
+
+SOREN_EXPORT void spatial_hash_double_buffer_swap(SpatialHashDoubleBuffer* buffer) {
+    SpatialHash* front = buffer->back;
+    buffer->back = buffer->front;
+    buffer->front = front;
+
+    int count = spatial_hash_change_list_count(buffer->changes);
+    for (int i = 0; i < count; i++) {
+        spatial_hash_change_apply(buffer->back, spatial_hash_change_list_get(buffer->changes, i));
+    }
+
+    spatial_hash_change_list_clear(buffer->changes);
+    spatial_hash_bake_static(buffer->back);
+    spatial_hash_prepare_queries(buffer->front);
+}
@@ -0,0 +1,242 @@
+#include <collisions/soren_sweep_and_prune.h>
+
+#include <generic_map.h>
+
+#define SWEEP_AND_PRUNE_NULL_PROXY -1
+
+MAP_DEFINE_H(ColliderProxyMap, collider_proxy_map, Collider*, int)
+MAP_DEFINE_C(ColliderProxyMap, collider_proxy_map, Collider*, int, gds_pointer_hash, gds_pointer_compare)
+
+typedef struct SapEndpoint {
+    float value;
+    int proxy;
+    bool is_max;
+} SapEndpoint;
+
+typedef struct SapProxy {
+    Collider* collider;
+    RectF bounds;
+    // While sweeping, the index of the proxy in the active array.
+    // While free, the index of the next free proxy.
+    union {
+        int active_index;
+        int next;
+    };
+} SapProxy;
+
+struct SweepAndPrune {
+    SapProxy* proxies;
+    SapEndpoint* endpoints;
+    int* active;
+    int proxies_capacity;
+    int endpoints_count;
+    int free_list;
+    // Set when colliders have been appended to the end of the endpoints
+    // since they were last sorted.
+    bool unsorted;
+    ColliderProxyMap* colliders;
+};
+
+static void sweep_and_prune_grow(SweepAndPrune* sap, int capacity) {
+    sap->proxies = soren_realloc(sap->proxies, capacity * sizeof(*sap->proxies));
+    sap->endpoints = soren_realloc(sap->endpoints, capacity * 2 * sizeof(*sap->endpoints));
+    sap->active = soren_realloc(sap->active, capacity * sizeof(*sap->active));
+
+    for (int i = sap->proxies_capacity; i < capacity - 1; i++) {
+        sap->proxies[i].collider = NULL;
+        sap->proxies[i].next = i + 1;
+    }
+
+    sap->proxies[capacity - 1].collider = NULL;
+    sap->proxies[capacity - 1].next = sap->free_list;
+    sap->free_list = sap->proxies_capacity;
+    sap->proxies_capacity = capacity;
+}
+
+static inline bool sap_endpoint_less(SapEndpoint left, SapEndpoint right) {
+    // Bounds that only touch count as overlapping, so mins are sorted before
+    // maxes with the same value.
+    return left.value < right.value || (left.value == right.value && !left.is_max && right.is_max);
+}
+
+static int sap_endpoint_compare(const void* left, const void* right) {
+    SapEndpoint a = *(const SapEndpoint*)left;
+    SapEndpoint b = *(const SapEndpoint*)right;
+    return sap_endpoint_less(a, b) ? -1 : sap_endpoint_less(b, a) ? 1 : 0;
+}
+
+// The endpoints are almost always nearly sorted from the previous frame,
+// which is the best case for insertion sort. Newly added colliders are
+// appended unsorted, so after adding any the whole array is sorted instead.
+static void sweep_and_prune_sort(SweepAndPrune* sap) {
+    SapEndpoint* endpoints = sap->endpoints;
+
+    if (sap->unsorted) {
+        SDL_qsort(endpoints, sap->endpoints_count, sizeof(*endpoints), sap_endpoint_compare);
+        sap->unsorted = false;
+        return;
+    }
+
+    for (int i = 1; i < sap->endpoints_count; i++) {
+        SapEndpoint endpoint = endpoints[i];
+        int j = i - 1;
+
+        while (j >= 0 && sap_endpoint_less(endpoint, endpoints[j])) {
+            endpoints[j + 1] = endpoints[j];
+            j--;
+        }
+
+        endpoints[j + 1] = endpoint;
+    }
+}
+
+SOREN_EXPORT SweepAndPrune* sweep_and_prune_create(void) {
+    SweepAndPrune* sap = soren_malloc(sizeof(*sap));
+    sap->proxies = NULL;
+    sap->endpoints = NULL;
+    sap->active = NULL;
+    sap->proxies_capacity = 0;
+    sap->endpoints_count = 0;
+    sap->free_list = SWEEP_AND_PRUNE_NULL_PROXY;
+    sap->unsorted = false;
+    sap->colliders = collider_proxy_map_create();
+
+    sweep_and_prune_grow(sap, 16);
+
+    return sap;
+}
+
+SOREN_EXPORT void sweep_and_prune_free(SweepAndPrune* sap) {
+    soren_free(sap->proxies);
+    soren_free(sap->endpoints);
+    soren_free(sap->active);
+    collider_proxy_map_free(sap->colliders);
+    soren_free(sap);
+}
+
+SOREN_EXPORT void sweep_and_prune_add(SweepAndPrune* sap, Collider* collider) {
+    int proxy;
+    if (collider_proxy_map_try_get(sap->colliders, collider, &proxy)) {
+        return;
+    }
+
+    if (sap->free_list == SWEEP_AND_PRUNE_NULL_PROXY) {
+        sweep_and_prune_grow(sap, sap->proxies_capacity * 2);
+    }
+
+    proxy = sap->free_list;
+    sap->free_list = sap->proxies[proxy].next;
+
+    RectF bounds = collider_bounds(collider);
+    sap->proxies[proxy].collider = collider;
+    sap->proxies[proxy].bounds = bounds;
+
+    sap->endpoints[sap->endpoints_count++] = (SapEndpoint){ rectf_left(bounds), proxy, false };
+    sap->endpoints[sap->endpoints_count++] = (SapEndpoint){ rectf_right(bounds), proxy, true };
+
+    collider_proxy_map_add(sap->colliders, collider, proxy);
+    sap->unsorted = true;
+}
+
+SOREN_EXPORT void sweep_and_prune_remove(SweepAndPrune* sap, Collider* collider) {
+    int proxy;
+    if (!collider_proxy_map_try_get(sap->colliders, collider, &proxy)) {
+        return;
+    }
+
+    collider_proxy_map_remove(sap->colliders, collider);
+
+    // Removing the endpoints in place keeps the rest of the array sorted.
+    int count = 0;
+    for (int i = 0; i < sap->endpoints_count; i++) {
+        if (sap->endpoints[i].proxy != proxy) {
+            sap->endpoints[count++] = sap->endpoints[i];
+        }
+    }
+
+    sap->endpoints_count = count;
+    sap->proxies[proxy].collider = NULL;
+    sap->proxies[proxy].next = sap->free_list;
+    sap->free_list = proxy;
+}
+
+SOREN_EXPORT void sweep_and_prune_clear(SweepAndPrune* sap) {
+    for (int i = 0; i < sap->proxies_capacity - 1; i++) {
+        sap->proxies[i].collider = NULL;
+        sap->proxies[i].next = i + 1;
+    }
+
+    sap->proxies[sap->proxies_capacity - 1].collider = NULL;
+    sap->proxies[sap->proxies_capacity - 1].next = SWEEP_AND_PRUNE_NULL_PROXY;
+
+    sap->free_list = 0;
+    sap->endpoints_count = 0;
+    sap->unsorted = false;
+    collider_proxy_map_clear(sap->colliders, true);
+}
+
+SOREN_EXPORT int sweep_and_prune_count(SweepAndPrune* sap) {
+    return sap->endpoints_count / 2;
+}
+
+SOREN_EXPORT void sweep_and_prune_update(SweepAndPrune* sap) {
+    for (int i = 0; i < sap->endpoints_count; i++) {
+        SapEndpoint* endpoint = sap->endpoints + i;
+        SapProxy* proxy = sap->proxies + endpoint->proxy;
+
+        // Each collider has two endpoints, so only refresh its bounds once.
+        if (!endpoint->is_max) {
+            proxy->bounds = collider_bounds(proxy->collider);
+            endpoint->value = rectf_left(proxy->bounds);
+        }
+    }
+
+    for (int i = 0; i < sap->endpoints_count; i++) {
+        SapEndpoint* endpoint = sap->endpoints + i;
+        if (endpoint->is_max) {
+            endpoint->value = rectf_right(sap->proxies[endpoint->proxy].bounds);
+        }
+    }
+
+    sweep_and_prune_sort(sap);
+}
+
+SOREN_EXPORT void sweep_and_prune_find_pairs(SweepAndPrune* sap, ColliderPairList* pairs) {
+    int active_count = 0;
+
+    // Colliders added since the last update still use the bounds they were added with.
+    if (sap->unsorted) {
+        sweep_and_prune_sort(sap);
+    }
+
+    for (int i = 0; i < sap->endpoints_count; i++) {
+        SapEndpoint endpoint = sap->endpoints[i];
+        SapProxy* proxy = sap->proxies + endpoint.proxy;
+
+        if (endpoint.is_max) {
+            // Swap the last active proxy into this one's slot.
+            int last = sap->active[--active_count];
+            sap->active[proxy->active_index] = last;
+            sap->proxies[last].active_index = proxy->active_index;
+            continue;
+        }
+
+        // Every active proxy overlaps this one on the x axis,
+        // so only the y axis needs to be checked.
+        float top = rectf_top(proxy->bounds);
+        float bottom = rectf_bottom(proxy->bounds);
+
+        for (int j = 0; j < active_count; j++) {
+            SapProxy* other = sap->proxies + sap->active[j];
+            if (top <= rectf_bottom(other->bounds)
+                && bottom >= rectf_top(other->bounds)
+                && collider_should_collide(other->collider, proxy->collider))
+            {
+                collider_pair_list_add(pairs, (ColliderPair){ other->collider, proxy->collider });
+            }
+        }
+
+        proxy->active_index = active_count;
+        sap->active[active_count++] = endpoint.proxy;
+    }
+}